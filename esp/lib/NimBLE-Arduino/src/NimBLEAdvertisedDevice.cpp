@@ -67,6 +67,9 @@ void NimBLEAdvertisedDevice::update(const ble_gap_event* event, uint8_t eventTyp
 # endif
 
     m_rssi = disc.rssi;
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    m_decryptedData.clear();
+# endif
     if (eventType == BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP && isLegacyAdvertisement()) {
         m_payload.insert(m_payload.end(), disc.data, disc.data + disc.length_data);
         return;
@@ -798,6 +801,37 @@ const std::vector<uint8_t>& NimBLEAdvertisedDevice::getPayload() const {
     return m_payload;
 }
 
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+/**
+ * @brief Does this advertisement have Encrypted Data that was decrypted?
+ * @return True if the scan has a key for the device and at least one Encrypted Data structure authenticated with it.
+ */
+bool NimBLEAdvertisedDevice::haveDecryptedData() const {
+    return !m_decryptedData.empty();
+} // haveDecryptedData
+
+/**
+ * @brief Get the decrypted contents of the Encrypted Data structures of the advertisement.
+ * @return The advertising structures carried in the Encrypted Data, in the order received.
+ * @details Only set when a key for the device was given to NimBLEScan::setEncryptedDataKey.
+ * The data is in the same format as getPayload() and can be parsed with the same tools.
+ */
+const std::vector<uint8_t>& NimBLEAdvertisedDevice::getDecryptedData() const {
+    return m_decryptedData;
+} // getDecryptedData
+# endif
+
+/**
+ * @brief Extract several advertised data types from the payload in a single pass.
+ * @param [in,out] view The view to fill, with the types to extract selected in view->want.
+ * @return True if the payload was parsed without errors.
+ * @details The view points into the payload, so it is only valid until the device is next updated.
+ * This is cheaper than calling several of the getters above, each of which walks the payload again.
+ */
+bool NimBLEAdvertisedDevice::parsePayload(ble_hs_adv_view* view) const {
+    return ble_hs_adv_parse_view(view, m_payload.data(), m_payload.size()) == 0;
+} // parsePayload
+
 /**
  * @brief Get the begin iterator for the payload.
  * @return A read only iterator pointing to the first byte in the payload.
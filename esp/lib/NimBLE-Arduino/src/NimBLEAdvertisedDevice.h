@@ -92,10 +92,15 @@ class NimBLEAdvertisedDevice {
     uint8_t  getPrimaryPhy() const;
     uint8_t  getSecondaryPhy() const;
     uint16_t getPeriodicInterval() const;
+# endif
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    bool                        haveDecryptedData() const;
+    const std::vector<uint8_t>& getDecryptedData() const;
 # endif
     operator NimBLEAddress() const;
 
     const std::vector<uint8_t>&                getPayload() const;
+    bool                                       parsePayload(ble_hs_adv_view* view) const;
     const std::vector<uint8_t>::const_iterator begin() const;
     const std::vector<uint8_t>::const_iterator end() const;
 
@@ -172,6 +177,9 @@ class NimBLEAdvertisedDevice {
 # endif
 
     std::vector<uint8_t> m_payload;
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    std::vector<uint8_t> m_decryptedData{};
+# endif
 };
 
 #endif /* CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_OBSERVER */
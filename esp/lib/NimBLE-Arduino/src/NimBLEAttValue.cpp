@@ -31,24 +31,22 @@ static const char* LOG_TAG = "NimBLEAttValue";
 
 // Default constructor implementation.
 NimBLEAttValue::NimBLEAttValue(uint16_t init_len, uint16_t max_len)
-    : m_attr_value{static_cast<uint8_t*>(calloc(init_len + 1, 1))},
-      m_attr_max_len{std::min<uint16_t>(BLE_ATT_ATTR_MAX_LEN, max_len)},
-      m_attr_len{},
-      m_capacity{init_len}
-# if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
-      ,
-      m_timestamp{}
-# endif
-{
-    NIMBLE_CPP_DEBUG_ASSERT(m_attr_value);
-    if (m_attr_value == nullptr) {
-        NIMBLE_LOGE(LOG_TAG, "Failed to calloc ctx");
+    : m_attr_max_len{std::min<uint16_t>(BLE_ATT_ATTR_MAX_LEN, max_len)} {
+    if (init_len > CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH) {
+        m_attr_value = static_cast<uint8_t*>(calloc(init_len + 1, 1));
+        NIMBLE_CPP_DEBUG_ASSERT(m_attr_value);
+        if (m_attr_value == nullptr) {
+            NIMBLE_LOGE(LOG_TAG, "Failed to calloc ctx");
+            m_attr_value = m_inline;
+            return;
+        }
+        m_capacity = init_len;
     }
 }
 
 // Value constructor implementation.
 NimBLEAttValue::NimBLEAttValue(const uint8_t* value, uint16_t len, uint16_t max_len) : NimBLEAttValue(len, max_len) {
-    if (m_attr_value != nullptr) {
+    if (len > 0 && len <= m_capacity) {
         memcpy(m_attr_value, value, len);
         m_attr_len = len;
     }
@@ -56,7 +54,12 @@ NimBLEAttValue::NimBLEAttValue(const uint8_t* value, uint16_t len, uint16_t max_
 
 // Destructor implementation.
 NimBLEAttValue::~NimBLEAttValue() {
-    if (m_attr_value != nullptr) {
+    release();
+}
+
+// Free the heap buffer, if this value owns one.
+void NimBLEAttValue::release() {
+    if (!m_shared && !isInline()) {
         free(m_attr_value);
     }
 }
@@ -64,18 +67,35 @@ NimBLEAttValue::~NimBLEAttValue() {
 // Move assignment operator implementation.
 NimBLEAttValue& NimBLEAttValue::operator=(NimBLEAttValue&& source) {
     if (this != &source) {
-        free(m_attr_value);
-        m_attr_value   = source.m_attr_value;
-        m_attr_max_len = source.m_attr_max_len;
-        m_attr_len     = source.m_attr_len;
-        m_capacity     = source.m_capacity;
-        setTimeStamp(source.getTimeStamp());
-        source.m_attr_value = nullptr;
+        release();
+        moveFrom(source);
     }
 
     return *this;
 }
 
+// Take over the storage of the source object, leaving it as an empty inline value.
+void NimBLEAttValue::moveFrom(NimBLEAttValue& source) {
+    if (source.isInline()) {
+        memcpy(m_inline, source.m_inline, source.m_attr_len + 1);
+        m_attr_value = m_inline;
+    } else {
+        m_attr_value = source.m_attr_value;
+    }
+
+    m_attr_max_len = source.m_attr_max_len;
+    m_attr_len     = source.m_attr_len;
+    m_capacity     = source.m_capacity;
+    m_shared       = source.m_shared;
+    setTimeStamp(source.getTimeStamp());
+
+    source.m_attr_value = source.m_inline;
+    source.m_attr_len   = 0;
+    source.m_capacity   = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
+    source.m_shared     = false;
+    source.m_inline[0]  = '\0';
+}
+
 // Copy assignment implementation.
 NimBLEAttValue& NimBLEAttValue::operator=(const NimBLEAttValue& source) {
     if (this != &source) {
@@ -84,33 +104,114 @@ NimBLEAttValue& NimBLEAttValue::operator=(const NimBLEAttValue& source) {
     return *this;
 }
 
-// Copy all the data from the source object to this object, including allocated space.
+// Copy all the data from the source object to this object, shared values only copy the reference.
 void NimBLEAttValue::deepCopy(const NimBLEAttValue& source) {
-    uint8_t* res = static_cast<uint8_t*>(realloc(m_attr_value, source.m_capacity + 1));
-    NIMBLE_CPP_DEBUG_ASSERT(res);
-    if (res == nullptr) {
+    if (source.m_shared) {
+        release();
+        ble_npl_hw_enter_critical();
+        m_attr_value   = source.m_attr_value;
+        m_attr_max_len = source.m_attr_max_len;
+        m_attr_len     = source.m_attr_len;
+        m_capacity     = source.m_capacity;
+        m_shared       = true;
+        setTimeStamp(source.getTimeStamp());
+        ble_npl_hw_exit_critical(0);
+        return;
+    }
+
+    if (m_shared) {
+        m_attr_value = m_inline;
+        m_attr_len   = 0;
+        m_capacity   = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
+        m_shared     = false;
+    }
+
+    if (!reserve(source.m_attr_len)) {
         NIMBLE_LOGE(LOG_TAG, "Failed to realloc deepCopy");
         return;
     }
 
     ble_npl_hw_enter_critical();
-    m_attr_value   = res;
     m_attr_max_len = source.m_attr_max_len;
     m_attr_len     = source.m_attr_len;
-    m_capacity     = source.m_capacity;
     setTimeStamp(source.getTimeStamp());
-    memcpy(m_attr_value, source.m_attr_value, m_attr_len + 1);
+    memcpy(m_attr_value, source.m_attr_value, m_attr_len);
+    m_attr_value[m_attr_len] = '\0';
+    ble_npl_hw_exit_critical(0);
+}
+
+// Make sure this value owns a buffer large enough for len bytes plus a null terminator.
+bool NimBLEAttValue::reserve(uint16_t len) {
+    if (!m_shared && len <= m_capacity) {
+        return true;
+    }
+
+    uint8_t* res      = m_inline;
+    uint16_t capacity = CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH;
+    if (len > CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH) {
+        if (m_shared || isInline()) {
+            res = static_cast<uint8_t*>(malloc(len + 1));
+            if (res != nullptr) {
+                memcpy(res, m_attr_value, m_attr_len);
+            }
+        } else {
+            res = static_cast<uint8_t*>(realloc(m_attr_value, len + 1));
+        }
+        capacity = len;
+    } else {
+        memcpy(m_inline, m_attr_value, m_attr_len); // only reached when unsharing a small value
+    }
+
+    NIMBLE_CPP_DEBUG_ASSERT(res);
+    if (res == nullptr) {
+        return false;
+    }
+
+    ble_npl_hw_enter_critical();
+    m_attr_value = res;
+    m_capacity   = capacity;
+    m_shared     = false;
     ble_npl_hw_exit_critical(0);
+    return true;
 }
 
 // Set the value of the attribute.
 bool NimBLEAttValue::setValue(const uint8_t* value, uint16_t len) {
+    if (m_shared) {
+        m_attr_len = 0; // Nothing needs to be preserved when the value is replaced.
+        reserve(0);
+    }
+
     m_attr_len      = 0; // Just set the value length to 0 and append instead of repeating code.
     m_attr_value[0] = '\0'; // Set the first byte to 0 incase the len of the new value is 0.
     append(value, len);
     return memcmp(m_attr_value, value, len) == 0 && m_attr_len == len;
 }
 
+// Refer to an external buffer without copying it.
+bool NimBLEAttValue::setValueShared(const uint8_t* value, uint16_t len) {
+    if (len > m_attr_max_len) {
+        NIMBLE_LOGE(LOG_TAG, "val > max, len=%u, max=%u", len, m_attr_max_len);
+        return false;
+    }
+
+# if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
+    time_t t = time(nullptr);
+# else
+    time_t t = 0;
+# endif
+
+    release();
+    ble_npl_hw_enter_critical();
+    m_attr_value = const_cast<uint8_t*>(value);
+    m_attr_len   = len;
+    m_capacity   = len;
+    m_shared     = true;
+    setTimeStamp(t);
+    ble_npl_hw_exit_critical(0);
+    return true;
+}
+
 // Append the new data, allocate as necessary.
 NimBLEAttValue& NimBLEAttValue::append(const uint8_t* value, uint16_t len) {
     if (len == 0) {
@@ -122,14 +223,8 @@ NimBLEAttValue& NimBLEAttValue::append(const uint8_t* value, uint16_t len) {
         return *this;
     }
 
-    uint8_t* res     = m_attr_value;
     uint16_t new_len = m_attr_len + len;
-    if (new_len > m_capacity) {
-        res        = static_cast<uint8_t*>(realloc(m_attr_value, (new_len + 1)));
-        m_capacity = new_len;
-    }
-    NIMBLE_CPP_DEBUG_ASSERT(res);
-    if (res == nullptr) {
+    if (!reserve(new_len)) {
         NIMBLE_LOGE(LOG_TAG, "Failed to realloc append");
         return *this;
     }
@@ -141,8 +236,7 @@ NimBLEAttValue& NimBLEAttValue::append(const uint8_t* value, uint16_t len) {
 # endif
 
     ble_npl_hw_enter_critical();
-    memcpy(res + m_attr_len, value, len);
-    m_attr_value             = res;
+    memcpy(m_attr_value + m_attr_len, value, len);
     m_attr_len               = new_len;
     m_attr_value[m_attr_len] = '\0';
     setTimeStamp(t);
@@ -26,9 +26,13 @@
 
 # include <string>
 # include <vector>
+# if __cplusplus >= 201703L
+#  include <string_view>
+# endif
 # include <ctime>
 # include <cstring>
 # include <cstdint>
+# include <cstddef>
 
 # ifndef CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
 #  define CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED 0
@@ -46,6 +50,14 @@
 #  error CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH cannot be less than 1; Range = 1 : 512
 # endif
 
+# if !defined(CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH)
+#  define CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH 20
+# elif CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH > BLE_ATT_ATTR_MAX_LEN
+#  error CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH cannot be larger than 512 (BLE_ATT_ATTR_MAX_LEN)
+# elif CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH < 0
+#  error CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH cannot be less than 0; Range = 0 : 512
+# endif
+
 /* Used to determine if the type passed to a template has a data() and size() method. */
 template <typename T, typename = void, typename = void>
 struct Has_data_size : std::false_type {};
@@ -66,18 +78,45 @@ struct Has_c_str_length<T, decltype(void(std::declval<T&>().c_str())), decltype(
  * @brief A specialized container class to hold BLE attribute values.
  * @details This class is designed to be more memory efficient than using\n
  * standard container types for value storage, while being convertible to\n
- * many different container classes.
+ * many different container classes.\n
+ * Values up to CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH bytes are stored inside the\n
+ * object itself and only larger values are allocated on the heap.
  */
 class NimBLEAttValue {
-    uint8_t* m_attr_value{};
+    // First member and over-aligned so inline values are as aligned as heap allocated ones.
+    alignas(alignof(std::max_align_t)) uint8_t m_inline[CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH + 1]{};
+    uint8_t* m_attr_value{m_inline};
     uint16_t m_attr_max_len{};
     uint16_t m_attr_len{};
-    uint16_t m_capacity{};
+    uint16_t m_capacity{CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH};
+    bool     m_shared{false};
 # if CONFIG_NIMBLE_CPP_ATT_VALUE_TIMESTAMP_ENABLED
     time_t m_timestamp{};
 # endif
     void deepCopy(const NimBLEAttValue& source);
 
+    /** @brief Convert to a type this class converts to. */
+    template <typename T>
+    T getValueAs(bool, std::true_type) const {
+        return *this;
+    }
+
+    /** @brief Copy the value into a <type\>, which need not be aligned in the buffer. */
+    template <typename T>
+    T getValueAs(bool skipSizeCheck, std::false_type) const {
+        if (!skipSizeCheck && size() < sizeof(T)) {
+            return T();
+        }
+
+        T value;
+        memcpy(static_cast<void*>(&value), m_attr_value, sizeof(T));
+        return value;
+    }
+
+    void moveFrom(NimBLEAttValue& source);
+    bool reserve(uint16_t len);
+    void release();
+
   public:
     /**
      * @brief Default constructor.
@@ -115,16 +154,26 @@ class NimBLEAttValue {
      * @param str A std::string containing to the initial value to set.
      * @param[in] max_len The max size in bytes that the value can be.
      */
-    NimBLEAttValue(const std::string str, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
-        : NimBLEAttValue(reinterpret_cast<const uint8_t*>(&str[0]), str.length(), max_len) {}
+    NimBLEAttValue(const std::string& str, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
+        : NimBLEAttValue(reinterpret_cast<const uint8_t*>(str.data()), str.length(), max_len) {}
 
     /**
      * @brief Construct with an initial value from a std::vector<uint8_t>.
      * @param vec A std::vector<uint8_t> containing to the initial value to set.
      * @param[in] max_len The max size in bytes that the value can be.
      */
-    NimBLEAttValue(const std::vector<uint8_t> vec, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
-        : NimBLEAttValue(&vec[0], vec.size(), max_len) {}
+    NimBLEAttValue(const std::vector<uint8_t>& vec, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
+        : NimBLEAttValue(vec.data(), vec.size(), max_len) {}
+
+# if __cplusplus >= 201703L
+    /**
+     * @brief Construct with an initial value from a std::string_view.
+     * @param str A std::string_view referring to the initial value to set.
+     * @param[in] max_len The max size in bytes that the value can be.
+     */
+    NimBLEAttValue(std::string_view str, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
+        : NimBLEAttValue(reinterpret_cast<const uint8_t*>(str.data()), str.length(), max_len) {}
+# endif
 
 # ifdef NIMBLE_CPP_ARDUINO_STRING_AVAILABLE
     /**
@@ -132,7 +181,7 @@ class NimBLEAttValue {
      * @param str An Arduino String containing to the initial value to set.
      * @param[in] max_len The max size in bytes that the value can be.
      */
-    NimBLEAttValue(const String str, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
+    NimBLEAttValue(const String& str, uint16_t max_len = BLE_ATT_ATTR_MAX_LEN)
         : NimBLEAttValue(reinterpret_cast<const uint8_t*>(str.c_str()), str.length(), max_len) {}
 # endif
 
@@ -140,7 +189,7 @@ class NimBLEAttValue {
     NimBLEAttValue(const NimBLEAttValue& source) { deepCopy(source); }
 
     /** @brief Move constructor */
-    NimBLEAttValue(NimBLEAttValue&& source) { *this = std::move(source); }
+    NimBLEAttValue(NimBLEAttValue&& source) { moveFrom(source); }
 
     /** @brief Destructor */
     ~NimBLEAttValue();
@@ -157,10 +206,19 @@ class NimBLEAttValue {
     /** @brief Returns the current size of the value in bytes */
     uint16_t size() const { return m_attr_len; }
 
+    /** @brief Returns true if the value is held in the inline buffer rather than on the heap */
+    bool isInline() const { return m_attr_value == m_inline; }
+
+    /** @brief Returns true if the value refers to an external buffer set with setValueShared() */
+    bool isShared() const { return m_shared; }
+
     /** @brief Returns a pointer to the internal buffer of the value */
     const uint8_t* data() const { return m_attr_value; }
 
-    /** @brief Returns a pointer to the internal buffer of the value as a const char* */
+    /**
+     * @brief Returns a pointer to the internal buffer of the value as a const char*
+     * @note A shared value is only null terminated if the external buffer is.
+     */
     const char* c_str() const { return reinterpret_cast<const char*>(m_attr_value); }
 
     /** @brief Iterator begin */
@@ -195,6 +253,18 @@ class NimBLEAttValue {
      */
     bool setValue(const uint8_t* value, uint16_t len);
 
+    /**
+     * @brief Set the value to refer to an external buffer without copying it.
+     * @param[in] value A pointer to a buffer containing the value.
+     * @param[in] len The length of the value in bytes.
+     * @returns True if successful.
+     * @details This is intended for read-mostly values such as constant data in flash.\n
+     * Copies of a shared value refer to the same buffer, so reading or copying it never allocates.\n
+     * The first modification copies the data into storage owned by this value.
+     * @note The buffer must remain valid and unchanged for as long as this value, or any copy of it, refers to it.
+     */
+    bool setValueShared(const uint8_t* value, uint16_t len);
+
     /**
      * @brief Set value to the value of const char*.
      * @param [in] s A pointer to a const char value to set.
@@ -313,14 +383,7 @@ class NimBLEAttValue {
 # endif
         }
 
-        if (std::is_convertible<NimBLEAttValue, T>::value) {
-            return *this;
-        } else {
-            if (!skipSizeCheck && size() < sizeof(T)) {
-                return T();
-            }
-            return *(reinterpret_cast<const T*>(m_attr_value));
-        }
+        return getValueAs<T>(skipSizeCheck, std::is_convertible<NimBLEAttValue, T>{});
     }
 
     /*********************** Operators ************************/
@@ -362,7 +425,7 @@ class NimBLEAttValue {
 
 # ifdef NIMBLE_CPP_ARDUINO_STRING_AVAILABLE
     /** @brief Operator; Get the value as an Arduino String value. */
-    operator String() const { return String(reinterpret_cast<char*>(m_attr_value)); }
+    operator String() const { return String(reinterpret_cast<const char*>(m_attr_value), m_attr_len); }
 # endif
 };
 
@@ -21,6 +21,7 @@
 # include "NimBLECharacteristic.h"
 # include "NimBLE2904.h"
 # include "NimBLEDevice.h"
+# include "NimBLEConnGovernor.h"
 # include "NimBLELog.h"
 
 static NimBLECharacteristicCallbacks defaultCallback;
@@ -284,6 +285,7 @@ bool NimBLECharacteristic::sendValue(const uint8_t* value, size_t length, bool i
                 rc = ble_gattc_indicate_custom(connHandle, m_handle, om);
             }
 
+            NimBLEConnGovernor::recordTraffic(connHandle, length);
             goto done;
         }
 
@@ -301,6 +303,8 @@ bool NimBLECharacteristic::sendValue(const uint8_t* value, size_t length, bool i
             } else {
                 rc = ble_gattc_indicate_custom(ch, m_handle, om);
             }
+
+            NimBLEConnGovernor::recordTraffic(ch, length);
         }
     } else if (connHandle != BLE_HS_CONN_HANDLE_NONE) {
         // Null buffer will read the value from the characteristic
@@ -309,8 +313,15 @@ bool NimBLECharacteristic::sendValue(const uint8_t* value, size_t length, bool i
         } else {
             rc = ble_gattc_indicate_custom(connHandle, m_handle, nullptr);
         }
+
+        NimBLEConnGovernor::recordTraffic(connHandle, getLength());
     } else { // Notify or indicate to all connected peers the characteristic value
         ble_gatts_chr_updated(m_handle);
+        if (NimBLEConnGovernor::isRunning()) { // getPeerDevices() allocates, skip it when nothing is counted.
+            for (const auto& ch : NimBLEDevice::getServer()->getPeerDevices()) {
+                NimBLEConnGovernor::recordTraffic(ch, getLength());
+            }
+        }
     }
 
 done:
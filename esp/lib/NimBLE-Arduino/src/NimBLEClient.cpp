@@ -22,6 +22,8 @@
 # include "NimBLERemoteService.h"
 # include "NimBLERemoteCharacteristic.h"
 # include "NimBLEDevice.h"
+# include "NimBLEConnGovernor.h"
+# include "NimBLELinkOptimizer.h"
 # include "NimBLELog.h"
 
 # if defined(CONFIG_NIMBLE_CPP_IDF)
@@ -31,6 +33,7 @@
 # endif
 
 # include <climits>
+# include <algorithm>
 
 static const char*           LOG_TAG = "NimBLEClient";
 static NimBLEClientCallbacks defaultCallbacks;
@@ -64,6 +67,7 @@ NimBLEClient::NimBLEClient(const NimBLEAddress& peerAddress)
       m_connectTimeout{30000},
       m_pTaskData{nullptr},
       m_svcVec{},
+      m_chrIndex{},
       m_pClientCallbacks{&defaultCallbacks},
       m_connHandle{BLE_HS_CONN_HANDLE_NONE},
       m_terminateFailCount{0},
@@ -100,6 +104,8 @@ NimBLEClient::~NimBLEClient() {
  * @brief Delete all service objects created by this client and clear the vector.
  */
 void NimBLEClient::deleteServices() {
+    clearCharacteristicIndex();
+
     // Delete all the services.
     for (auto& it : m_svcVec) {
         delete it;
@@ -117,8 +123,11 @@ size_t NimBLEClient::deleteService(const NimBLEUUID& uuid) {
     // Delete the requested service.
     for (auto it = m_svcVec.begin(); it != m_svcVec.end(); ++it) {
         if ((*it)->getUUID() == uuid) {
-            delete *it;
+            NimBLERemoteService* pSvc = *it;
+            clearCharacteristicIndex();
             m_svcVec.erase(it);
+            delete pSvc;
+            updateCharacteristicIndex();
             break;
         }
     }
@@ -126,6 +135,37 @@ size_t NimBLEClient::deleteService(const NimBLEUUID& uuid) {
     return m_svcVec.size();
 } // deleteService
 
+/**
+ * @brief Rebuild the handle sorted index of all discovered characteristics.
+ * @details Called whenever characteristics are discovered or deleted so that notifications
+ * and handle lookups can use a binary search instead of walking every service.
+ */
+void NimBLEClient::updateCharacteristicIndex() {
+    std::vector<NimBLERemoteCharacteristic*> index;
+    for (const auto& svc : m_svcVec) {
+        index.insert(index.end(), svc->m_vChars.begin(), svc->m_vChars.end());
+    }
+
+    std::sort(index.begin(), index.end(), [](const NimBLERemoteCharacteristic* a, const NimBLERemoteCharacteristic* b) {
+        return a->getHandle() < b->getHandle();
+    });
+
+    // The host task reads the index when a notification arrives, only swap while it cannot.
+    ble_npl_hw_enter_critical();
+    m_chrIndex.swap(index);
+    ble_npl_hw_exit_critical(0);
+} // updateCharacteristicIndex
+
+/**
+ * @brief Empty the characteristic index before the characteristics it refers to are deleted.
+ */
+void NimBLEClient::clearCharacteristicIndex() {
+    std::vector<NimBLERemoteCharacteristic*> index;
+    ble_npl_hw_enter_critical();
+    m_chrIndex.swap(index);
+    ble_npl_hw_exit_critical(0);
+} // clearCharacteristicIndex
+
 /**
  * @brief Connect to an advertising device.
  * @param [in] pDevice A pointer to the advertised device instance to connect to.
@@ -720,9 +760,65 @@ bool NimBLEClient::discoverAttributes() {
     return true;
 } // discoverAttributes
 
+# if CONFIG_BT_NIMBLE_GATT_CACHING
+/**
+ * @brief A GATT cache entry to remove in the host task, which owns the cache.
+ */
+struct NimBLEGattCacheClear {
+    ble_npl_event   event;
+    ble_addr_t      addr;
+    NimBLETaskData* pTaskData;
+};
+
+/**
+ * @brief Remove a GATT cache entry, runs in the host task.
+ */
+static void clearGattCacheEvent(ble_npl_event* event) {
+    auto pClear = static_cast<NimBLEGattCacheClear*>(ble_npl_event_get_arg(event));
+    NimBLEUtils::taskRelease(*pClear->pTaskData, ble_gattc_cache_conn_undisc_all(pClear->addr));
+} // clearGattCacheEvent
+# endif
+
+/**
+ * @brief Remove the peer's attribute database from the GATT cache.
+ * @details The next service discovery will be performed over the air and the result cached again.
+ * Only has an effect when CONFIG_BT_NIMBLE_GATT_CACHING is enabled.
+ * The cache is cleared by the host task, this blocks until it is done and must not be called from a callback.
+ * @return True if the cache entry was removed, false if not connected or the peer had no cache entry.
+ */
+bool NimBLEClient::clearGattCache() const {
+# if CONFIG_BT_NIMBLE_GATT_CACHING
+    if (!isConnected()) {
+        NIMBLE_LOGE(LOG_TAG, "Disconnected, could not clear GATT cache");
+        return false;
+    }
+
+    NimBLETaskData       taskData;
+    NimBLEGattCacheClear clear{};
+    clear.addr      = *getConnInfo().getIdAddress().getBase();
+    clear.pTaskData = &taskData;
+
+    ble_npl_event_init(&clear.event, clearGattCacheEvent, &clear);
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &clear.event);
+    NimBLEUtils::taskWait(taskData, BLE_NPL_TIME_FOREVER);
+    ble_npl_event_deinit(&clear.event);
+
+    if (taskData.m_flags != 0) {
+        NIMBLE_LOGD(LOG_TAG, "No GATT cache entry to clear; rc=%d", taskData.m_flags);
+        return false;
+    }
+
+    return true;
+# else
+    return false;
+# endif
+} // clearGattCache
+
 /**
  * @brief Ask the remote BLE server for its services.
  * * Here we ask the server for its set of services and wait until we have received them all.
+ * @details With CONFIG_BT_NIMBLE_GATT_CACHING enabled the host answers from its cache once the peer's
+ * Database Hash has been verified (or the bond restored), so reconnects skip discovery over the air.
  * @return true on success otherwise false if an error occurred
  */
 bool NimBLEClient::retrieveServices(const NimBLEUUID* uuidFilter) {
@@ -851,23 +947,499 @@ bool NimBLEClient::setValue(const NimBLEUUID&     serviceUUID,
     return ret;
 } // setValue
 
+/*
+ * Batched reads
+ * -------------
+ * readValues() reads a set of attributes without blocking. Attributes are sent to the peer in groups of
+ * up to BLE_GATT_READ_MAX_ATTRS with a single Read Multiple Variable Length request. Attributes the response
+ * left out, and every attribute when the peer rejects the request, are read one by one. Each of these single
+ * reads fetches one segment; a value that fills it is continued with Read Blob requests for the next
+ * NIMBLE_CPP_READ_WINDOW segments, all sent at once. With EATT the host spreads these requests over the
+ * channels so they are answered in parallel. Segments are written to the value at their offset, so the order
+ * of the responses does not matter. Whether a segment ends the value is judged against the MTU of the bearer
+ * that answered it. Once started, the batch is only touched from the host task. A value whose length cannot
+ * be established is reported as failed, never as a partial success.
+ */
+
+// Read Blob requests in flight for each long value.
+# define NIMBLE_CPP_READ_WINDOW 4
+// Times a value is read again from the start when the peer says it is not long.
+# define NIMBLE_CPP_READ_REREADS 2
+
+struct NimBLEClient::ReadBatch {
+    enum State : uint8_t {
+        GROUPED,    // Waiting for its Read Multiple request to be sent.
+        READ_FIRST, // Needs a read of the first segment.
+        READ_REST,  // Needs the segments after what has been received.
+        BUSY,       // Requests in flight.
+        DONE
+    };
+
+    struct Item;
+    struct Segment {
+        Item*    item;
+        uint16_t offset;
+        uint16_t len;
+        uint16_t mtu; // MTU of the bearer that answered, 0 if unknown.
+        int      rc;
+    };
+
+    struct Item {
+        ReadBatch*                  batch;
+        NimBLERemoteValueAttribute* attr;
+        std::vector<uint8_t>        data;
+        int                         rc;
+        State                       state;
+        uint8_t                     pending; // Segments of the window still in flight.
+        uint8_t                     count;   // Segments in the window.
+        uint8_t                     rereads; // Reads from the start after a Read Blob was refused.
+        Segment                     window[NIMBLE_CPP_READ_WINDOW];
+    };
+
+    struct Group {
+        ReadBatch* batch;
+        size_t     first;
+        uint8_t    count;
+    };
+
+    NimBLEClient*        client;
+    readCompleteCallback callback;
+    std::vector<Item>    items;
+    std::vector<Group>   groups;
+    size_t               nextGroup;
+    uint16_t             connHandle;
+    uint16_t             segLen; // Length of a full segment on the smallest bearer.
+    uint8_t              inflight;
+    bool                 disconnected;
+    ble_npl_event        event;
+
+    static void onStart(ble_npl_event* event);
+    static int  onMultRead(uint16_t connHandle, const ble_gatt_error* error, ble_gatt_attr* attrs, uint8_t numAttrs, void* arg);
+    static int  onSegmentRead(uint16_t connHandle, const ble_gatt_error* error, ble_gatt_attr* attr, void* arg);
+
+    bool pump();
+    int  sendGroup(Group& group);
+    int  sendWindow(Item& item, uint8_t maxSegments);
+    void endWindow(Item& item);
+    void finish(Item& item, int rc);
+    void complete();
+};
+
+/**
+ * @brief Read the values of several remote attributes without blocking.
+ * @param [in] attrs The characteristics and descriptors to read, they must belong to this client.
+ * @param [in] callback The function to call with the result of each read when all have finished.
+ * It is invoked from the NimBLE host task.
+ * @return True if the reads were started, the callback is then always invoked once.
+ * @details Attributes that read successfully have their value updated before the callback is invoked.\n
+ * A read that fails for lack of authentication or encryption is not retried, the application can secure the
+ * connection and read again.
+ * @note The attributes are used until the callback is invoked, so neither the client nor its services may be
+ * deleted before then: do not call deleteServices(), deleteService(), discoverAttributes() or
+ * NimBLEDevice::deleteClient() while reads are pending. Disconnecting is safe, the reads then fail.
+ */
+bool NimBLEClient::readValues(const std::vector<NimBLERemoteValueAttribute*>& attrs, const readCompleteCallback& callback) {
+    NIMBLE_LOGD(LOG_TAG, ">> readValues()");
+
+    if (!isConnected()) {
+        NIMBLE_LOGE(LOG_TAG, "readValues: not connected");
+        return false;
+    }
+
+    if (attrs.empty()) {
+        return false;
+    }
+
+    for (auto attr : attrs) {
+        if (attr == nullptr || attr->getClient() != this) {
+            NIMBLE_LOGE(LOG_TAG, "readValues: attribute does not belong to this client");
+            return false;
+        }
+    }
+
+    auto batch        = new ReadBatch{};
+    batch->client     = this;
+    batch->callback   = callback;
+    batch->connHandle = m_connHandle;
+    batch->items.resize(attrs.size());
+    for (size_t i = 0; i < attrs.size(); i++) {
+        batch->items[i].batch = batch;
+        batch->items[i].attr  = attrs[i];
+        batch->items[i].state = ReadBatch::READ_FIRST;
+    }
+
+# if MYNEWT_VAL(BLE_GATT_READ_MULT_VAR)
+    const size_t groupMax = MYNEWT_VAL(BLE_GATT_READ_MAX_ATTRS);
+    batch->groups.reserve((attrs.size() + groupMax - 1) / groupMax);
+    for (size_t first = 0; first < attrs.size(); first += groupMax) {
+        uint8_t count = std::min(groupMax, attrs.size() - first);
+        if (count < 2) {
+            break;
+        }
+
+        batch->groups.push_back({batch, first, count});
+        for (size_t i = first; i < first + count; i++) {
+            batch->items[i].state = ReadBatch::GROUPED;
+        }
+    }
+# endif
+
+    // Start from the host task so the callbacks never race with the requests being sent.
+    ble_npl_event_init(&batch->event, ReadBatch::onStart, batch);
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &batch->event);
+
+    NIMBLE_LOGD(LOG_TAG, "<< readValues");
+    return true;
+} // readValues
+
+/**
+ * @brief Send the first requests of a batch, runs in the host task.
+ */
+void NimBLEClient::ReadBatch::onStart(ble_npl_event* event) {
+    auto     batch = static_cast<ReadBatch*>(ble_npl_event_get_arg(event));
+    uint16_t mtu   = ble_att_mtu(batch->connHandle);
+
+    batch->disconnected = mtu == 0;
+    batch->segLen       = mtu > 0 ? mtu - 1 : 0;
+# if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+    // Segments may be answered on any bearer, space them for the smallest one. A channel opened later
+    // with a smaller MTU only returns shorter segments, the value is then continued from where they stop.
+    ble_att_bearer_desc bearers[1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM)];
+    int                 count = ble_att_get_bearers(batch->connHandle, bearers, 1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM));
+    for (int i = 1; i < count; i++) {
+        batch->segLen = std::min<uint16_t>(batch->segLen, bearers[i].mtu - 1);
+    }
+# endif
+
+    batch->pump();
+} // onStart
+
+/**
+ * @brief Send what the batch can send and complete it when nothing is left.
+ * @return True if the batch has completed and was deleted.
+ */
+bool NimBLEClient::ReadBatch::pump() {
+    bool full = false;
+
+    while (!full && nextGroup < groups.size() && inflight < CONFIG_BT_NIMBLE_GATT_MAX_PROCS) {
+        int rc = disconnected ? BLE_HS_ENOTCONN : sendGroup(groups[nextGroup]);
+        if (rc == BLE_HS_ENOMEM && inflight > 0) {
+            full = true;
+            break;
+        }
+
+        Group& group = groups[nextGroup++];
+        if (rc != 0) {
+            for (size_t i = group.first; i < group.first + group.count; i++) {
+                if (rc == BLE_HS_ENOTCONN) {
+                    finish(items[i], rc);
+                } else {
+                    items[i].state = READ_FIRST;
+                }
+            }
+        }
+    }
+
+    for (auto& item : items) {
+        if (full || inflight >= CONFIG_BT_NIMBLE_GATT_MAX_PROCS) {
+            break;
+        }
+
+        if (item.state != READ_FIRST && item.state != READ_REST) {
+            continue;
+        }
+
+        int rc = disconnected ? BLE_HS_ENOTCONN : sendWindow(item, item.state == READ_FIRST ? 1 : NIMBLE_CPP_READ_WINDOW);
+        if (rc == BLE_HS_ENOMEM && inflight > 0) {
+            // Out of GATT procedures, send the rest when one of ours completes.
+            full = true;
+        } else if (rc != 0) {
+            finish(item, rc);
+        }
+    }
+
+    if (inflight > 0 || nextGroup < groups.size()) {
+        return false;
+    }
+
+    for (auto& item : items) {
+        if (item.state != DONE) {
+            return false;
+        }
+    }
+
+    complete();
+    return true;
+} // pump
+
+/**
+ * @brief Send a Read Multiple Variable Length request for a group of attributes.
+ * @return 0 on success or the NimBLE error code.
+ */
+int NimBLEClient::ReadBatch::sendGroup(Group& group) {
+    uint16_t handles[MYNEWT_VAL(BLE_GATT_READ_MAX_ATTRS)];
+    for (uint8_t i = 0; i < group.count; i++) {
+        handles[i] = items[group.first + i].attr->getHandle();
+    }
+
+    int rc = ble_gattc_read_mult_var(connHandle, handles, group.count, ReadBatch::onMultRead, &group);
+    if (rc == 0) {
+        inflight++;
+        for (size_t i = group.first; i < group.first + group.count; i++) {
+            items[i].state = BUSY;
+        }
+    }
+
+    return rc;
+} // sendGroup
+
+/**
+ * @brief Send reads for the segments of a value following what has been received.
+ * @param [in] item The attribute to read.
+ * @param [in] maxSegments The number of segments to request at once.
+ * @return 0 if at least one read was sent, otherwise the NimBLE error code.
+ */
+int NimBLEClient::ReadBatch::sendWindow(Item& item, uint8_t maxSegments) {
+    uint16_t offset = item.data.size();
+    int      rc     = 0;
+
+    item.count = 0;
+    while (item.count < maxSegments && inflight < CONFIG_BT_NIMBLE_GATT_MAX_PROCS && offset < BLE_ATT_ATTR_MAX_LEN) {
+        Segment& seg = item.window[item.count];
+        seg          = Segment{&item, offset, 0, 0, 0};
+        rc           = ble_gattc_read_long(connHandle, item.attr->getHandle(), offset, ReadBatch::onSegmentRead, &seg);
+        if (rc != 0) {
+            break;
+        }
+
+        item.count++;
+        item.pending++;
+        inflight++;
+        offset += segLen;
+    }
+
+    if (item.count == 0) {
+        return rc;
+    }
+
+    item.state = BUSY;
+    return 0;
+} // sendWindow
+
+/**
+ * @brief Assemble the segments of a window once all have been answered.
+ * @details The value ends at the first segment shorter than its bearer allows, or at a Read Blob rejected for
+ * its offset. A Read Blob refused because the value is not long means the value fits in a single read on that
+ * bearer, so it ends the value if what was read already fills one. Otherwise the first segment came from a
+ * bearer with a smaller MTU and the value is read again from the start. If that keeps happening the read
+ * fails rather than report a partial value.
+ */
+void NimBLEClient::ReadBatch::endWindow(Item& item) {
+    uint16_t have = item.window[0].offset;
+    bool     end  = false;
+    int      rc   = 0;
+
+    for (uint8_t i = 0; i < item.count; i++) {
+        const Segment& seg = item.window[i];
+        if (seg.offset > have) {
+            break;
+        }
+
+        if (seg.rc == BLE_HS_ATT_ERR(BLE_ATT_ERR_ATTR_NOT_LONG)) {
+            if (seg.mtu > 0 && have >= seg.mtu - 1) {
+                end = true;
+                break;
+            }
+
+            if (item.rereads < NIMBLE_CPP_READ_REREADS) {
+                // What we have came from a cut Read Multiple response or a channel with a smaller MTU,
+                // the whole value fits in a single read.
+                item.rereads++;
+                item.data.clear();
+                item.state = READ_FIRST;
+                return;
+            }
+        }
+
+        if (seg.rc != 0) {
+            if (seg.rc == BLE_HS_ATT_ERR(BLE_ATT_ERR_INVALID_OFFSET)) {
+                end = true;
+            } else {
+                rc = seg.rc;
+            }
+            break;
+        }
+
+        have = std::max<uint16_t>(have, seg.offset + seg.len);
+        if (seg.mtu > 0 && seg.len < seg.mtu - 1) {
+            end = true;
+            break;
+        }
+    }
+
+    item.data.resize(have);
+    if (rc != 0) {
+        finish(item, rc);
+    } else if (end || have >= BLE_ATT_ATTR_MAX_LEN) {
+        finish(item, 0);
+    } else {
+        item.state = READ_REST;
+    }
+} // endWindow
+
+/**
+ * @brief Mark an attribute as read.
+ * @param [in] item The attribute.
+ * @param [in] rc 0 on success or the NimBLE error code of the read.
+ */
+void NimBLEClient::ReadBatch::finish(Item& item, int rc) {
+    if (rc != 0) {
+        NIMBLE_LOGE(LOG_TAG,
+                    "readValues: handle %u failed rc=%d, %s",
+                    item.attr->getHandle(),
+                    rc,
+                    NimBLEUtils::returnCodeToString(rc));
+        item.data.clear();
+    }
+
+    item.rc    = rc;
+    item.state = DONE;
+} // finish
+
+/**
+ * @brief Store the values read, invoke the callback and delete the batch.
+ */
+void NimBLEClient::ReadBatch::complete() {
+    std::vector<ReadResult> results;
+    results.reserve(items.size());
+
+    for (auto& item : items) {
+        if (item.rc == 0) {
+            NimBLEAttValue value(item.data.data(), item.data.size());
+            value.setTimeStamp();
+            item.attr->m_value = value;
+            NimBLEConnGovernor::recordTraffic(connHandle, item.data.size());
+        }
+
+        results.push_back({item.attr, item.rc});
+    }
+
+    if (callback) {
+        callback(client, results);
+    }
+
+    ble_npl_event_deinit(&event);
+    delete this;
+} // complete
+
+/**
+ * @brief Callback for the Read Multiple Variable Length request of a group.
+ * @return 0.
+ */
+int NimBLEClient::ReadBatch::onMultRead(
+    uint16_t connHandle, const ble_gatt_error* error, ble_gatt_attr* attrs, uint8_t numAttrs, void* arg) {
+    auto       group = static_cast<Group*>(arg);
+    ReadBatch* batch = group->batch;
+    int        rc    = error->status;
+
+    batch->inflight--;
+    NIMBLE_LOGD(LOG_TAG, "Read multiple complete; status=%d", rc);
+
+    if (rc != 0) {
+        // Not supported by the peer, or one of the handles failed; read each to get its own status.
+        batch->disconnected |= rc == BLE_HS_ENOTCONN;
+        for (size_t i = group->first; i < group->first + group->count; i++) {
+            if (rc == BLE_HS_ENOTCONN) {
+                batch->finish(batch->items[i], rc);
+            } else {
+                batch->items[i].state = READ_FIRST;
+            }
+        }
+
+        batch->pump();
+        return 0;
+    }
+
+    uint32_t total = 0;
+    Item*    last  = nullptr;
+    for (uint8_t i = 0; i < group->count; i++) {
+        Item& item = batch->items[group->first + i];
+        if (i >= numAttrs || attrs[i].om == nullptr) {
+            // Did not fit in the response.
+            item.state = READ_FIRST;
+            continue;
+        }
+
+        uint16_t len = OS_MBUF_PKTLEN(attrs[i].om);
+        item.data.resize(len);
+        os_mbuf_copydata(attrs[i].om, 0, len, item.data.data());
+        total += 2 + len;
+        last   = &item;
+        batch->finish(item, 0);
+    }
+
+    // A full response may have cut the last value short, read on from where it stopped.
+    uint16_t mtu = ble_gattc_read_bearer_mtu();
+    if (last != nullptr && (mtu == 0 || total + 1 >= mtu)) {
+        last->state = last->data.empty() ? READ_FIRST : READ_REST;
+    }
+
+    batch->pump();
+    return 0;
+} // onMultRead
+
+/**
+ * @brief Callback for the read of one segment of a value.
+ * @return BLE_HS_EDONE to stop the host from reading further segments, the batch requests them itself.
+ */
+int NimBLEClient::ReadBatch::onSegmentRead(uint16_t connHandle, const ble_gatt_error* error, ble_gatt_attr* attr, void* arg) {
+    auto       seg   = static_cast<Segment*>(arg);
+    Item&      item  = *seg->item;
+    ReadBatch* batch = item.batch;
+
+    seg->rc  = error->status;
+    seg->mtu = ble_gattc_read_bearer_mtu();
+    if (seg->rc == 0 && attr != nullptr) {
+        uint16_t len = std::min<uint16_t>(OS_MBUF_PKTLEN(attr->om), BLE_ATT_ATTR_MAX_LEN - seg->offset);
+        if (item.data.size() < seg->offset + len) {
+            item.data.resize(seg->offset + len);
+        }
+
+        os_mbuf_copydata(attr->om, 0, len, item.data.data() + seg->offset);
+        seg->len = len;
+    }
+
+    batch->disconnected |= seg->rc == BLE_HS_ENOTCONN;
+    batch->inflight--;
+    if (--item.pending == 0) {
+        batch->endWindow(item);
+    }
+
+    batch->pump();
+    return BLE_HS_EDONE;
+} // onSegmentRead
+
 /**
  * @brief Get the remote characteristic with the specified handle.
  * @param [in] handle The handle of the desired characteristic.
  * @returns The matching remote characteristic, nullptr otherwise.
  */
 NimBLERemoteCharacteristic* NimBLEClient::getCharacteristic(uint16_t handle) {
-    for (const auto& svc : m_svcVec) {
-        if (svc->getStartHandle() <= handle && handle <= svc->getEndHandle()) {
-            for (const auto& chr : svc->m_vChars) {
-                if (chr->getHandle() == handle) {
-                    return chr;
-                }
-            }
-        }
+    NimBLERemoteCharacteristic* pChr = nullptr;
+
+    ble_npl_hw_enter_critical();
+    auto it = std::lower_bound(m_chrIndex.begin(),
+                               m_chrIndex.end(),
+                               handle,
+                               [](const NimBLERemoteCharacteristic* chr, uint16_t handle) {
+                                   return chr->getHandle() < handle;
+                               });
+    if (it != m_chrIndex.end() && (*it)->getHandle() == handle) {
+        pChr = *it;
     }
+    ble_npl_hw_exit_critical(0);
 
-    return nullptr;
+    return pChr;
 } // getCharacteristic
 
 /**
@@ -878,6 +1450,24 @@ uint16_t NimBLEClient::getMTU() const {
     return ble_att_mtu(m_connHandle);
 } // getMTU
 
+/**
+ * @brief Get the MTU of each ATT bearer of this connection.
+ * @returns The MTU of the unenhanced bearer followed by that of each Enhanced ATT bearer,
+ * empty if not connected.
+ * @details GATT operations are spread over the bearers by the host, an operation sent on an
+ * Enhanced ATT bearer is limited by that bearer's MTU.
+ */
+std::vector<uint16_t> NimBLEClient::getBearerMTUs() const {
+    ble_att_bearer_desc   bearers[1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM)];
+    int                   count = ble_att_get_bearers(m_connHandle, bearers, 1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM));
+    std::vector<uint16_t> mtus;
+    for (int i = 0; i < count; i++) {
+        mtus.push_back(bearers[i].mtu);
+    }
+
+    return mtus;
+} // getBearerMTUs
+
 /**
  * @brief Callback for the MTU exchange API function.
  * @details When the MTU exchange is complete the API will call this and report the new MTU.
@@ -925,6 +1515,9 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event* event, void* arg) {
 
     NIMBLE_LOGD(LOG_TAG, ">> handleGapEvent %s", NimBLEUtils::gapEventToString(event->type));
 
+    NimBLEConnGovernor::handleGapEvent(event);
+    NimBLELinkOptimizer::handleGapEvent(event);
+
     switch (event->type) {
         case BLE_GAP_EVENT_DISCONNECT: {
             // workaround for bug in NimBLE stack where disconnect event argument is not passed correctly
@@ -1028,31 +1621,33 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event* event, void* arg) {
         case BLE_GAP_EVENT_NOTIFY_RX: {
             if (pClient->m_connHandle != event->notify_rx.conn_handle) return 0;
             NIMBLE_LOGD(LOG_TAG, "Notify Received for handle: %d", event->notify_rx.attr_handle);
+            NimBLEConnGovernor::recordTraffic(event->notify_rx.conn_handle, OS_MBUF_PKTLEN(event->notify_rx.om));
 
-            for (const auto& svc : pClient->m_svcVec) {
-                // Dont waste cycles searching services without this handle in its range
-                if (svc->getEndHandle() < event->notify_rx.attr_handle) {
-                    continue;
-                }
-
-                NIMBLE_LOGD(LOG_TAG,
-                            "checking service %s for handle: %d",
-                            svc->getUUID().toString().c_str(),
-                            event->notify_rx.attr_handle);
+            const auto chr = pClient->getCharacteristic(event->notify_rx.attr_handle);
+            if (chr == nullptr) {
+                return 0;
+            }
 
-                for (const auto& chr : svc->m_vChars) {
-                    if (chr->getHandle() == event->notify_rx.attr_handle) {
-                        NIMBLE_LOGD(LOG_TAG, "Got Notification for characteristic %s", chr->toString().c_str());
+            NIMBLE_LOGD(LOG_TAG, "Got Notification for characteristic %s", chr->toString().c_str());
+
+            // Only flatten the data if the controller delivered it in more than one buffer.
+            // Notifications are only dispatched from the host task, so one buffer serves all clients.
+            static uint8_t flat[BLE_ATT_ATTR_MAX_LEN];
+            os_mbuf*       om       = event->notify_rx.om;
+            uint16_t       data_len = OS_MBUF_PKTLEN(om);
+            uint8_t*       data     = om->om_data;
+            if (SLIST_NEXT(om, om_next) != nullptr) {
+                data_len = std::min<uint16_t>(data_len, sizeof(flat));
+                os_mbuf_copydata(om, 0, data_len, flat);
+                data = flat;
+            }
 
-                        uint32_t data_len = OS_MBUF_PKTLEN(event->notify_rx.om);
-                        chr->m_value.setValue(event->notify_rx.om->om_data, data_len);
+            if (chr->m_cacheNotifyValue) {
+                chr->m_value.setValue(data, data_len);
+            }
 
-                        if (chr->m_notifyCallback != nullptr) {
-                            chr->m_notifyCallback(chr, event->notify_rx.om->om_data, data_len, !event->notify_rx.indication);
-                        }
-                        break;
-                    }
-                }
+            if (chr->m_notifyCallback != nullptr) {
+                chr->m_notifyCallback(chr, data, data_len, !event->notify_rx.indication);
             }
 
             return 0;
@@ -1163,6 +1758,21 @@ int NimBLEClient::handleGapEvent(struct ble_gap_event* event, void* arg) {
             break;
         } // BLE_GAP_EVENT_MTU
 
+# if CONFIG_BT_NIMBLE_EATT_CHAN_NUM > 0
+        case BLE_GAP_EVENT_EATT: {
+            if (pClient->m_connHandle != event->eatt.conn_handle) {
+                return 0;
+            }
+
+            NIMBLE_LOGI(LOG_TAG,
+                        "EATT bearer %s: cid=%d",
+                        event->eatt.status == 0 ? "connected" : "disconnected",
+                        event->eatt.cid);
+            rc = 0;
+            break;
+        } // BLE_GAP_EVENT_EATT
+# endif
+
         case BLE_GAP_EVENT_PASSKEY_ACTION: {
             if (pClient->m_connHandle != event->passkey.conn_handle) {
                 return 0;
@@ -32,11 +32,13 @@
 # include <stdint.h>
 # include <vector>
 # include <string>
+# include <functional>
 
 class NimBLEAddress;
 class NimBLEUUID;
 class NimBLERemoteService;
 class NimBLERemoteCharacteristic;
+class NimBLERemoteValueAttribute;
 class NimBLEAdvertisedDevice;
 class NimBLEAttValue;
 class NimBLEClientCallbacks;
@@ -48,6 +50,16 @@ struct NimBLETaskData;
  */
 class NimBLEClient {
   public:
+    /**
+     * @brief The outcome of reading one attribute with readValues().
+     */
+    struct ReadResult {
+        NimBLERemoteValueAttribute* attr; // The attribute, its value is updated when rc is 0.
+        int                         rc;   // 0 on success or the NimBLE error code of the read.
+    };
+
+    typedef std::function<void(NimBLEClient* pClient, const std::vector<ReadResult>& results)> readCompleteCallback;
+
     bool connect(const NimBLEAdvertisedDevice* device,
                  bool                          deleteAttributes = true,
                  bool                          asyncConnect     = false,
@@ -65,11 +77,13 @@ class NimBLEClient {
     std::string    toString() const;
     uint16_t       getConnHandle() const;
     uint16_t       getMTU() const;
+    std::vector<uint16_t> getBearerMTUs() const;
     bool           exchangeMTU();
     bool           secureConnection(bool async = false) const;
     void           setConnectTimeout(uint32_t timeout);
     bool           setDataLen(uint16_t txOctets);
     bool           discoverAttributes();
+    bool           clearGattCache() const;
     NimBLEConnInfo getConnInfo() const;
     int            getLastError() const;
     bool           updateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
@@ -92,6 +106,7 @@ class NimBLEClient {
                             const NimBLEUUID&     characteristicUUID,
                             const NimBLEAttValue& value,
                             bool                  response = false);
+    bool           readValues(const std::vector<NimBLERemoteValueAttribute*>& attrs, const readCompleteCallback& callback);
 
 # if CONFIG_BT_NIMBLE_EXT_ADV
     void setConnectPhy(uint8_t phyMask);
@@ -117,23 +132,27 @@ class NimBLEClient {
     NimBLEClient& operator=(const NimBLEClient&) = delete;
 
     bool       retrieveServices(const NimBLEUUID* uuidFilter = nullptr);
+    void       updateCharacteristicIndex();
+    void       clearCharacteristicIndex();
     static int handleGapEvent(struct ble_gap_event* event, void* arg);
     static int exchangeMTUCb(uint16_t conn_handle, const ble_gatt_error* error, uint16_t mtu, void* arg);
+    struct ReadBatch;
     static int serviceDiscoveredCB(uint16_t                     connHandle,
                                    const struct ble_gatt_error* error,
                                    const struct ble_gatt_svc*   service,
                                    void*                        arg);
 
-    NimBLEAddress                     m_peerAddress;
-    mutable int                       m_lastErr;
-    int32_t                           m_connectTimeout;
-    mutable NimBLETaskData*           m_pTaskData;
-    std::vector<NimBLERemoteService*> m_svcVec;
-    NimBLEClientCallbacks*            m_pClientCallbacks;
-    uint16_t                          m_connHandle;
-    uint8_t                           m_terminateFailCount;
-    mutable uint8_t                   m_asyncSecureAttempt;
-    Config                            m_config;
+    NimBLEAddress                            m_peerAddress;
+    mutable int                              m_lastErr;
+    int32_t                                  m_connectTimeout;
+    mutable NimBLETaskData*                  m_pTaskData;
+    std::vector<NimBLERemoteService*>        m_svcVec;
+    std::vector<NimBLERemoteCharacteristic*> m_chrIndex;
+    NimBLEClientCallbacks*                   m_pClientCallbacks;
+    uint16_t                                 m_connHandle;
+    uint8_t                                  m_terminateFailCount;
+    mutable uint8_t                          m_asyncSecureAttempt;
+    Config                                   m_config;
 
 # if CONFIG_BT_NIMBLE_EXT_ADV
     uint8_t m_phyMask;
@@ -142,6 +161,7 @@ class NimBLEClient {
 
     friend class NimBLEDevice;
     friend class NimBLEServer;
+    friend class NimBLERemoteService;
 }; // class NimBLEClient
 
 /**
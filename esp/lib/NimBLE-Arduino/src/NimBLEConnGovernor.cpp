@@ -0,0 +1,409 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && (defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL) || defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL))
+
+# include "NimBLEConnGovernor.h"
+# include "NimBLELinkOptimizer.h"
+# include "NimBLEUtils.h"
+# include "NimBLELog.h"
+
+# if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "nimble/nimble_port.h"
+# else
+#  include "nimble/porting/nimble/include/nimble/nimble_port.h"
+# endif
+
+static const char*     LOG_TAG = "NimBLEConnGovernor";
+static ble_npl_callout sampleTimer;
+static bool            sampleTimerInit = false;
+
+std::array<NimBLEConnGovernor::Conn, CONFIG_BT_NIMBLE_MAX_CONNECTIONS> NimBLEConnGovernor::m_conns{};
+std::array<NimBLEConnGovernor::Params, 3> NimBLEConnGovernor::m_params{{
+    {80, 160, 4, 600, 0, 0},                      // IDLE: 100-200ms, skip up to 4 events.
+    {24, 40, 0, 400, 0, 0},                       // INTERACTIVE: 30-50ms.
+    {12, 12, 0, 200, 251, BLE_GAP_LE_PHY_2M_MASK} // BULK: 15ms, full data length on 2M PHY.
+}};
+uint32_t NimBLEConnGovernor::m_samplePeriodMs{1000};
+uint32_t NimBLEConnGovernor::m_interactiveBps{64};
+uint32_t NimBLEConnGovernor::m_bulkBps{2048};
+uint8_t  NimBLEConnGovernor::m_hysteresis{3};
+bool     NimBLEConnGovernor::m_running{false};
+
+/**
+ * @brief Start governing the connection parameters of all connections.
+ * @param [in] samplePeriodMs How often, in milliseconds, the traffic rate is evaluated.
+ * @return True if the governor is running.
+ * @note Must be called after NimBLEDevice::init().
+ */
+bool NimBLEConnGovernor::start(uint32_t samplePeriodMs) {
+    if (samplePeriodMs == 0) {
+        NIMBLE_LOGE(LOG_TAG, "Sample period must be greater than 0");
+        return false;
+    }
+
+    if (!sampleTimerInit) {
+        ble_npl_callout_init(&sampleTimer, nimble_port_get_dflt_eventq(), NimBLEConnGovernor::onSample, nullptr);
+        sampleTimerInit = true;
+    }
+
+    m_samplePeriodMs = samplePeriodMs;
+    m_running        = true;
+    ble_npl_callout_reset(&sampleTimer, ble_npl_time_ms_to_ticks32(m_samplePeriodMs));
+    return true;
+} // start
+
+/**
+ * @brief Stop governing connections, the current parameters are left in place.
+ */
+void NimBLEConnGovernor::stop() {
+    m_running = false;
+    if (sampleTimerInit) {
+        ble_npl_callout_stop(&sampleTimer);
+    }
+
+    ble_npl_hw_enter_critical();
+    for (auto& conn : m_conns) {
+        conn = Conn{};
+    }
+    ble_npl_hw_exit_critical(0);
+} // stop
+
+/**
+ * @brief Check if the governor is running.
+ * @return True if running.
+ */
+bool NimBLEConnGovernor::isRunning() {
+    return m_running;
+} // isRunning
+
+/**
+ * @brief Set the link parameters requested for a profile.
+ * @param [in] profile The profile to configure.
+ * @param [in] params The parameters to request when the profile is selected.
+ */
+void NimBLEConnGovernor::setParams(Profile profile, const Params& params) {
+    if (profile > BULK) {
+        return;
+    }
+
+    m_params[profile] = params;
+} // setParams
+
+/**
+ * @brief Set the traffic rates that select each profile.
+ * @param [in] interactiveBytesPerSec Rate at or above which the interactive profile is used.
+ * @param [in] bulkBytesPerSec Rate at or above which the bulk profile is used.
+ * @param [in] hysteresis Number of consecutive sample periods the rate must stay low before a quieter profile is used.
+ */
+void NimBLEConnGovernor::setThresholds(uint32_t interactiveBytesPerSec, uint32_t bulkBytesPerSec, uint8_t hysteresis) {
+    m_interactiveBps = interactiveBytesPerSec;
+    m_bulkBps        = bulkBytesPerSec;
+    m_hysteresis     = hysteresis;
+} // setThresholds
+
+/**
+ * @brief Account for data exchanged on a connection.
+ * @param [in] connHandle The connection the data was sent or received on.
+ * @param [in] bytes The number of payload bytes.
+ * @details Called by the library for GATT and L2CAP traffic, applications may call this for traffic
+ * the library cannot see.
+ */
+void NimBLEConnGovernor::recordTraffic(uint16_t connHandle, size_t bytes) {
+    if (!m_running || connHandle == BLE_HS_CONN_HANDLE_NONE) {
+        return;
+    }
+
+    ble_npl_hw_enter_critical();
+    Conn* pConn = findConn(connHandle);
+    if (pConn == nullptr) {
+        // Adopt connections that were established before the governor was started.
+        pConn = findConn(BLE_HS_CONN_HANDLE_NONE);
+        if (pConn != nullptr) {
+            *pConn                 = Conn{};
+            pConn->connHandle      = connHandle;
+            pConn->state.profile   = INTERACTIVE;
+            pConn->state.requested = INTERACTIVE;
+            pConn->state.txPhy     = BLE_GAP_LE_PHY_1M;
+            pConn->state.rxPhy     = BLE_GAP_LE_PHY_1M;
+            pConn->state.txOctets  = BLE_HCI_SUGG_DEF_DATALEN_TX_OCTETS_MIN;
+        }
+    }
+
+    if (pConn != nullptr) {
+        pConn->bytes += bytes;
+    }
+    ble_npl_hw_exit_critical(0);
+} // recordTraffic
+
+/**
+ * @brief Get the governor state of a connection.
+ * @param [in] connHandle The connection handle.
+ * @param [out] state The current state of the connection.
+ * @return True if the connection is governed and the state was written.
+ */
+bool NimBLEConnGovernor::getLinkState(uint16_t connHandle, LinkState* state) {
+    if (state == nullptr || connHandle == BLE_HS_CONN_HANDLE_NONE) {
+        return false;
+    }
+
+    ble_npl_hw_enter_critical();
+    Conn* pConn = findConn(connHandle);
+    if (pConn != nullptr) {
+        *state = pConn->state;
+    }
+    ble_npl_hw_exit_critical(0);
+    return pConn != nullptr;
+} // getLinkState
+
+/**
+ * @brief Find the entry for a connection handle, must be called in a critical section or from the host task.
+ */
+NimBLEConnGovernor::Conn* NimBLEConnGovernor::findConn(uint16_t connHandle) {
+    for (auto& conn : m_conns) {
+        if (conn.connHandle == connHandle) {
+            return &conn;
+        }
+    }
+
+    return nullptr;
+} // findConn
+
+/**
+ * @brief Update the negotiated connection parameters from the host.
+ * @return False if the connection no longer exists.
+ */
+bool NimBLEConnGovernor::refreshState(Conn& conn) {
+    ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(conn.connHandle, &desc) != 0) {
+        return false;
+    }
+
+    ble_npl_hw_enter_critical();
+    conn.state.interval = desc.conn_itvl;
+    conn.state.latency  = desc.conn_latency;
+    conn.state.timeout  = desc.supervision_timeout;
+    ble_npl_hw_exit_critical(0);
+    return true;
+} // refreshState
+
+/**
+ * @brief Request the parameters of a profile unless the link already satisfies them.
+ * @details The PHY and data length are left alone while NimBLELinkOptimizer is enabled, it already
+ * requests the fastest of both on every connection.
+ */
+void NimBLEConnGovernor::requestProfile(Conn& conn, Profile profile) {
+    const Params& params    = m_params[profile];
+    LinkState&    state     = conn.state;
+    bool          linkOwned = NimBLELinkOptimizer::isEnabled();
+
+    if (!linkOwned && params.txOctets != 0 && params.txOctets > state.txOctets) {
+        int rc = ble_gap_set_data_len(conn.connHandle, params.txOctets, (params.txOctets + 14) * 8);
+        if (rc != 0) {
+            NIMBLE_LOGW(LOG_TAG, "Set data length error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+        }
+    }
+
+    if (!linkOwned && params.phyMask != 0 && (state.txPhy == 0 || !(params.phyMask & (1 << (state.txPhy - 1))))) {
+        int rc = ble_gap_set_prefered_le_phy(conn.connHandle, params.phyMask, params.phyMask, BLE_GAP_LE_PHY_CODED_ANY);
+        if (rc != 0) {
+            NIMBLE_LOGW(LOG_TAG, "Set PHY error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+        }
+    }
+
+    if (state.interval >= params.minInterval && state.interval <= params.maxInterval &&
+        state.latency == params.latency && state.timeout == params.timeout) {
+        ble_npl_hw_enter_critical();
+        state.profile   = profile;
+        state.requested = profile;
+        ble_npl_hw_exit_critical(0);
+        return;
+    }
+
+    ble_gap_upd_params upd = {.itvl_min            = params.minInterval,
+                              .itvl_max            = params.maxInterval,
+                              .latency             = params.latency,
+                              .supervision_timeout = params.timeout,
+                              .min_ce_len          = BLE_GAP_INITIAL_CONN_MIN_CE_LEN,
+                              .max_ce_len          = BLE_GAP_INITIAL_CONN_MAX_CE_LEN};
+
+    int rc = ble_gap_update_params(conn.connHandle, &upd);
+    if (rc == BLE_HS_EALREADY) {
+        return; // An update is already in progress, try again next sample.
+    }
+
+    if (rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Update params error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+        conn.backoff = m_hysteresis;
+        return;
+    }
+
+    NIMBLE_LOGD(LOG_TAG, "conn %d: requesting profile %d", conn.connHandle, profile);
+    ble_npl_hw_enter_critical();
+    state.requested = profile;
+    state.pending   = true;
+    ble_npl_hw_exit_critical(0);
+} // requestProfile
+
+/**
+ * @brief Evaluate the traffic of each connection and select a profile, runs in the host task.
+ */
+void NimBLEConnGovernor::onSample(ble_npl_event* event) {
+    if (!m_running) {
+        return;
+    }
+
+    for (auto& conn : m_conns) {
+        if (conn.connHandle == BLE_HS_CONN_HANDLE_NONE) {
+            continue;
+        }
+
+        if (!refreshState(conn)) {
+            // Traffic was recorded after the disconnect event, drop the stale entry.
+            ble_npl_hw_enter_critical();
+            conn = Conn{};
+            ble_npl_hw_exit_critical(0);
+            continue;
+        }
+
+        ble_npl_hw_enter_critical();
+        uint32_t bytes = conn.bytes;
+        conn.bytes     = 0;
+        ble_npl_hw_exit_critical(0);
+
+        uint32_t rate          = static_cast<uint64_t>(bytes) * 1000 / m_samplePeriodMs;
+        conn.state.bytesPerSec = rate;
+
+        if (conn.backoff > 0) {
+            conn.backoff--;
+            continue;
+        }
+
+        if (conn.state.pending) {
+            continue;
+        }
+
+        Profile target  = rate >= m_bulkBps ? BULK : rate >= m_interactiveBps ? INTERACTIVE : IDLE;
+        Profile current = conn.state.requested;
+        if (target > current) {
+            conn.lowCount = 0;
+            requestProfile(conn, target);
+        } else if (target < current) {
+            if (++conn.lowCount >= m_hysteresis) {
+                conn.lowCount = 0;
+                requestProfile(conn, target);
+            }
+        } else {
+            conn.lowCount = 0;
+        }
+    }
+
+    ble_npl_callout_reset(&sampleTimer, ble_npl_time_ms_to_ticks32(m_samplePeriodMs));
+} // onSample
+
+/**
+ * @brief Track connection events, called by the server and client GAP event handlers.
+ */
+void NimBLEConnGovernor::handleGapEvent(const ble_gap_event* event) {
+    if (!m_running) {
+        return;
+    }
+
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONNECT: {
+            if (event->connect.status != 0) {
+                break;
+            }
+
+            recordTraffic(event->connect.conn_handle, 0);
+            Conn* pConn = findConn(event->connect.conn_handle);
+            if (pConn != nullptr) {
+                refreshState(*pConn);
+                requestProfile(*pConn, INTERACTIVE);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_DISCONNECT: {
+            ble_npl_hw_enter_critical();
+            Conn* pConn = findConn(event->disconnect.conn.conn_handle);
+            if (pConn != nullptr) {
+                *pConn = Conn{};
+            }
+            ble_npl_hw_exit_critical(0);
+            break;
+        }
+
+        case BLE_GAP_EVENT_CONN_UPDATE: {
+            Conn* pConn = findConn(event->conn_update.conn_handle);
+            if (pConn == nullptr) {
+                break;
+            }
+
+            refreshState(*pConn);
+            ble_npl_hw_enter_critical();
+            LinkState& state = pConn->state;
+            if (state.pending) {
+                if (event->conn_update.status == 0) {
+                    state.profile = state.requested;
+                } else {
+                    // The peer refused, keep the current profile and give it time before asking again.
+                    state.rejected++;
+                    state.requested = state.profile;
+                    pConn->backoff  = m_hysteresis * 2;
+                }
+                state.pending = false;
+            }
+            ble_npl_hw_exit_critical(0);
+            NIMBLE_LOGD(LOG_TAG,
+                        "conn %d: params updated, status=%d itvl=%d latency=%d timeout=%d",
+                        pConn->connHandle,
+                        event->conn_update.status,
+                        pConn->state.interval,
+                        pConn->state.latency,
+                        pConn->state.timeout);
+            break;
+        }
+
+        case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE: {
+            Conn* pConn = findConn(event->phy_updated.conn_handle);
+            if (pConn != nullptr && event->phy_updated.status == 0) {
+                ble_npl_hw_enter_critical();
+                pConn->state.txPhy = event->phy_updated.tx_phy;
+                pConn->state.rxPhy = event->phy_updated.rx_phy;
+                ble_npl_hw_exit_critical(0);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_DATA_LEN_CHG: {
+            Conn* pConn = findConn(event->data_len_chg.conn_handle);
+            if (pConn != nullptr) {
+                ble_npl_hw_enter_critical();
+                pConn->state.txOctets = event->data_len_chg.max_tx_octets;
+                ble_npl_hw_exit_critical(0);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+} // handleGapEvent
+
+#endif // CONFIG_BT_ENABLED && (CONFIG_BT_NIMBLE_ROLE_PERIPHERAL || CONFIG_BT_NIMBLE_ROLE_CENTRAL)
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NIMBLE_CPP_CONN_GOVERNOR_H_
+#define NIMBLE_CPP_CONN_GOVERNOR_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && (defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL) || defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL))
+
+# if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "host/ble_gap.h"
+# else
+#  include "nimble/nimble/host/include/host/ble_gap.h"
+# endif
+
+/****  FIX COMPILATION ****/
+# undef min
+# undef max
+/**************************/
+
+# include <array>
+# include <stddef.h>
+
+struct ble_npl_event;
+
+/**
+ * @brief Adapts the connection parameters of each link to the traffic it carries.
+ * @details Bytes sent and received over GATT and L2CAP are counted per connection. Each sample period the
+ * measured rate selects the bulk, interactive or idle parameter set. Moving to a busier profile happens
+ * immediately, dropping to a quieter one only after the rate has stayed low for the hysteresis count.
+ * The governor records whether the peer accepted each request and keeps the parameters actually in use.
+ */
+class NimBLEConnGovernor {
+  public:
+    enum Profile : uint8_t { IDLE = 0, INTERACTIVE, BULK };
+
+    /**
+     * @brief A set of link parameters requested for a profile.
+     */
+    struct Params {
+        uint16_t minInterval; // Minimum connection interval in 1.25ms units.
+        uint16_t maxInterval; // Maximum connection interval in 1.25ms units.
+        uint16_t latency;     // Peripheral latency in connection events.
+        uint16_t timeout;     // Supervision timeout in 10ms units.
+        uint16_t txOctets;    // Preferred data length, 0 to leave unchanged, unused while the link optimizer is on.
+        uint8_t  phyMask;     // Preferred PHY mask (BLE_GAP_LE_PHY_*_MASK), 0 to leave unchanged, likewise.
+    };
+
+    /**
+     * @brief What the governor has requested and what the link is currently using.
+     */
+    struct LinkState {
+        Profile  profile;     // Profile whose parameters are in effect.
+        Profile  requested;   // Profile most recently requested.
+        bool     pending;     // A parameter update request is outstanding.
+        uint8_t  rejected;    // Number of requests the peer has rejected.
+        uint16_t interval;    // Negotiated connection interval in 1.25ms units.
+        uint16_t latency;     // Negotiated peripheral latency.
+        uint16_t timeout;     // Negotiated supervision timeout in 10ms units.
+        uint16_t txOctets;    // Negotiated maximum transmit payload octets.
+        uint8_t  txPhy;       // Transmit PHY in use.
+        uint8_t  rxPhy;       // Receive PHY in use.
+        uint32_t bytesPerSec; // Traffic rate measured in the last sample period.
+    };
+
+    static bool start(uint32_t samplePeriodMs = 1000);
+    static void stop();
+    static bool isRunning();
+    static void setParams(Profile profile, const Params& params);
+    static void setThresholds(uint32_t interactiveBytesPerSec, uint32_t bulkBytesPerSec, uint8_t hysteresis = 3);
+    static void recordTraffic(uint16_t connHandle, size_t bytes);
+    static bool getLinkState(uint16_t connHandle, LinkState* state);
+
+  private:
+    friend class NimBLEServer;
+    friend class NimBLEClient;
+
+    struct Conn {
+        uint16_t  connHandle{BLE_HS_CONN_HANDLE_NONE};
+        uint32_t  bytes{0};
+        uint8_t   lowCount{0};
+        uint8_t   backoff{0};
+        LinkState state{};
+    };
+
+    static void  handleGapEvent(const ble_gap_event* event);
+    static void  onSample(ble_npl_event* event);
+    static void  requestProfile(Conn& conn, Profile profile);
+    static bool  refreshState(Conn& conn);
+    static Conn* findConn(uint16_t connHandle);
+
+    static std::array<Conn, CONFIG_BT_NIMBLE_MAX_CONNECTIONS> m_conns;
+    static std::array<Params, 3>                              m_params;
+    static uint32_t                                           m_samplePeriodMs;
+    static uint32_t                                           m_interactiveBps;
+    static uint32_t                                           m_bulkBps;
+    static uint8_t                                            m_hysteresis;
+    static bool                                               m_running;
+}; // NimBLEConnGovernor
+
+#endif // CONFIG_BT_ENABLED && (CONFIG_BT_NIMBLE_ROLE_PERIPHERAL || CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+#endif // NIMBLE_CPP_CONN_GOVERNOR_H_
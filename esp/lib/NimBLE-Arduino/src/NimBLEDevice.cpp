@@ -75,6 +75,9 @@
 static const char* LOG_TAG = "NimBLEDevice";
 
 extern "C" void ble_store_config_init(void);
+# if defined(ESP_PLATFORM) && MYNEWT_VAL(BLE_STORE_CONFIG_PERSIST)
+extern "C" int ble_store_config_flush(void);
+# endif
 
 /**
  * Singletons for the NimBLEDevice.
@@ -1023,6 +1026,10 @@ bool NimBLEDevice::deinit(bool clearAll) {
     if (m_initialized) {
         rc = nimble_port_stop();
         if (rc == 0) {
+# if defined(ESP_PLATFORM) && MYNEWT_VAL(BLE_STORE_CONFIG_PERSIST)
+            // Write any subscription changes still held in the write-back cache before the host goes away.
+            ble_store_config_flush();
+# endif
             nimble_port_deinit();
 # ifdef CONFIG_NIMBLE_CPP_IDF
 #  if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
@@ -283,6 +283,7 @@ class NimBLEDevice {
 #  include "NimBLERemoteService.h"
 #  include "NimBLERemoteCharacteristic.h"
 #  include "NimBLERemoteDescriptor.h"
+#  include "NimBLEWriteStream.h"
 # endif
 
 # if defined(CONFIG_BT_NIMBLE_ROLE_OBSERVER)
@@ -310,6 +311,8 @@ class NimBLEDevice {
 
 # if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL) || defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL)
 #  include "NimBLEConnInfo.h"
+#  include "NimBLEConnGovernor.h"
+#  include "NimBLELinkOptimizer.h"
 # endif
 
 # include "NimBLEUtils.h"
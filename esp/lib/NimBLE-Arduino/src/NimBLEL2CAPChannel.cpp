@@ -4,6 +4,7 @@
 #include "NimBLEL2CAPChannel.h"
 
 #include "NimBLEClient.h"
+#include "NimBLEConnGovernor.h"
 #include "NimBLELog.h"
 #include "NimBLEUtils.h"
 
@@ -63,6 +64,16 @@ bool NimBLEL2CAPChannel::setupMemPool() {
     return true;
 }
 
+void NimBLEL2CAPChannel::logPoolExhausted() {
+    NIMBLE_LOGE(LOG_TAG,
+                "L2CAP COC 0x%04X out of buffers: %d/%d free, %d min free, %d msys free",
+                psm,
+                os_mempool_num_free(&_coc_mempool),
+                _coc_mempool.mp_num_blocks,
+                _coc_mempool.mp_min_free,
+                os_msys_num_free());
+}
+
 void NimBLEL2CAPChannel::teardownMemPool() {
     if (this->callbacks) {
         delete this->callbacks;
@@ -102,7 +113,7 @@ int NimBLEL2CAPChannel::writeFragment(std::vector<uint8_t>::const_iterator begin
     while (retries--) {
         auto txd = os_mbuf_get_pkthdr(&_coc_mbuf_pool, 0);
         if (!txd) {
-            NIMBLE_LOGE(LOG_TAG, "Can't os_mbuf_get_pkthdr.");
+            logPoolExhausted();
             return -BLE_HS_ENOMEM;
         }
         auto append = os_mbuf_append(txd, &(*begin), toSend);
@@ -115,11 +126,13 @@ int NimBLEL2CAPChannel::writeFragment(std::vector<uint8_t>::const_iterator begin
         switch (res) {
             case 0:
                 NIMBLE_LOGD(LOG_TAG, "L2CAP COC 0x%04X sent %d bytes.", this->psm, toSend);
+                NimBLEConnGovernor::recordTraffic(connHandle, toSend);
                 return 0;
 
             case BLE_HS_ESTALLED:
                 stalled = true;
                 NIMBLE_LOGD(LOG_TAG, "L2CAP COC 0x%04X sent %d bytes.", this->psm, toSend);
+                NimBLEConnGovernor::recordTraffic(connHandle, toSend);
                 NIMBLE_LOGW(LOG_TAG,
                             "ble_l2cap_send returned BLE_HS_ESTALLED. Next send will wait for unstalled event...");
                 return 0;
@@ -194,7 +207,8 @@ bool NimBLEL2CAPChannel::write(const std::vector<uint8_t>& bytes) {
 
 // private
 int NimBLEL2CAPChannel::handleConnectionEvent(struct ble_l2cap_event* event) {
-    channel = event->connect.chan;
+    channel    = event->connect.chan;
+    connHandle = event->connect.conn_handle;
     struct ble_l2cap_chan_info info;
     ble_l2cap_get_chan_info(channel, &info);
     NIMBLE_LOGI(LOG_TAG,
@@ -220,6 +234,9 @@ int NimBLEL2CAPChannel::handleAcceptEvent(struct ble_l2cap_event* event) {
     }
 
     struct os_mbuf* sdu_rx = os_mbuf_get_pkthdr(&_coc_mbuf_pool, 0);
+    if (sdu_rx == NULL) {
+        logPoolExhausted();
+    }
     assert(sdu_rx != NULL);
     ble_l2cap_recv_ready(event->accept.chan, sdu_rx);
     return 0;
@@ -238,6 +255,7 @@ int NimBLEL2CAPChannel::handleDataReceivedEvent(struct ble_l2cap_event* event) {
     assert(res == 0);
 
     NIMBLE_LOGD(LOG_TAG, "L2CAP COC 0x%04X received %d bytes.", psm, rx_len);
+    NimBLEConnGovernor::recordTraffic(connHandle, rx_len);
 
     res = os_mbuf_free_chain(rxd);
     assert(res == 0);
@@ -9,9 +9,11 @@
 
 # include "inttypes.h"
 # if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "host/ble_hs.h"
 #  include "host/ble_l2cap.h"
 #  include "os/os_mbuf.h"
 # else
+#  include "nimble/nimble/host/include/host/ble_hs.h"
 #  include "nimble/nimble/host/include/host/ble_l2cap.h"
 #  include "nimble/porting/nimble/include/os/os_mbuf.h"
 # endif
@@ -74,7 +76,8 @@ class NimBLEL2CAPChannel {
 
     const uint16_t               psm; // PSM of the channel
     const uint16_t               mtu; // The requested (local) MTU of the channel, might be larger than negotiated MTU
-    struct ble_l2cap_chan*       channel = nullptr;
+    struct ble_l2cap_chan*       channel    = nullptr;
+    uint16_t                     connHandle = BLE_HS_CONN_HANDLE_NONE; // Connection the channel belongs to
     NimBLEL2CAPChannelCallbacks* callbacks;
     uint8_t*                     receiveBuffer = nullptr; // buffers a full (local) MTU
 
@@ -90,6 +93,7 @@ class NimBLEL2CAPChannel {
     // Allocate / deallocate NimBLE memory pool
     bool setupMemPool();
     void teardownMemPool();
+    void logPoolExhausted();
 
     // Writes data up to the size of the negotiated MTU to the channel.
     int writeFragment(std::vector<uint8_t>::const_iterator begin, std::vector<uint8_t>::const_iterator end);
@@ -0,0 +1,445 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && (defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL) || defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL))
+
+# include "NimBLELinkOptimizer.h"
+# include "NimBLEUtils.h"
+# include "NimBLELog.h"
+
+# if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "nimble/nimble_port.h"
+# else
+#  include "nimble/porting/nimble/include/nimble/nimble_port.h"
+# endif
+
+# include <vector>
+
+// Inter frame space between packets, in microseconds.
+# define LINK_T_IFS_US 150
+
+// Longest wait for the controller to transmit the calibration data once it has all been queued.
+# define LINK_CALIBRATE_DRAIN_MS 5000
+
+static const char*     LOG_TAG = "NimBLELinkOptimizer";
+static ble_npl_callout settleTimer;
+static bool            settleTimerInit = false;
+
+std::array<NimBLELinkOptimizer::Conn, CONFIG_BT_NIMBLE_MAX_CONNECTIONS> NimBLELinkOptimizer::m_conns{};
+NimBLELinkOptimizer::linkInfoCallback NimBLELinkOptimizer::m_callback{};
+uint32_t                              NimBLELinkOptimizer::m_settleMs{2000};
+bool                                  NimBLELinkOptimizer::m_enabled{false};
+
+/**
+ * @brief Enable or disable link optimization of new connections.
+ * @param [in] enable True to request 2M PHY and maximum data length on every new connection.
+ * @param [in] settleMs How long to wait for the peer to answer before using what the controller reports.
+ * @note Must be called after NimBLEDevice::init().
+ */
+void NimBLELinkOptimizer::enable(bool enable, uint32_t settleMs) {
+    if (!settleTimerInit) {
+        ble_npl_callout_init(&settleTimer, nimble_port_get_dflt_eventq(), NimBLELinkOptimizer::onSettle, nullptr);
+        settleTimerInit = true;
+    }
+
+    m_settleMs = settleMs;
+    m_enabled  = enable;
+    if (!enable) {
+        ble_npl_callout_stop(&settleTimer);
+    }
+} // enable
+
+/**
+ * @brief Check if link optimization is enabled.
+ * @return True if enabled.
+ */
+bool NimBLELinkOptimizer::isEnabled() {
+    return m_enabled;
+} // isEnabled
+
+/**
+ * @brief Set a callback to receive the link information when negotiation completes or the link changes.
+ * @param [in] callback The function to call, it is invoked from the NimBLE host task.
+ */
+void NimBLELinkOptimizer::setCallback(const linkInfoCallback& callback) {
+    m_callback = callback;
+} // setCallback
+
+/**
+ * @brief Request 2M PHY and the maximum data length on a connection.
+ * @param [in] connHandle The connection to optimize.
+ * @return True if the requests were started.
+ * @details Called automatically for new connections when enabled, may be called for existing connections.
+ * While enabled the optimizer owns PHY and data length negotiation, NimBLEConnGovernor then only
+ * adjusts the connection parameters.
+ */
+bool NimBLELinkOptimizer::optimize(uint16_t connHandle) {
+    ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(connHandle, &desc) != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Connection %d not found", connHandle);
+        return false;
+    }
+
+    if (!settleTimerInit) {
+        ble_npl_callout_init(&settleTimer, nimble_port_get_dflt_eventq(), NimBLELinkOptimizer::onSettle, nullptr);
+        settleTimerInit = true;
+    }
+
+    ble_npl_time_t settleTicks = ble_npl_time_ms_to_ticks32(m_settleMs);
+
+    ble_npl_hw_enter_critical();
+    Conn* pConn = findConn(connHandle);
+    if (pConn == nullptr) {
+        pConn = findConn(BLE_HS_CONN_HANDLE_NONE);
+    }
+
+    if (pConn != nullptr) {
+        *pConn               = Conn{};
+        pConn->connHandle    = connHandle;
+        pConn->deadline      = ble_npl_time_get() + settleTicks;
+        pConn->info.txPhy    = BLE_GAP_LE_PHY_1M;
+        pConn->info.rxPhy    = BLE_GAP_LE_PHY_1M;
+        pConn->info.txOctets = BLE_HCI_SUGG_DEF_DATALEN_TX_OCTETS_MIN;
+        pConn->info.rxOctets = BLE_HCI_SUGG_DEF_DATALEN_TX_OCTETS_MIN;
+        pConn->info.interval = desc.conn_itvl;
+    }
+    ble_npl_hw_exit_critical(0);
+
+    if (pConn == nullptr) {
+        NIMBLE_LOGE(LOG_TAG, "No free entry for connection %d", connHandle);
+        return false;
+    }
+
+    int rc = ble_gap_set_prefered_le_phy(connHandle,
+                                         BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_CODED_ANY);
+    if (rc != 0) {
+        NIMBLE_LOGW(LOG_TAG, "Set PHY error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+    }
+
+    uint16_t txOctets = BLE_HCI_SUGG_DEF_DATALEN_TX_OCTETS_MAX;
+    rc                = ble_gap_set_data_len(connHandle, txOctets, (txOctets + 14) * 8);
+    if (rc != 0) {
+        NIMBLE_LOGW(LOG_TAG, "Set data length error: %d, %s", rc, NimBLEUtils::returnCodeToString(rc));
+    }
+
+    ble_npl_callout_reset(&settleTimer, settleTicks);
+    return true;
+} // optimize
+
+/**
+ * @brief Get the negotiated link information of a connection.
+ * @param [in] connHandle The connection handle.
+ * @param [out] info The link information.
+ * @return True if the connection is known to the optimizer and the information was written.
+ */
+bool NimBLELinkOptimizer::getLinkInfo(uint16_t connHandle, LinkInfo* info) {
+    if (info == nullptr || connHandle == BLE_HS_CONN_HANDLE_NONE) {
+        return false;
+    }
+
+    ble_npl_hw_enter_critical();
+    Conn* pConn = findConn(connHandle);
+    if (pConn != nullptr) {
+        *info = pConn->info;
+    }
+    ble_npl_hw_exit_critical(0);
+    return pConn != nullptr;
+} // getLinkInfo
+
+/**
+ * @brief Measure the throughput of a connection with a short transfer.
+ * @param [in] connHandle The connection being measured.
+ * @param [in] send A function that sends data to the peer and returns once it has been queued, e.g.
+ * NimBLEL2CAPChannel::write or NimBLECharacteristic::notify. The peer must discard the data.
+ * @param [in] totalBytes The number of bytes to send.
+ * @param [in] chunkSize The number of bytes passed to each call of send.
+ * @return The measured throughput in bytes per second, 0 on failure.
+ * @details The transfer is timed until the controller reports every packet of the connection as
+ * transmitted, not until the last call to send returns, so data waiting in the host is not counted as sent.
+ * @note Blocks until the transfer completes, must not be called from the NimBLE host task.
+ */
+uint32_t NimBLELinkOptimizer::calibrate(uint16_t            connHandle,
+                                        const sendFunction& send,
+                                        size_t              totalBytes,
+                                        size_t              chunkSize) {
+    if (!send || totalBytes == 0 || chunkSize == 0) {
+        return 0;
+    }
+
+    LinkInfo info;
+    if (!getLinkInfo(connHandle, &info)) {
+        NIMBLE_LOGE(LOG_TAG, "Connection %d is not optimized, cannot calibrate", connHandle);
+        return 0;
+    }
+
+    std::vector<uint8_t> chunk(chunkSize, 0);
+    size_t               sent  = 0;
+    ble_npl_time_t       start = ble_npl_time_get();
+    while (sent < totalBytes) {
+        size_t len = totalBytes - sent < chunkSize ? totalBytes - sent : chunkSize;
+        if (!send(chunk.data(), len)) {
+            NIMBLE_LOGE(LOG_TAG, "Calibration send failed after %u bytes", static_cast<unsigned>(sent));
+            return 0;
+        }
+        sent += len;
+    }
+
+    // Wait for the controller to transmit what the host still holds for the connection.
+    ble_npl_time_t drainStart = ble_npl_time_get();
+    ble_npl_time_t drainTicks = ble_npl_time_ms_to_ticks32(LINK_CALIBRATE_DRAIN_MS);
+    for (;;) {
+        ble_hs_conn_tx_state state;
+        if (ble_hs_conn_get_tx_state(connHandle, &state) != 0) {
+            NIMBLE_LOGE(LOG_TAG, "Connection %d lost during calibration", connHandle);
+            return 0;
+        }
+
+        if (state.outstanding + state.queued == 0) {
+            break;
+        }
+
+        if (ble_npl_time_get() - drainStart >= drainTicks) {
+            NIMBLE_LOGE(LOG_TAG, "Calibration data not transmitted, %d packets left", state.outstanding + state.queued);
+            return 0;
+        }
+
+        ble_npl_time_delay(1);
+    }
+
+    uint32_t elapsedMs = ble_npl_time_ticks_to_ms32(ble_npl_time_get() - start);
+    if (elapsedMs == 0) {
+        elapsedMs = 1;
+    }
+
+    uint32_t bps = static_cast<uint64_t>(sent) * 1000 / elapsedMs;
+    ble_npl_hw_enter_critical();
+    Conn* pConn = findConn(connHandle);
+    if (pConn != nullptr) {
+        pConn->info.measuredBps = bps;
+    }
+    ble_npl_hw_exit_critical(0);
+
+    NIMBLE_LOGI(LOG_TAG,
+                "Calibrated conn %d: %u bytes in %" PRIu32 "ms, %" PRIu32 " B/s",
+                connHandle,
+                static_cast<unsigned>(sent),
+                elapsedMs,
+                bps);
+    return bps;
+} // calibrate
+
+/**
+ * @brief Find the entry for a connection handle, must be called in a critical section or from the host task.
+ */
+NimBLELinkOptimizer::Conn* NimBLELinkOptimizer::findConn(uint16_t connHandle) {
+    for (auto& conn : m_conns) {
+        if (conn.connHandle == connHandle) {
+            return &conn;
+        }
+    }
+
+    return nullptr;
+} // findConn
+
+/**
+ * @brief Estimate the one way throughput of a link in bytes per second.
+ * @details Assumes the sender fills every connection event with full length packets, each acknowledged by an
+ * empty packet from the peer.
+ */
+uint32_t NimBLELinkOptimizer::estimateThroughput(const LinkInfo& info, bool encrypted) {
+    if (info.interval == 0 || info.txOctets == 0) {
+        return 0;
+    }
+
+    // Air time in microseconds of a packet with the given header + payload + MIC + CRC length.
+    auto airTime = [](uint8_t phy, uint32_t pduLen) -> uint32_t {
+        switch (phy) {
+            case BLE_GAP_LE_PHY_2M:
+                return (2 + 4 + pduLen) * 4; // 2 byte preamble, access address, 4us per byte.
+            case BLE_GAP_LE_PHY_CODED:
+                return 376 + pduLen * 64; // Preamble, access address, CI and TERM1 at S8, then 64us per byte.
+            default:
+                return (1 + 4 + pduLen) * 8; // 1 byte preamble, access address, 8us per byte.
+        }
+    };
+
+    uint32_t dataUs     = airTime(info.txPhy, 2 + info.txOctets + (encrypted ? 4 : 0) + 3);
+    uint32_t ackUs      = airTime(info.rxPhy, 2 + 3);
+    uint32_t cycleUs    = dataUs + LINK_T_IFS_US + ackUs + LINK_T_IFS_US;
+    uint32_t intervalUs = info.interval * 1250;
+    uint32_t packets    = intervalUs / cycleUs;
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    return static_cast<uint64_t>(packets) * info.txOctets * 1000000 / intervalUs;
+} // estimateThroughput
+
+/**
+ * @brief Refresh the connection interval, compute the throughput estimate and publish the result.
+ */
+void NimBLELinkOptimizer::finish(Conn& conn) {
+    ble_gap_conn_desc desc;
+    bool              encrypted = false;
+    if (ble_gap_conn_find(conn.connHandle, &desc) == 0) {
+        encrypted = desc.sec_state.encrypted;
+        ble_npl_hw_enter_critical();
+        conn.info.interval = desc.conn_itvl;
+        ble_npl_hw_exit_critical(0);
+    }
+
+    ble_npl_hw_enter_critical();
+    conn.info.estimatedBps = estimateThroughput(conn.info, encrypted);
+    conn.info.complete     = true;
+    ble_npl_hw_exit_critical(0);
+
+    NIMBLE_LOGI(LOG_TAG,
+                "conn %d: phy %d/%d, data len %d/%d, itvl %d, ~%" PRIu32 " B/s",
+                conn.connHandle,
+                conn.info.txPhy,
+                conn.info.rxPhy,
+                conn.info.txOctets,
+                conn.info.rxOctets,
+                conn.info.interval,
+                conn.info.estimatedBps);
+    publish(conn);
+} // finish
+
+/**
+ * @brief Deliver the link information to the application callback.
+ */
+void NimBLELinkOptimizer::publish(Conn& conn) {
+    if (m_callback) {
+        LinkInfo info = conn.info;
+        m_callback(conn.connHandle, info);
+    }
+} // publish
+
+/**
+ * @brief Complete the negotiation of connections whose peer did not answer in time, runs in the host task.
+ */
+void NimBLELinkOptimizer::onSettle(ble_npl_event* event) {
+    ble_npl_time_t now     = ble_npl_time_get();
+    ble_npl_time_t nextDue = 0;
+    bool           rearm   = false;
+
+    for (auto& conn : m_conns) {
+        if (conn.connHandle == BLE_HS_CONN_HANDLE_NONE || conn.info.complete) {
+            continue;
+        }
+
+        int32_t remaining = static_cast<int32_t>(conn.deadline - now);
+        if (remaining > 0) {
+            if (!rearm || static_cast<ble_npl_time_t>(remaining) < nextDue) {
+                nextDue = remaining;
+                rearm   = true;
+            }
+            continue;
+        }
+
+        uint8_t txPhy;
+        uint8_t rxPhy;
+        if (ble_gap_read_le_phy(conn.connHandle, &txPhy, &rxPhy) == 0) {
+            ble_npl_hw_enter_critical();
+            conn.info.txPhy = txPhy;
+            conn.info.rxPhy = rxPhy;
+            ble_npl_hw_exit_critical(0);
+        }
+
+        finish(conn);
+    }
+
+    if (rearm) {
+        ble_npl_callout_reset(&settleTimer, nextDue);
+    }
+} // onSettle
+
+/**
+ * @brief Track PHY and data length changes, called by the server and client GAP event handlers.
+ */
+void NimBLELinkOptimizer::handleGapEvent(const ble_gap_event* event) {
+    switch (event->type) {
+        case BLE_GAP_EVENT_CONNECT: {
+            if (m_enabled && event->connect.status == 0) {
+                optimize(event->connect.conn_handle);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_DISCONNECT: {
+            ble_npl_hw_enter_critical();
+            Conn* pConn = findConn(event->disconnect.conn.conn_handle);
+            if (pConn != nullptr) {
+                *pConn = Conn{};
+            }
+            ble_npl_hw_exit_critical(0);
+            break;
+        }
+
+        case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE: {
+            Conn* pConn = findConn(event->phy_updated.conn_handle);
+            if (pConn == nullptr || event->phy_updated.status != 0) {
+                break;
+            }
+
+            ble_npl_hw_enter_critical();
+            pConn->info.txPhy        = event->phy_updated.tx_phy;
+            pConn->info.rxPhy        = event->phy_updated.rx_phy;
+            pConn->info.phyConfirmed = true;
+            ble_npl_hw_exit_critical(0);
+
+            if (pConn->info.complete || pConn->info.dataLenConfirmed) {
+                finish(*pConn);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_DATA_LEN_CHG: {
+            Conn* pConn = findConn(event->data_len_chg.conn_handle);
+            if (pConn == nullptr) {
+                break;
+            }
+
+            ble_npl_hw_enter_critical();
+            pConn->info.txOctets         = event->data_len_chg.max_tx_octets;
+            pConn->info.rxOctets         = event->data_len_chg.max_rx_octets;
+            pConn->info.dataLenConfirmed = true;
+            ble_npl_hw_exit_critical(0);
+
+            if (pConn->info.complete || pConn->info.phyConfirmed) {
+                finish(*pConn);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_CONN_UPDATE: {
+            Conn* pConn = findConn(event->conn_update.conn_handle);
+            if (pConn != nullptr && pConn->info.complete && event->conn_update.status == 0) {
+                finish(*pConn);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+} // handleGapEvent
+
+#endif // CONFIG_BT_ENABLED && (CONFIG_BT_NIMBLE_ROLE_PERIPHERAL || CONFIG_BT_NIMBLE_ROLE_CENTRAL)
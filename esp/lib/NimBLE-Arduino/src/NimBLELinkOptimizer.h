@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NIMBLE_CPP_LINK_OPTIMIZER_H_
+#define NIMBLE_CPP_LINK_OPTIMIZER_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && (defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL) || defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL))
+
+# if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "host/ble_gap.h"
+# else
+#  include "nimble/nimble/host/include/host/ble_gap.h"
+# endif
+
+/****  FIX COMPILATION ****/
+# undef min
+# undef max
+/**************************/
+
+# include <array>
+# include <functional>
+# include <stddef.h>
+
+struct ble_npl_event;
+
+/**
+ * @brief Negotiates the fastest PHY and data length on each new connection and reports the resulting throughput.
+ * @details When enabled, every new connection requests the 2M PHY and the maximum data length. The results are
+ * confirmed from the PHY update and data length change events. If the peer does not answer within the
+ * settle time, the PHY in use is read back from the controller. The link throughput is then estimated from
+ * the negotiated PHY, data length and connection interval. It can be refined with a calibration transfer.\n
+ * While enabled, NimBLEConnGovernor leaves the PHY and data length to the optimizer.
+ */
+class NimBLELinkOptimizer {
+  public:
+    /**
+     * @brief The negotiated link and its throughput.
+     */
+    struct LinkInfo {
+        uint8_t  txPhy;            // Transmit PHY in use.
+        uint8_t  rxPhy;            // Receive PHY in use.
+        uint16_t txOctets;         // Maximum transmit payload octets per packet.
+        uint16_t rxOctets;         // Maximum receive payload octets per packet.
+        uint16_t interval;         // Connection interval in 1.25ms units.
+        bool     phyConfirmed;     // A PHY update complete event was received.
+        bool     dataLenConfirmed; // A data length change event was received.
+        bool     complete;         // Negotiation has finished, confirmed or timed out.
+        uint32_t estimatedBps;     // Throughput estimated from the link parameters, in bytes per second.
+        uint32_t measuredBps;      // Throughput measured by calibrate(), 0 if not calibrated.
+    };
+
+    typedef std::function<void(uint16_t connHandle, const LinkInfo& info)> linkInfoCallback;
+    typedef std::function<bool(const uint8_t* data, size_t length)>        sendFunction;
+
+    static void     enable(bool enable, uint32_t settleMs = 2000);
+    static bool     isEnabled();
+    static void     setCallback(const linkInfoCallback& callback);
+    static bool     optimize(uint16_t connHandle);
+    static bool     getLinkInfo(uint16_t connHandle, LinkInfo* info);
+    static uint32_t calibrate(uint16_t            connHandle,
+                              const sendFunction& send,
+                              size_t              totalBytes = 8192,
+                              size_t              chunkSize  = 512);
+
+  private:
+    friend class NimBLEServer;
+    friend class NimBLEClient;
+
+    struct Conn {
+        uint16_t connHandle{BLE_HS_CONN_HANDLE_NONE};
+        uint32_t deadline{0};
+        LinkInfo info{};
+    };
+
+    static void     handleGapEvent(const ble_gap_event* event);
+    static void     onSettle(ble_npl_event* event);
+    static void     finish(Conn& conn);
+    static void     publish(Conn& conn);
+    static uint32_t estimateThroughput(const LinkInfo& info, bool encrypted);
+    static Conn*    findConn(uint16_t connHandle);
+
+    static std::array<Conn, CONFIG_BT_NIMBLE_MAX_CONNECTIONS> m_conns;
+    static linkInfoCallback                                   m_callback;
+    static uint32_t                                           m_settleMs;
+    static bool                                               m_enabled;
+}; // NimBLELinkOptimizer
+
+#endif // CONFIG_BT_ENABLED && (CONFIG_BT_NIMBLE_ROLE_PERIPHERAL || CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+#endif // NIMBLE_CPP_LINK_OPTIMIZER_H_
@@ -91,6 +91,14 @@ class NimBLELocalValueAttribute : public NimBLELocalAttribute {
      */
     void setValue(const std::vector<uint8_t>& vec) { m_value.setValue(vec); }
 
+    /**
+     * @brief Set the value of the attribute to refer to a constant buffer without copying it.
+     * @param [in] data The data to set the value to, must remain valid and unchanged while in use.
+     * @param [in] size The size of the data.
+     * @details Intended for read-mostly attributes, a write from a peer copies the value into owned storage.
+     */
+    void setValueShared(const uint8_t* data, size_t size) { m_value.setValueShared(data, size); }
+
     /**
      * @brief Template to set the value to <type\>val.
      * @param [in] val The value to set.
@@ -258,6 +258,15 @@ bool NimBLERemoteCharacteristic::unsubscribe(bool response) const {
     return setNotify(0x00, nullptr, response);
 } // unsubscribe
 
+/**
+ * @brief Set whether notifications and indications are stored as the value of this characteristic.
+ * @param [in] cache If false the received data is only passed to the notify callback,\n
+ * which avoids copying every update for high rate data streams. Enabled by default.
+ */
+void NimBLERemoteCharacteristic::setCacheNotifyValue(bool cache) const {
+    m_cacheNotifyValue = cache;
+} // setCacheNotifyValue
+
 /**
  * @brief Delete the descriptors in the descriptor vector.
  * @details We maintain a vector called m_vDescriptors that contains pointers to NimBLERemoteDescriptors
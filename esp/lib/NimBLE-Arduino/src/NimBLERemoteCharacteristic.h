@@ -53,6 +53,7 @@ class NimBLERemoteCharacteristic : public NimBLERemoteValueAttribute {
 
     bool subscribe(bool notifications = true, const notify_callback notifyCallback = nullptr, bool response = true) const;
     bool unsubscribe(bool response = true) const;
+    void setCacheNotifyValue(bool cache) const;
 
     std::vector<NimBLERemoteDescriptor*>::iterator begin() const;
     std::vector<NimBLERemoteDescriptor*>::iterator end() const;
@@ -75,6 +76,7 @@ class NimBLERemoteCharacteristic : public NimBLERemoteValueAttribute {
     const NimBLERemoteService*                   m_pRemoteService{nullptr};
     uint8_t                                      m_properties{0};
     mutable notify_callback                      m_notifyCallback{nullptr};
+    mutable bool                                 m_cacheNotifyValue{true};
     mutable std::vector<NimBLERemoteDescriptor*> m_vDescriptors{};
 
 }; // NimBLERemoteCharacteristic
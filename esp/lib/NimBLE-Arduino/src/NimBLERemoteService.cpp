@@ -41,7 +41,7 @@ NimBLERemoteService::NimBLERemoteService(NimBLEClient* pClient, const ble_gatt_s
  * @brief When deleting the service make sure we delete all characteristics and descriptors.
  */
 NimBLERemoteService::~NimBLERemoteService() {
-    deleteCharacteristics();
+    clearCharacteristics();
 }
 
 /**
@@ -206,6 +206,7 @@ bool NimBLERemoteService::retrieveCharacteristics(const NimBLEUUID* uuidFilter)
     }
 
     NimBLEUtils::taskWait(taskData, BLE_NPL_TIME_FOREVER);
+    m_pClient->updateCharacteristicIndex();
     rc = taskData.m_flags;
     if (rc == 0 || rc == BLE_HS_EDONE) {
         NIMBLE_LOGD(LOG_TAG, "<< retrieveCharacteristics()");
@@ -260,11 +261,20 @@ bool NimBLERemoteService::setValue(const NimBLEUUID& uuid, const NimBLEAttValue&
  * them. This method does just that.
  */
 void NimBLERemoteService::deleteCharacteristics() const {
+    m_pClient->clearCharacteristicIndex();
+    clearCharacteristics();
+    m_pClient->updateCharacteristicIndex();
+} // deleteCharacteristics
+
+/**
+ * @brief Delete the characteristics without updating the client characteristic index.
+ */
+void NimBLERemoteService::clearCharacteristics() const {
     for (const auto& it : m_vChars) {
         delete it;
     }
     std::vector<NimBLERemoteCharacteristic*>{}.swap(m_vChars);
-} // deleteCharacteristics
+} // clearCharacteristics
 
 /**
  * @brief Delete characteristic by UUID
@@ -274,8 +284,11 @@ void NimBLERemoteService::deleteCharacteristics() const {
 size_t NimBLERemoteService::deleteCharacteristic(const NimBLEUUID& uuid) const {
     for (auto it = m_vChars.begin(); it != m_vChars.end(); ++it) {
         if ((*it)->getUUID() == uuid) {
-            delete (*it);
+            NimBLERemoteCharacteristic* pChr = *it;
+            m_pClient->clearCharacteristicIndex();
             m_vChars.erase(it);
+            delete pChr;
+            m_pClient->updateCharacteristicIndex();
             break;
         }
     }
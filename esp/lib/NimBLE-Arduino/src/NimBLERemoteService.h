@@ -54,6 +54,7 @@ class NimBLERemoteService : public NimBLEAttribute {
     NimBLERemoteService(NimBLEClient* pClient, const struct ble_gatt_svc* service);
     ~NimBLERemoteService();
     bool       retrieveCharacteristics(const NimBLEUUID* uuidFilter = nullptr) const;
+    void       clearCharacteristics() const;
     static int characteristicDiscCB(uint16_t                     conn_handle,
                                     const struct ble_gatt_error* error,
                                     const struct ble_gatt_chr*   chr,
@@ -20,6 +20,7 @@
 
 # include "NimBLERemoteValueAttribute.h"
 # include "NimBLEClient.h"
+# include "NimBLEConnGovernor.h"
 # include "NimBLEUtils.h"
 # include "NimBLELog.h"
 
@@ -88,6 +89,7 @@ Done:
     if (rc != 0) {
         NIMBLE_LOGE(LOG_TAG, "<< writeValue failed, rc: %d %s", rc, NimBLEUtils::returnCodeToString(rc));
     } else {
+        NimBLEConnGovernor::recordTraffic(pClient->getConnHandle(), length);
         NIMBLE_LOGD(LOG_TAG, "<< writeValue");
     }
 
@@ -165,6 +167,7 @@ NimBLEAttValue NimBLERemoteValueAttribute::readValue(time_t* timestamp) const {
 
     value.setTimeStamp();
     m_value = value;
+    NimBLEConnGovernor::recordTraffic(pClient->getConnHandle(), value.size());
     if (timestamp != nullptr) {
         *timestamp = value.getTimeStamp();
     }
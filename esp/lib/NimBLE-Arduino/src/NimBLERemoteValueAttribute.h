@@ -197,6 +197,8 @@ class NimBLERemoteValueAttribute : public NimBLEAttribute {
     static int onWriteCB(uint16_t conn_handle, const ble_gatt_error* error, ble_gatt_attr* attr, void* arg);
 
     mutable NimBLEAttValue m_value{};
+
+    friend class NimBLEClient;
 };
 
 #endif /* CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_CENTRAL */
@@ -23,6 +23,7 @@
 # include "NimBLELog.h"
 
 # include <string>
+# include <cstring>
 # include <climits>
 
 static const char*         LOG_TAG = "NimBLEScan";
@@ -43,6 +44,12 @@ NimBLEScan::NimBLEScan()
  */
 NimBLEScan::~NimBLEScan() {
     clearResults();
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    for (auto& eadKey : m_eadKeys) {
+        ble_ead_key_clear(&eadKey->key);
+        delete eadKey;
+    }
+# endif
 }
 
 /**
@@ -123,6 +130,12 @@ int NimBLEScan::handleGapEvent(ble_gap_event* event, void* arg) {
                 }
             }
 
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+            if (!pScan->m_eadKeys.empty()) {
+                pScan->decryptAdvData(advertisedDevice);
+            }
+# endif
+
             if (!advertisedDevice->m_callbackSent) {
                 advertisedDevice->m_callbackSent++;
                 pScan->m_pScanCallbacks->onDiscovered(advertisedDevice);
@@ -294,6 +307,181 @@ void NimBLEScan::setPeriod(uint32_t periodMs) {
 } // setScanPeriod
 # endif
 
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+/**
+ * @brief Set the key material used to decrypt the Encrypted Advertising Data of a device.
+ * @param [in] address The address of the device as reported in the scan results.
+ * @param [in] sessionKey The 16 byte Session Key, as read from the device's Encrypted Data Key Material characteristic.
+ * @param [in] iv The 8 byte Initialisation Vector from the same characteristic.
+ * @return True if the key was set, false if scanning or the key could not be prepared.
+ * @details The key schedule is expanded once here, so decrypting a report only runs the cipher.
+ * Reports from devices without a key are not decrypted. Replaces any key already set for the address.
+ */
+bool NimBLEScan::setEncryptedDataKey(const NimBLEAddress& address, const uint8_t* sessionKey, const uint8_t* iv) {
+    if (isScanning()) {
+        NIMBLE_LOGE(LOG_TAG, "Cannot change encrypted data keys while scanning");
+        return false;
+    }
+
+    EadKey* pEadKey = nullptr;
+    for (auto& eadKey : m_eadKeys) {
+        if (eadKey->address == address) {
+            pEadKey = eadKey;
+            ble_ead_key_clear(&pEadKey->key);
+            break;
+        }
+    }
+
+    bool isNew = pEadKey == nullptr;
+    if (isNew) {
+        pEadKey          = new EadKey{};
+        pEadKey->address = address;
+    }
+
+    int rc = ble_ead_key_set(&pEadKey->key, sessionKey, iv);
+    if (rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Failed to set encrypted data key; rc=%d %s", rc, NimBLEUtils::returnCodeToString(rc));
+        if (isNew) {
+            delete pEadKey;
+        } else {
+            removeEncryptedDataKey(address);
+        }
+        return false;
+    }
+
+    if (isNew) {
+        m_eadKeys.push_back(pEadKey);
+    }
+
+    return true;
+} // setEncryptedDataKey
+
+/**
+ * @brief Remove the Encrypted Advertising Data key of a device.
+ * @param [in] address The address the key was set for.
+ * @return True if the key was removed or not found, false if scanning.
+ */
+bool NimBLEScan::removeEncryptedDataKey(const NimBLEAddress& address) {
+    if (isScanning()) {
+        NIMBLE_LOGE(LOG_TAG, "Cannot change encrypted data keys while scanning");
+        return false;
+    }
+
+    for (auto it = m_eadKeys.begin(); it != m_eadKeys.end(); ++it) {
+        if ((*it)->address == address) {
+            ble_ead_key_clear(&(*it)->key);
+            delete *it;
+            m_eadKeys.erase(it);
+            break;
+        }
+    }
+
+    return true;
+} // removeEncryptedDataKey
+
+/**
+ * @brief Remove all Encrypted Advertising Data keys.
+ * @return True if the keys were removed, false if scanning.
+ */
+bool NimBLEScan::clearEncryptedDataKeys() {
+    if (isScanning()) {
+        NIMBLE_LOGE(LOG_TAG, "Cannot change encrypted data keys while scanning");
+        return false;
+    }
+
+    for (auto& eadKey : m_eadKeys) {
+        ble_ead_key_clear(&eadKey->key);
+        delete eadKey;
+    }
+
+    m_eadKeys.clear();
+    return true;
+} // clearEncryptedDataKeys
+
+/**
+ * @brief Get the prepared key of a device.
+ * @param [in] address The address of the device.
+ * @return A pointer to the key or nullptr if none was set.
+ */
+const ble_ead_key* NimBLEScan::getEncryptedDataKey(const NimBLEAddress& address) const {
+    for (const auto& eadKey : m_eadKeys) {
+        if (eadKey->address == address) {
+            return &eadKey->key;
+        }
+    }
+
+    return nullptr;
+} // getEncryptedDataKey
+
+/**
+ * @brief Decrypt the Encrypted Data structures of an advertisement into the device's decrypted data.
+ * @param [in] pDevice The device whose payload was just received.
+ * @details Nothing is decrypted unless a key is set for the device. All structures of the payload are
+ * decrypted in one batch and only those that authenticate are kept.
+ */
+void NimBLEScan::decryptAdvData(NimBLEAdvertisedDevice* pDevice) const {
+    std::vector<uint8_t>& decrypted = pDevice->m_decryptedData;
+    decrypted.clear();
+
+    const ble_ead_key* pKey = getEncryptedDataKey(pDevice->getAddress());
+    if (pKey == nullptr) {
+        return;
+    }
+
+    const std::vector<uint8_t>&     payload = pDevice->m_payload;
+    std::vector<ble_ead_decrypt_op> ops;
+    size_t                          total = 0;
+
+    for (size_t pos = 0; pos + 1 < payload.size(); pos += payload[pos] + 1) {
+        uint8_t length = payload[pos];
+        if (pos + length >= payload.size()) {
+            break;
+        }
+
+        if (length > BLE_EAD_RANDOMIZER_SIZE + BLE_EAD_MIC_SIZE + 1 && payload[pos + 1] == BLE_HS_ADV_TYPE_ENC_ADV_DATA) {
+            ble_ead_decrypt_op op{};
+            op.key                    = pKey;
+            op.encrypted_payload      = &payload[pos + 2];
+            op.encrypted_payload_size = length - 1;
+            ops.push_back(op);
+            total += BLE_EAD_DECRYPTED_PAYLOAD_SIZE(op.encrypted_payload_size);
+        }
+    }
+
+    if (ops.empty()) {
+        return;
+    }
+
+    decrypted.resize(total);
+    size_t offset = 0;
+    for (auto& op : ops) {
+        op.payload  = &decrypted[offset];
+        offset     += BLE_EAD_DECRYPTED_PAYLOAD_SIZE(op.encrypted_payload_size);
+    }
+
+    if (ble_ead_decrypt_batch(ops.data(), ops.size()) == static_cast<int>(ops.size())) {
+        return;
+    }
+
+    // Drop the structures that did not authenticate, keeping the rest in order.
+    offset = 0;
+    for (const auto& op : ops) {
+        size_t size = BLE_EAD_DECRYPTED_PAYLOAD_SIZE(op.encrypted_payload_size);
+        if (op.rc == 0) {
+            memmove(&decrypted[offset], op.payload, size);
+            offset += size;
+        } else {
+            NIMBLE_LOGD(LOG_TAG,
+                        "Encrypted data from %s not decrypted; rc=%d",
+                        pDevice->getAddress().toString().c_str(),
+                        op.rc);
+        }
+    }
+
+    decrypted.resize(offset);
+} // decryptAdvData
+# endif
+
 /**
  * @brief Start scanning.
  * @param [in] duration The duration in milliseconds for which to scan. 0 == scan forever.
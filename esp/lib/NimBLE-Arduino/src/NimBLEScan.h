@@ -30,6 +30,14 @@
 #  include "nimble/nimble/host/include/host/ble_gap.h"
 # endif
 
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+#  if defined(CONFIG_NIMBLE_CPP_IDF)
+#   include "host/ble_ead.h"
+#  else
+#   include "nimble/nimble/host/include/host/ble_ead.h"
+#  endif
+# endif
+
 # include <vector>
 
 class NimBLEDevice;
@@ -89,6 +97,12 @@ class NimBLEScan {
     void setPeriod(uint32_t periodMs);
 # endif
 
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    bool setEncryptedDataKey(const NimBLEAddress& address, const uint8_t* sessionKey, const uint8_t* iv);
+    bool removeEncryptedDataKey(const NimBLEAddress& address);
+    bool clearEncryptedDataKeys();
+# endif
+
   private:
     friend class NimBLEDevice;
 
@@ -107,6 +121,18 @@ class NimBLEScan {
     uint8_t  m_phy{SCAN_ALL};
     uint16_t m_period{0};
 # endif
+
+# if CONFIG_BT_NIMBLE_ENC_ADV_DATA
+    struct EadKey {
+        NimBLEAddress address;
+        ble_ead_key   key;
+    };
+
+    const ble_ead_key* getEncryptedDataKey(const NimBLEAddress& address) const;
+    void               decryptAdvData(NimBLEAdvertisedDevice* pDevice) const;
+
+    std::vector<EadKey*> m_eadKeys{};
+# endif
 };
 
 /**
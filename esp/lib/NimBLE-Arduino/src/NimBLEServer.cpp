@@ -20,6 +20,8 @@
 
 # include "NimBLEServer.h"
 # include "NimBLEDevice.h"
+# include "NimBLEConnGovernor.h"
+# include "NimBLELinkOptimizer.h"
 # include "NimBLELog.h"
 
 # if defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
@@ -353,6 +355,9 @@ int NimBLEServer::handleGapEvent(ble_gap_event* event, void* arg) {
     NimBLEConnInfo peerInfo{};
     NimBLEServer*  pServer = NimBLEDevice::getServer();
 
+    NimBLEConnGovernor::handleGapEvent(event);
+    NimBLELinkOptimizer::handleGapEvent(event);
+
     switch (event->type) {
         case BLE_GAP_EVENT_CONNECT: {
             if (event->connect.status != 0) {
@@ -462,6 +467,17 @@ int NimBLEServer::handleGapEvent(ble_gap_event* event, void* arg) {
             break;
         } // BLE_GAP_EVENT_MTU
 
+# if CONFIG_BT_NIMBLE_EATT_CHAN_NUM > 0
+        case BLE_GAP_EVENT_EATT: {
+            NIMBLE_LOGI(LOG_TAG,
+                        "EATT bearer %s; conn_handle=%d cid=%d",
+                        event->eatt.status == 0 ? "connected" : "disconnected",
+                        event->eatt.conn_handle,
+                        event->eatt.cid);
+            break;
+        } // BLE_GAP_EVENT_EATT
+# endif
+
         case BLE_GAP_EVENT_NOTIFY_TX: {
             NimBLECharacteristic* pChar = nullptr;
 
@@ -624,6 +640,8 @@ int NimBLEServer::handleGattEvent(uint16_t connHandle, uint16_t attrHandle, ble_
                 pAtt->readEvent(peerInfo);
             }
 
+            NimBLEConnGovernor::recordTraffic(connHandle, val.size());
+
             ble_npl_hw_enter_critical();
             int rc = os_mbuf_append(ctxt->om, val.data(), val.size());
             ble_npl_hw_exit_critical(0);
@@ -652,6 +670,7 @@ int NimBLEServer::handleGattEvent(uint16_t connHandle, uint16_t attrHandle, ble_
                 next  = SLIST_NEXT(next, om_next);
             }
 
+            NimBLEConnGovernor::recordTraffic(connHandle, len);
             pAtt->writeEvent(buf, len, peerInfo);
             return 0;
         }
@@ -885,6 +904,23 @@ uint16_t NimBLEServer::getPeerMTU(uint16_t connHandle) const {
     return ble_att_mtu(connHandle);
 } // getPeerMTU
 
+/**
+ * @brief Get the MTU of each ATT bearer of a client connection.
+ * @param [in] connHandle The connection handle of the client.
+ * @returns The MTU of the unenhanced bearer followed by that of each Enhanced ATT bearer,
+ * empty if not found/connected.
+ */
+std::vector<uint16_t> NimBLEServer::getBearerMTUs(uint16_t connHandle) const {
+    ble_att_bearer_desc   bearers[1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM)];
+    int                   count = ble_att_get_bearers(connHandle, bearers, 1 + MYNEWT_VAL(BLE_EATT_CHAN_NUM));
+    std::vector<uint16_t> mtus;
+    for (int i = 0; i < count; i++) {
+        mtus.push_back(bearers[i].mtu);
+    }
+
+    return mtus;
+} // getBearerMTUs
+
 /**
  * @brief Request an Update the connection parameters:
  * * Can only be used after a connection has been established.
@@ -73,6 +73,7 @@ class NimBLEServer {
     void                  removeService(NimBLEService* service, bool deleteSvc = false);
     void                  addService(NimBLEService* service);
     uint16_t              getPeerMTU(uint16_t connHandle) const;
+    std::vector<uint16_t> getBearerMTUs(uint16_t connHandle) const;
     std::vector<uint16_t> getPeerDevices() const;
     NimBLEConnInfo        getPeerInfo(uint8_t index) const;
     NimBLEConnInfo        getPeerInfo(const NimBLEAddress& address) const;
@@ -531,6 +531,10 @@ const char* NimBLEUtils::gapEventToString(uint8_t eventType) {
         case BLE_GAP_EVENT_LINK_ESTAB: // 38
             return "BLE_GAP_EVENT_LINK_ESTAB";
 #   endif
+#   ifdef BLE_GAP_EVENT_EATT
+        case BLE_GAP_EVENT_EATT: // 39
+            return "BLE_GAP_EVENT_EATT";
+#   endif
 #  endif
         default:
             NIMBLE_LOGD(LOG_TAG, "Unknown event type %d 0x%.2x", eventType, eventType);
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+
+# include "NimBLEWriteStream.h"
+# include "NimBLERemoteValueAttribute.h"
+# include "NimBLEClient.h"
+# include "NimBLEConnGovernor.h"
+# include "NimBLEUtils.h"
+# include "NimBLELog.h"
+
+# include <algorithm>
+
+// Longest wait for a transmit completion. Bounds the wait when the host is out of buffers with nothing
+// outstanding on the connection, or when the connection ends, since neither produces a completion.
+# define NIMBLE_CPP_WRITE_STREAM_WAIT_MS 50
+
+static const char*        LOG_TAG = "NimBLEWriteStream";
+static ble_npl_mutex      waitMutex;
+static bool               waitMutexInit = false;
+static NimBLEWriteStream* waitList      = nullptr;
+
+/**
+ * @brief Construct a stream writing to a remote attribute.
+ * @param [in] pAttr The remote characteristic or descriptor to write to.
+ * @param [in] window Packets allowed in flight on the connection, 0 to use the number of controller ACL buffers.
+ * @note The stream sets the host's transmit complete callback, which must not be used by anything else.
+ */
+NimBLEWriteStream::NimBLEWriteStream(const NimBLERemoteValueAttribute* pAttr, uint16_t window)
+    : m_pAttr{pAttr}, m_window{window} {
+    if (!waitMutexInit) {
+        ble_npl_mutex_init(&waitMutex);
+        ble_hs_set_tx_complete_cb(NimBLEWriteStream::onTxComplete, nullptr);
+        waitMutexInit = true;
+    }
+} // NimBLEWriteStream
+
+/**
+ * @brief Write data to the remote attribute.
+ * @param [in] data The data to write.
+ * @param [in] length The number of bytes to write, any length.
+ * @param [in] timeout The longest time to wait for the controller to make room, in ms.
+ * @return The number of bytes handed to the host, less than length on timeout or error.
+ * @details Blocks while the window is full. Bytes written are only guaranteed to be sent once
+ * flush() returns true. The reason for a short write is available from getLastError().
+ */
+size_t NimBLEWriteStream::write(const uint8_t* data, size_t length, uint32_t timeout) {
+    const NimBLEClient* pClient    = m_pAttr->getClient();
+    uint16_t            connHandle = pClient->getConnHandle();
+    uint16_t            chunkSize  = getChunkSize();
+    ble_npl_time_t      deadline   = BLE_NPL_TIME_FOREVER;
+    size_t              written    = 0;
+
+    m_lastError = 0;
+    if (chunkSize == 0) {
+        m_lastError = BLE_HS_ENOTCONN;
+        return 0;
+    }
+
+    if (timeout != BLE_NPL_TIME_FOREVER) {
+        ble_npl_time_ms_to_ticks(timeout, &deadline);
+        deadline += ble_npl_time_get();
+    }
+
+    if (m_stats.chunks == 0) {
+        m_startTime = ble_npl_time_get();
+    }
+
+    while (written < length) {
+        ble_hs_conn_tx_state state;
+        int                  rc = ble_hs_conn_get_tx_state(connHandle, &state);
+        if (rc != 0) {
+            m_lastError = rc;
+            break;
+        }
+
+        uint16_t inFlight = state.outstanding + state.queued;
+        if (inFlight >= getWindow(state)) {
+            if (!waitTx(connHandle, inFlight, deadline)) {
+                m_lastError = BLE_HS_ETIMEOUT;
+                break;
+            }
+            continue;
+        }
+
+        size_t len = std::min<size_t>(chunkSize, length - written);
+        rc         = ble_gattc_write_no_rsp_flat(connHandle, m_pAttr->getHandle(), data + written, len);
+        if (rc == BLE_HS_ENOMEM) {
+            // The host ran out of buffers, they are freed as the controller transmits.
+            m_stats.noMemRetries++;
+            if (!waitTx(connHandle, inFlight, deadline)) {
+                m_lastError = BLE_HS_ETIMEOUT;
+                break;
+            }
+            continue;
+        }
+
+        if (rc != 0) {
+            m_lastError = rc;
+            break;
+        }
+
+        written += len;
+        m_stats.bytesWritten += len;
+        m_stats.chunks++;
+    }
+
+    m_lastTime = ble_npl_time_get();
+    if (written > 0) {
+        NimBLEConnGovernor::recordTraffic(connHandle, written);
+    }
+
+    if (m_lastError != 0) {
+        NIMBLE_LOGE(LOG_TAG,
+                    "write stopped after %u of %u bytes, rc=%d %s",
+                    (unsigned)written,
+                    (unsigned)length,
+                    m_lastError,
+                    NimBLEUtils::returnCodeToString(m_lastError));
+    }
+
+    return written;
+} // write
+
+/**
+ * @brief Wait until the controller has transmitted everything written to the connection.
+ * @param [in] timeout The longest time to wait in ms.
+ * @return True if all packets were transmitted, false on timeout or disconnect.
+ */
+bool NimBLEWriteStream::flush(uint32_t timeout) {
+    uint16_t       connHandle = m_pAttr->getClient()->getConnHandle();
+    ble_npl_time_t deadline   = BLE_NPL_TIME_FOREVER;
+
+    if (timeout != BLE_NPL_TIME_FOREVER) {
+        ble_npl_time_ms_to_ticks(timeout, &deadline);
+        deadline += ble_npl_time_get();
+    }
+
+    for (;;) {
+        ble_hs_conn_tx_state state;
+        m_lastError = ble_hs_conn_get_tx_state(connHandle, &state);
+        if (m_lastError != 0) {
+            return false;
+        }
+
+        uint16_t inFlight = state.outstanding + state.queued;
+        if (inFlight == 0) {
+            m_lastTime = ble_npl_time_get();
+            return true;
+        }
+
+        if (!waitTx(connHandle, inFlight, deadline)) {
+            m_lastError = BLE_HS_ETIMEOUT;
+            return false;
+        }
+    }
+} // flush
+
+/**
+ * @brief Get the number of bytes that can be written without blocking.
+ * @return The free part of the window in bytes, 0 if not connected.
+ */
+size_t NimBLEWriteStream::availableForWrite() const {
+    ble_hs_conn_tx_state state;
+    if (ble_hs_conn_get_tx_state(m_pAttr->getClient()->getConnHandle(), &state) != 0) {
+        return 0;
+    }
+
+    uint16_t window   = getWindow(state);
+    uint16_t inFlight = state.outstanding + state.queued;
+    return inFlight < window ? (window - inFlight) * getChunkSize() : 0;
+} // availableForWrite
+
+/**
+ * @brief Get the number of bytes sent in each write command.
+ * @return The MTU of the smallest ATT bearer less the 3 byte header, 0 if not connected.
+ * @details Write commands may be sent on any bearer of the connection.
+ */
+uint16_t NimBLEWriteStream::getChunkSize() const {
+    std::vector<uint16_t> mtus = m_pAttr->getClient()->getBearerMTUs();
+    if (mtus.empty()) {
+        return 0;
+    }
+
+    return *std::min_element(mtus.begin(), mtus.end()) - 3;
+} // getChunkSize
+
+/**
+ * @brief Set the number of packets allowed in flight on the connection.
+ * @param [in] window The number of packets, 0 to use the number of controller ACL buffers.
+ * @details A smaller window leaves controller buffers for other connections, a larger one lets the
+ * host queue packets behind those already in the controller.
+ */
+void NimBLEWriteStream::setWindow(uint16_t window) {
+    m_window = window;
+} // setWindow
+
+/**
+ * @brief Get the throughput and back-pressure seen since the stream was created or reset.
+ * @return The stream statistics.
+ */
+NimBLEWriteStream::Stats NimBLEWriteStream::getStats() const {
+    Stats                stats = m_stats;
+    ble_hs_conn_tx_state state;
+
+    if (ble_hs_conn_get_tx_state(m_pAttr->getClient()->getConnHandle(), &state) == 0) {
+        stats.inFlight = state.outstanding + state.queued;
+        stats.window   = getWindow(state);
+    }
+
+    uint32_t elapsedMs = ble_npl_time_ticks_to_ms32(m_lastTime - m_startTime);
+    if (stats.chunks > 0 && elapsedMs > 0) {
+        stats.bytesPerSec = static_cast<uint32_t>(static_cast<uint64_t>(stats.bytesWritten) * 1000 / elapsedMs);
+    }
+
+    return stats;
+} // getStats
+
+/**
+ * @brief Clear the statistics, the throughput is measured again from the next write.
+ */
+void NimBLEWriteStream::resetStats() {
+    m_stats     = Stats{};
+    m_startTime = 0;
+    m_lastTime  = 0;
+} // resetStats
+
+/**
+ * @brief Get the window for the current transmit state.
+ */
+uint16_t NimBLEWriteStream::getWindow(const ble_hs_conn_tx_state& state) const {
+    if (m_window > 0) {
+        return m_window;
+    }
+
+    return state.total > 0 ? state.total : 1;
+} // getWindow
+
+/**
+ * @brief Block until the controller transmits a packet of the connection.
+ * @param [in] connHandle The connection being written to.
+ * @param [in] inFlight The packets in flight when the caller decided to wait.
+ * @param [in] deadline The time to give up at, BLE_NPL_TIME_FOREVER to wait indefinitely.
+ * @return False if the deadline has passed.
+ * @details The wait is cut short if packets completed before the stream was registered as waiting.
+ */
+bool NimBLEWriteStream::waitTx(uint16_t connHandle, uint16_t inFlight, ble_npl_time_t deadline) {
+    ble_npl_time_t start  = ble_npl_time_get();
+    uint32_t       waitMs = NIMBLE_CPP_WRITE_STREAM_WAIT_MS;
+
+    if (deadline != BLE_NPL_TIME_FOREVER) {
+        if (static_cast<int32_t>(deadline - start) <= 0) {
+            return false;
+        }
+
+        waitMs = std::min(waitMs, ble_npl_time_ticks_to_ms32(deadline - start));
+    }
+
+    NimBLETaskData taskData(this);
+    ble_npl_mutex_pend(&waitMutex, BLE_NPL_TIME_FOREVER);
+    m_waitConnHandle = connHandle;
+    m_pWaitTask      = &taskData;
+    m_pNext          = waitList;
+    waitList         = this;
+    ble_npl_mutex_release(&waitMutex);
+
+    ble_hs_conn_tx_state state;
+    if (ble_hs_conn_get_tx_state(connHandle, &state) == 0 && state.outstanding + state.queued >= inFlight) {
+        NimBLEUtils::taskWait(taskData, waitMs);
+    }
+
+    ble_npl_mutex_pend(&waitMutex, BLE_NPL_TIME_FOREVER);
+    for (NimBLEWriteStream** pp = &waitList; *pp != nullptr; pp = &(*pp)->m_pNext) {
+        if (*pp == this) {
+            *pp = m_pNext;
+            break;
+        }
+    }
+    m_pWaitTask = nullptr;
+    ble_npl_mutex_release(&waitMutex);
+
+    // Consume a release that raced with the timeout so it does not wake a later wait.
+    NimBLEUtils::taskWait(taskData, 0);
+
+    m_stats.stalls++;
+    m_stats.stallMs += ble_npl_time_ticks_to_ms32(ble_npl_time_get() - start);
+    return true;
+} // waitTx
+
+/**
+ * @brief Called by the host when the controller has transmitted packets, wakes the streams waiting on the connection.
+ */
+void NimBLEWriteStream::onTxComplete(uint16_t connHandle, uint16_t numPkts, void* arg) {
+    (void)numPkts;
+    (void)arg;
+
+    ble_npl_mutex_pend(&waitMutex, BLE_NPL_TIME_FOREVER);
+    for (NimBLEWriteStream* pStream = waitList; pStream != nullptr; pStream = pStream->m_pNext) {
+        if (pStream->m_waitConnHandle == connHandle && pStream->m_pWaitTask != nullptr) {
+            NimBLEUtils::taskRelease(*pStream->m_pWaitTask);
+        }
+    }
+    ble_npl_mutex_release(&waitMutex);
+} // onTxComplete
+
+#endif // CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_CENTRAL
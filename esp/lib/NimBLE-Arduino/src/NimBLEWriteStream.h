@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020-2025 Ryan Powell <ryan@nable-embedded.io> and
+ * esp-nimble-cpp, NimBLE-Arduino contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NIMBLE_CPP_WRITE_STREAM_H_
+#define NIMBLE_CPP_WRITE_STREAM_H_
+
+#include "nimconfig.h"
+#if defined(CONFIG_BT_ENABLED) && defined(CONFIG_BT_NIMBLE_ROLE_CENTRAL)
+
+# if defined(CONFIG_NIMBLE_CPP_IDF)
+#  include "host/ble_hs.h"
+# else
+#  include "nimble/nimble/host/include/host/ble_hs.h"
+# endif
+
+/****  FIX COMPILATION ****/
+# undef min
+# undef max
+/**************************/
+
+# include <stddef.h>
+
+class NimBLERemoteValueAttribute;
+struct NimBLETaskData;
+
+/**
+ * @brief Streams data to a remote attribute with write commands, paced by the controller.
+ * @details Data is split into chunks that fit the smallest ATT bearer of the connection and sent as
+ * write without response. The number of packets held by the host and controller for the connection is
+ * kept below a window, by default the number of controller ACL buffers. When the window is full the
+ * writer blocks until the controller reports packets as transmitted, so the buffers stay full without
+ * running the host out of memory.
+ */
+class NimBLEWriteStream {
+  public:
+    /**
+     * @brief Throughput and back-pressure of a stream.
+     */
+    struct Stats {
+        uint32_t bytesWritten; // Payload bytes handed to the host.
+        uint32_t chunks;       // Write commands sent.
+        uint32_t stalls;       // Times a write waited for the controller to transmit.
+        uint32_t stallMs;      // Time spent waiting, in ms.
+        uint32_t noMemRetries; // Write commands retried because the host was out of buffers.
+        uint32_t bytesPerSec;  // Bytes written over the time from the first write to the last activity.
+        uint16_t inFlight;     // Packets of the connection currently held by the host and controller.
+        uint16_t window;       // Packets allowed in flight.
+    };
+
+    NimBLEWriteStream(const NimBLERemoteValueAttribute* pAttr, uint16_t window = 0);
+
+    size_t   write(const uint8_t* data, size_t length, uint32_t timeout = BLE_NPL_TIME_FOREVER);
+    bool     flush(uint32_t timeout = BLE_NPL_TIME_FOREVER);
+    size_t   availableForWrite() const;
+    uint16_t getChunkSize() const;
+    void     setWindow(uint16_t window);
+    Stats    getStats() const;
+    void     resetStats();
+    int      getLastError() const { return m_lastError; }
+
+  private:
+    NimBLEWriteStream(const NimBLEWriteStream&)            = delete;
+    NimBLEWriteStream& operator=(const NimBLEWriteStream&) = delete;
+
+    uint16_t getWindow(const ble_hs_conn_tx_state& state) const;
+    bool     waitTx(uint16_t connHandle, uint16_t inFlight, ble_npl_time_t deadline);
+
+    static void onTxComplete(uint16_t connHandle, uint16_t numPkts, void* arg);
+
+    const NimBLERemoteValueAttribute* m_pAttr;
+    uint16_t                          m_window;
+    int                               m_lastError{0};
+    Stats                             m_stats{};
+    ble_npl_time_t                    m_startTime{0};
+    ble_npl_time_t                    m_lastTime{0};
+
+    uint16_t              m_waitConnHandle{BLE_HS_CONN_HANDLE_NONE};
+    const NimBLETaskData* m_pWaitTask{nullptr};
+    NimBLEWriteStream*    m_pNext{nullptr};
+}; // NimBLEWriteStream
+
+#endif // CONFIG_BT_ENABLED && CONFIG_BT_NIMBLE_ROLE_CENTRAL
+#endif // NIMBLE_CPP_WRITE_STREAM_H_
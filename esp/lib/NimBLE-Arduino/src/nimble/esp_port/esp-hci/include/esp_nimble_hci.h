@@ -45,6 +45,25 @@ esp_err_t esp_nimble_hci_init(void);
  */
 esp_err_t esp_nimble_hci_deinit(void);
 
+/**
+ * @brief ACL data counters of the VHCI transport since it was initialized.
+ */
+struct esp_nimble_hci_acl_stats {
+    uint32_t tx_in_place;      /* Packets handed to the controller from the mbuf */
+    uint32_t tx_copied;        /* Chained packets flattened before sending */
+    uint32_t tx_bytes;
+    uint32_t rx;
+    uint32_t rx_bytes;
+    uint32_t rx_alloc_retries; /* Times the host ACL pool was empty on receive */
+};
+
+/**
+ * @brief Read the ACL data counters of the VHCI transport
+ *
+ * @param stats Filled with the current counters
+ */
+void esp_nimble_hci_acl_stats(struct esp_nimble_hci_acl_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
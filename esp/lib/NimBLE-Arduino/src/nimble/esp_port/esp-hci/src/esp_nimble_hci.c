@@ -50,6 +50,7 @@ static void *ble_hci_rx_acl_hs_arg;
 
 
 static SemaphoreHandle_t vhci_send_sem;
+static struct esp_nimble_hci_acl_stats acl_stats;
 const static char *LOG_TAG = "NimBLE";
 
 int os_msys_buf_alloc(void);
@@ -109,23 +110,37 @@ int ble_hci_trans_hs_acl_tx(struct os_mbuf *om)
 {
     uint16_t len = 0;
     uint8_t data[MYNEWT_VAL(BLE_TRANSPORT_ACL_SIZE) + 1], rc = 0;
+    uint8_t *pkt;
     /* If this packet is zero length, just free it */
     if (OS_MBUF_PKTLEN(om) == 0) {
         os_mbuf_free_chain(om);
         return 0;
     }
-    data[0] = BLE_HCI_UART_H4_ACL;
-    len++;
 
     if (!esp_vhci_host_check_send_available()) {
         ESP_LOGD(LOG_TAG, "Controller not ready to receive packets");
     }
 
-    os_mbuf_copydata(om, 0, OS_MBUF_PKTLEN(om), &data[1]);
-    len += OS_MBUF_PKTLEN(om);
+    /*
+     * ACL buffers from the host reserve a byte ahead of the HCI header for
+     * the H4 indicator, so a packet held in a single mbuf is handed to the
+     * controller in place. Only chained packets are flattened first.
+     */
+    if (SLIST_NEXT(om, om_next) == NULL && OS_MBUF_LEADINGSPACE(om) > 0) {
+        pkt = om->om_data - 1;
+        len = om->om_len + 1;
+        acl_stats.tx_in_place++;
+    } else {
+        pkt = data;
+        os_mbuf_copydata(om, 0, OS_MBUF_PKTLEN(om), &data[1]);
+        len = OS_MBUF_PKTLEN(om) + 1;
+        acl_stats.tx_copied++;
+    }
+    pkt[0] = BLE_HCI_UART_H4_ACL;
+    acl_stats.tx_bytes += len - 1;
 
     if (xSemaphoreTake(vhci_send_sem, NIMBLE_VHCI_TIMEOUT_MS / portTICK_PERIOD_MS) == pdTRUE) {
-        esp_vhci_host_send_packet_wrapper(data, len);
+        esp_vhci_host_send_packet_wrapper(pkt, len);
     } else {
         rc = BLE_HS_ETIMEOUT_HCI;
     }
@@ -167,6 +182,7 @@ static void ble_hci_rx_acl(uint8_t *data, uint16_t len)
         m = ble_transport_alloc_acl_from_ll();
 
         if (!m) {
+            acl_stats.rx_alloc_retries++;
             esp_rom_printf("Failed to allocate buffer, retrying ");
 	    /* Give some time to free buffer and try again */
 	    vTaskDelay(1);
@@ -178,6 +194,8 @@ static void ble_hci_rx_acl(uint8_t *data, uint16_t len)
         os_mbuf_free_chain(m);
         return;
     }
+    acl_stats.rx++;
+    acl_stats.rx_bytes += len;
     OS_ENTER_CRITICAL(sr);
     ble_transport_to_hs_acl(m);
     OS_EXIT_CRITICAL(sr);
@@ -309,6 +327,7 @@ esp_err_t esp_nimble_hci_init(void)
     }
 
     xSemaphoreGive(vhci_send_sem);
+    memset(&acl_stats, 0, sizeof(acl_stats));
 
 #if MYNEWT_VAL(BLE_QUEUE_CONG_CHECK)
     ble_adv_list_init();
@@ -321,6 +340,15 @@ err:
 
 }
 
+void esp_nimble_hci_acl_stats(struct esp_nimble_hci_acl_stats *stats)
+{
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *stats = acl_stats;
+    OS_EXIT_CRITICAL(sr);
+}
+
 extern void ble_transport_deinit(void);
 esp_err_t esp_nimble_hci_deinit(void)
 {
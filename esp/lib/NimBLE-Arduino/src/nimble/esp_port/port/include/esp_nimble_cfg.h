@@ -45,6 +45,70 @@
 #define MYNEWT_VAL_MSYS_2_BLOCK_SIZE CONFIG_BT_NIMBLE_MSYS_2_BLOCK_SIZE
 #endif
 
+#ifndef MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE
+#ifdef CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE (0)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE_SIZE
+#ifdef CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE_SIZE
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE_SIZE CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE_SIZE
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE_SIZE (4)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_OS_MEMPOOL_STATS
+#ifdef CONFIG_BT_NIMBLE_MEMPOOL_STATS
+#define MYNEWT_VAL_OS_MEMPOOL_STATS CONFIG_BT_NIMBLE_MEMPOOL_STATS
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_STATS (1)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_OS_MBUF_TRACE
+#ifdef CONFIG_BT_NIMBLE_MBUF_TRACE
+#define MYNEWT_VAL_OS_MBUF_TRACE CONFIG_BT_NIMBLE_MBUF_TRACE
+#else
+#define MYNEWT_VAL_OS_MBUF_TRACE (0)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_OS_MBUF_TRACE_MAX
+#ifdef CONFIG_BT_NIMBLE_MBUF_TRACE_MAX
+#define MYNEWT_VAL_OS_MBUF_TRACE_MAX CONFIG_BT_NIMBLE_MBUF_TRACE_MAX
+#else
+#define MYNEWT_VAL_OS_MBUF_TRACE_MAX (64)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_NPL_EVQ_BATCH_SIZE
+#ifdef CONFIG_BT_NIMBLE_EVQ_BATCH_SIZE
+#define MYNEWT_VAL_BLE_NPL_EVQ_BATCH_SIZE CONFIG_BT_NIMBLE_EVQ_BATCH_SIZE
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_BATCH_SIZE (8)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_NPL_EVQ_PRIORITY
+#ifdef CONFIG_BT_NIMBLE_EVQ_PRIORITY
+#define MYNEWT_VAL_BLE_NPL_EVQ_PRIORITY CONFIG_BT_NIMBLE_EVQ_PRIORITY
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_PRIORITY (1)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_NPL_EVQ_STATS
+#ifdef CONFIG_BT_NIMBLE_EVQ_STATS
+#define MYNEWT_VAL_BLE_NPL_EVQ_STATS CONFIG_BT_NIMBLE_EVQ_STATS
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_STATS (0)
+#endif
+#endif
+
 #ifndef MYNEWT_VAL_OS_CPUTIME_FREQ
 //#define MYNEWT_VAL_OS_CPUTIME_FREQ (1000000)
 #define MYNEWT_VAL_OS_CPUTIME_FREQ (32000)
@@ -615,8 +679,12 @@
 #endif
 
 #ifndef MYNEWT_VAL_BLE_EATT_MTU
+#ifdef CONFIG_BT_NIMBLE_EATT_MTU
+#define MYNEWT_VAL_BLE_EATT_MTU (CONFIG_BT_NIMBLE_EATT_MTU)
+#else
 #define MYNEWT_VAL_BLE_EATT_MTU (128)
 #endif
+#endif
 
 #ifndef MYNEWT_VAL_BLE_CLIENT_SUPPORTED_FEATURES
 
@@ -982,6 +1050,46 @@
 #define MYNEWT_VAL_BLE_CRYPTO_STACK_MBEDTLS (CONFIG_BT_NIMBLE_CRYPTO_STACK_MBEDTLS)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_HS_RESOLV_CACHE_SIZE
+#ifdef CONFIG_BT_NIMBLE_RPA_CACHE_SIZE
+#define MYNEWT_VAL_BLE_HS_RESOLV_CACHE_SIZE CONFIG_BT_NIMBLE_RPA_CACHE_SIZE
+#else
+#define MYNEWT_VAL_BLE_HS_RESOLV_CACHE_SIZE (16)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_SM_ALG_KEY_CACHE_SIZE
+#ifdef CONFIG_BT_NIMBLE_AES_KEY_CACHE_SIZE
+#define MYNEWT_VAL_BLE_SM_ALG_KEY_CACHE_SIZE CONFIG_BT_NIMBLE_AES_KEY_CACHE_SIZE
+#else
+#define MYNEWT_VAL_BLE_SM_ALG_KEY_CACHE_SIZE (4)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_CRYPTO_AES_TTABLE
+#ifdef CONFIG_BT_NIMBLE_CRYPTO_AES_TTABLE
+#define MYNEWT_VAL_BLE_CRYPTO_AES_TTABLE CONFIG_BT_NIMBLE_CRYPTO_AES_TTABLE
+#else
+#define MYNEWT_VAL_BLE_CRYPTO_AES_TTABLE (1)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_CRYPTO_ECC_COMB
+#ifdef CONFIG_BT_NIMBLE_CRYPTO_ECC_COMB
+#define MYNEWT_VAL_BLE_CRYPTO_ECC_COMB CONFIG_BT_NIMBLE_CRYPTO_ECC_COMB
+#else
+#define MYNEWT_VAL_BLE_CRYPTO_ECC_COMB (1)
+#endif
+#endif
+
+#ifndef MYNEWT_VAL_BLE_SM_PRECOMPUTE
+#ifdef CONFIG_BT_NIMBLE_SM_PRECOMPUTE
+#define MYNEWT_VAL_BLE_SM_PRECOMPUTE CONFIG_BT_NIMBLE_SM_PRECOMPUTE
+#else
+#define MYNEWT_VAL_BLE_SM_PRECOMPUTE (0)
+#endif
+#endif
+
 #ifndef MYNEWT_VAL_BLE_STORE_MAX_BONDS
 #define MYNEWT_VAL_BLE_STORE_MAX_BONDS CONFIG_BT_NIMBLE_MAX_BONDS
 #endif
@@ -1006,6 +1114,14 @@
 #endif
 #endif
 
+#ifndef MYNEWT_VAL_BLE_STORE_NVS_WRITE_BACK_MS
+#ifdef CONFIG_BT_NIMBLE_NVS_WRITE_BACK_MS
+#define MYNEWT_VAL_BLE_STORE_NVS_WRITE_BACK_MS CONFIG_BT_NIMBLE_NVS_WRITE_BACK_MS
+#else
+#define MYNEWT_VAL_BLE_STORE_NVS_WRITE_BACK_MS (0)
+#endif
+#endif
+
 
 /* Value copied from BLE_TRANSPORT_ACL_COUNT */
 #ifndef MYNEWT_VAL_BLE_TRANSPORT_ACL_FROM_LL_COUNT
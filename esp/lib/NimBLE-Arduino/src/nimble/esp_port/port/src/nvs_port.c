@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifdef ESP_PLATFORM
+
+#include "nimble/porting/nimble/include/syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_GATT_CACHING)
+
+#include "nvs.h"
+#include "nimble/porting/nimble/include/nimble/storage_port.h"
+
+static struct cache_fn_mapping cache_fn;
+
+static int
+nvs_open_custom(const char *namespace_name, open_mode_t open_mode, cache_handle_t *out_handle)
+{
+    switch (open_mode) {
+    case READWRITE:
+        return nvs_open(namespace_name, NVS_READWRITE, out_handle);
+    case READONLY:
+        return nvs_open(namespace_name, NVS_READONLY, out_handle);
+    default:
+        return -1;
+    }
+}
+
+static int
+nvs_erase_all_custom(cache_handle_t handle)
+{
+    int rc;
+
+    rc = nvs_erase_all(handle);
+    if (rc == 0) {
+        rc = nvs_commit(handle);
+    }
+    return rc;
+}
+
+static int
+nvs_write_custom(cache_handle_t handle, const char *key, const void *value, size_t length)
+{
+    int rc;
+
+    rc = nvs_set_blob(handle, key, value, length);
+    if (rc == 0) {
+        rc = nvs_commit(handle);
+    }
+    return rc;
+}
+
+static int
+nvs_read_custom(cache_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return nvs_get_blob(handle, key, out_value, length);
+}
+
+/**
+ * Returns the storage callbacks used by the GATT client cache. The cache is
+ * always kept in NVS on this port, so storage_cb is ignored.
+ */
+struct cache_fn_mapping
+link_storage_fn(void *storage_cb)
+{
+    (void)storage_cb;
+
+    cache_fn.open = nvs_open_custom;
+    cache_fn.close = nvs_close;
+    cache_fn.erase_all = nvs_erase_all_custom;
+    cache_fn.write = nvs_write_custom;
+    cache_fn.read = nvs_read_custom;
+    return cache_fn;
+}
+
+#endif /* MYNEWT_VAL(BLE_GATT_CACHING) */
+#endif /* ESP_PLATFORM */
@@ -303,6 +303,21 @@ void EccPoint_mult(uECC_word_t * result, const uECC_word_t * point,
 		   const uECC_word_t * scalar, const uECC_word_t * initial_Z,
 		   bitcount_t num_bits, uECC_Curve curve);
 
+/*
+ * @brief Point multiplication algorithm using a signed comb with a table of
+ * multiples of point built at run time. Runs the same sequence of operations
+ * for every scalar, in fewer field operations than EccPoint_mult.
+ * @note Result may overlap point. Only built with BLE_CRYPTO_ECC_COMB.
+ * @param result OUT -- returns scalar*point
+ * @param point IN -- elliptic curve point
+ * @param scalar IN -- scalar, in the range [1, n-1]
+ * @param initial_Z IN -- initial value for z, or 0
+ * @param curve IN -- elliptic curve
+ */
+void EccPoint_mult_comb(uECC_word_t * result, const uECC_word_t * point,
+			const uECC_word_t * scalar,
+			const uECC_word_t * initial_Z, uECC_Curve curve);
+
 /*
  * @brief Constant-time comparison to zero - secure way to compare long integers
  * @param vli IN -- very long integer
@@ -84,54 +84,52 @@ static void ccm_cbc_mac(uint8_t *T, const uint8_t *data, unsigned int dlen,
 }
 
 /**
- * Variation of CTR mode used in CCM.
- * The CTR mode used by CCM is slightly different than the conventional CTR
- * mode (the counter is increased before encryption, instead of after
- * encryption). Besides, it is assumed that the counter is stored in the last
- * 2 bytes of the nonce.
+ * CTR mode encryption or decryption of the payload fused with its CBC-MAC.
+ * The CTR mode used by CCM increments the counter, stored in the last 2
+ * bytes of ctr, before each block is encrypted. The MAC in T always covers
+ * the plaintext: the input when encrypting, the output when decrypting.
+ * A partial final block is zero padded for the MAC, as in ccm_cbc_mac().
+ * in and out may be the same buffer.
  */
-static int ccm_ctr_mode(uint8_t *out, unsigned int outlen, const uint8_t *in,
-			unsigned int inlen, uint8_t *ctr, const TCAesKeySched_t sched)
+static void ccm_ctr_cbc_mac(uint8_t *out, const uint8_t *in, unsigned int len,
+			    uint8_t *T, uint8_t *ctr, int decrypt,
+			    const TCAesKeySched_t sched)
 {
 
 	uint8_t buffer[TC_AES_BLOCK_SIZE];
-	uint8_t nonce[TC_AES_BLOCK_SIZE];
 	uint16_t block_num;
+	unsigned int n;
 	unsigned int i;
-
-	/* input sanity check: */
-	if (out == (uint8_t *) 0 ||
-	    in == (uint8_t *) 0 ||
-	    ctr == (uint8_t *) 0 ||
-	    sched == (TCAesKeySched_t) 0 ||
-	    inlen == 0 ||
-	    outlen == 0 ||
-	    outlen != inlen) {
-		return TC_CRYPTO_FAIL;
-	}
-
-	/* copy the counter to the nonce */
-	(void) _copy(nonce, sizeof(nonce), ctr, sizeof(nonce));
-
-	/* select the last 2 bytes of the nonce to be incremented */
-	block_num = (uint16_t) ((nonce[14] << 8)|(nonce[15]));
-	for (i = 0; i < inlen; ++i) {
-		if ((i % (TC_AES_BLOCK_SIZE)) == 0) {
-			block_num++;
-			nonce[14] = (uint8_t)(block_num >> 8);
-			nonce[15] = (uint8_t)(block_num);
-			if (!tc_aes_encrypt(buffer, nonce, sched)) {
-				return TC_CRYPTO_FAIL;
+	uint8_t p;
+
+	block_num = (uint16_t) ((ctr[14] << 8)|(ctr[15]));
+	while (len > 0) {
+		n = (len < TC_AES_BLOCK_SIZE) ? len : TC_AES_BLOCK_SIZE;
+
+		block_num++;
+		ctr[14] = (uint8_t)(block_num >> 8);
+		ctr[15] = (uint8_t)(block_num);
+		(void) tc_aes_encrypt(buffer, ctr, sched);
+
+		for (i = 0; i < n; ++i) {
+			if (decrypt) {
+				p = in[i] ^ buffer[i];
+				out[i] = p;
+			} else {
+				p = in[i];
+				out[i] = p ^ buffer[i];
 			}
+			T[i] ^= p;
 		}
-		/* update the output */
-		*out++ = buffer[i % (TC_AES_BLOCK_SIZE)] ^ *in++;
-	}
+		(void) tc_aes_encrypt(T, T, sched);
 
-	/* update the counter */
-	ctr[14] = nonce[14]; ctr[15] = nonce[15];
+		in += n;
+		out += n;
+		len -= n;
+	}
 
-	return TC_CRYPTO_SUCCESS;
+	/* zeroing out the keystream buffer */
+	_set(buffer, TC_ZERO_BYTE, sizeof(buffer));
 }
 
 int tc_ccm_generation_encryption(uint8_t *out, unsigned int olen,
@@ -165,14 +163,11 @@ int tc_ccm_generation_encryption(uint8_t *out, unsigned int olen,
 	b[14] = (uint8_t)(plen >> 8);
 	b[15] = (uint8_t)(plen);
 
-	/* computing the authentication tag using cbc-mac: */
+	/* starting the authentication tag using cbc-mac: */
 	(void) tc_aes_encrypt(tag, b, c->sched);
 	if (alen > 0) {
 		ccm_cbc_mac(tag, associated_data, alen, 1, c->sched);
 	}
-	if (plen > 0) {
-		ccm_cbc_mac(tag, payload, plen, 0, c->sched);
-	}
 
 	/* ENCRYPTION: */
 
@@ -180,8 +175,8 @@ int tc_ccm_generation_encryption(uint8_t *out, unsigned int olen,
 	b[0] = 1; /* q - 1 = 2 - 1 = 1 */
 	b[14] = b[15] = TC_ZERO_BYTE;
 
-	/* encrypting payload using ctr mode: */
-	ccm_ctr_mode(out, plen, payload, plen, b, c->sched);
+	/* encrypting payload using ctr mode and finishing the tag over it: */
+	ccm_ctr_cbc_mac(out, payload, plen, tag, b, 0, c->sched);
 
 	b[14] = b[15] = TC_ZERO_BYTE; /* restoring initial counter for ctr_mode (0):*/
 
@@ -213,20 +208,32 @@ int tc_ccm_decryption_verification(uint8_t *out, unsigned int olen,
   }
 
 	uint8_t b[Nb * Nk];
+	uint8_t mac[Nb * Nk];
 	uint8_t tag[Nb * Nk];
 	unsigned int i;
 
+	/* formatting the sequence b for authentication: */
+	b[0] = ((alen > 0) ? 0x40:0)|(((c->mlen - 2) / 2 << 3)) | (1);
+	for (i = 1; i < 14; ++i) {
+		b[i] = c->nonce[i - 1];
+	}
+	b[14] = (uint8_t)((plen - c->mlen) >> 8);
+	b[15] = (uint8_t)(plen - c->mlen);
+
+	/* starting the authentication tag using cbc-mac: */
+	(void) tc_aes_encrypt(mac, b, c->sched);
+	if (alen > 0) {
+		ccm_cbc_mac(mac, associated_data, alen, 1, c->sched);
+	}
+
 	/* DECRYPTION: */
 
 	/* formatting the sequence b for decryption: */
 	b[0] = 1; /* q - 1 = 2 - 1 = 1 */
-	for (i = 1; i < 14; ++i) {
-		b[i] = c->nonce[i - 1];
-	}
 	b[14] = b[15] = TC_ZERO_BYTE; /* initial counter value is 0 */
 
-	/* decrypting payload using ctr mode: */
-	ccm_ctr_mode(out, plen - c->mlen, payload, plen - c->mlen, b, c->sched);
+	/* decrypting payload using ctr mode and finishing the tag over it: */
+	ccm_ctr_cbc_mac(out, payload, plen - c->mlen, mac, b, 1, c->sched);
 
 	b[14] = b[15] = TC_ZERO_BYTE; /* restoring initial counter value (0) */
 
@@ -238,25 +245,8 @@ int tc_ccm_decryption_verification(uint8_t *out, unsigned int olen,
 
 	/* VERIFYING THE AUTHENTICATION TAG: */
 
-	/* formatting the sequence b for authentication: */
-	b[0] = ((alen > 0) ? 0x40:0)|(((c->mlen - 2) / 2 << 3)) | (1);
-	for (i = 1; i < 14; ++i) {
-		b[i] = c->nonce[i - 1];
-	}
-	b[14] = (uint8_t)((plen - c->mlen) >> 8);
-	b[15] = (uint8_t)(plen - c->mlen);
-
-	/* computing the authentication tag using cbc-mac: */
-	(void) tc_aes_encrypt(b, b, c->sched);
-	if (alen > 0) {
-		ccm_cbc_mac(b, associated_data, alen, 1, c->sched);
-	}
-	if (plen > 0) {
-		ccm_cbc_mac(b, out, plen - c->mlen, 0, c->sched);
-	}
-
 	/* comparing the received tag and the computed one: */
-	if (_compare(b, tag, c->mlen) == 0) {
+	if (_compare(mac, tag, c->mlen) == 0) {
 		return TC_CRYPTO_SUCCESS;
   	} else {
 		/* erase the decrypted buffer in case of mac validation failure: */
@@ -54,6 +54,7 @@
 
 #include <nimble/ext/tinycrypt/include/tinycrypt/ecc.h>
 #include <nimble/ext/tinycrypt/include/tinycrypt/ecc_platform_specific.h>
+#include <nimble/porting/nimble/include/syscfg/syscfg.h>
 #include <string.h>
 
 /* IMPORTANT: Make sure a cryptographically-secure PRNG is set and the platform
@@ -291,6 +292,52 @@ static void uECC_vli_mult(uECC_word_t *result, const uECC_word_t *left,
 	result[num_words * 2 - 1] = r0;
 }
 
+/* Like muladd(), but adds 2 * a * b. */
+static void mul2add(uECC_word_t a, uECC_word_t b, uECC_word_t *r0,
+		    uECC_word_t *r1, uECC_word_t *r2)
+{
+
+	uECC_dword_t p = (uECC_dword_t)a * b;
+	uECC_dword_t r01 = ((uECC_dword_t)(*r1) << uECC_WORD_BITS) | *r0;
+	*r2 += (p >> (uECC_WORD_BITS * 2 - 1));
+	p *= 2;
+	r01 += p;
+	*r2 += (r01 < p);
+	*r1 = r01 >> uECC_WORD_BITS;
+	*r0 = (uECC_word_t)r01;
+
+}
+
+/* Computes result = left^2, using each cross product once. Result must be
+ * 2 * num_words long. */
+static void uECC_vli_square(uECC_word_t *result, const uECC_word_t *left,
+			    wordcount_t num_words)
+{
+
+	uECC_word_t r0 = 0;
+	uECC_word_t r1 = 0;
+	uECC_word_t r2 = 0;
+	wordcount_t i, k;
+
+	for (k = 0; k < num_words * 2 - 1; ++k) {
+
+		i = (k < num_words) ? 0 : (k + 1) - num_words;
+		for (; i <= k && i <= k - i; ++i) {
+			if (i < k - i) {
+				mul2add(left[i], left[k - i], &r0, &r1, &r2);
+			} else {
+				muladd(left[i], left[k - i], &r0, &r1, &r2);
+			}
+		}
+
+		result[k] = r0;
+		r0 = r1;
+		r1 = r2;
+		r2 = 0;
+	}
+	result[num_words * 2 - 1] = r0;
+}
+
 void uECC_vli_modAdd(uECC_word_t *result, const uECC_word_t *left,
 		     const uECC_word_t *right, const uECC_word_t *mod,
 		     wordcount_t num_words)
@@ -383,7 +430,10 @@ static void uECC_vli_modSquare_fast(uECC_word_t *result,
 				    const uECC_word_t *left,
 				    uECC_Curve curve)
 {
-	uECC_vli_modMult_fast(result, left, left, curve);
+	uECC_word_t product[2 * NUM_ECC_WORDS];
+	uECC_vli_square(product, left, curve->num_words);
+
+	curve->mmod_fast(result, product);
 }
 
 
@@ -520,91 +570,42 @@ uECC_Curve uECC_secp256r1(void)
 
 void vli_mmod_fast_secp256r1(unsigned int *result, unsigned int*product)
 {
-	unsigned int tmp[NUM_ECC_WORDS];
+	const unsigned int *c = product;
+	int64_t acc;
 	int carry;
 
-	/* t */
-	uECC_vli_set(result, product, NUM_ECC_WORDS);
-
-	/* s1 */
-	tmp[0] = tmp[1] = tmp[2] = 0;
-	tmp[3] = product[11];
-	tmp[4] = product[12];
-	tmp[5] = product[13];
-	tmp[6] = product[14];
-	tmp[7] = product[15];
-	carry = uECC_vli_add(tmp, tmp, tmp, NUM_ECC_WORDS);
-	carry += uECC_vli_add(result, result, tmp, NUM_ECC_WORDS);
-
-	/* s2 */
-	tmp[3] = product[12];
-	tmp[4] = product[13];
-	tmp[5] = product[14];
-	tmp[6] = product[15];
-	tmp[7] = 0;
-	carry += uECC_vli_add(tmp, tmp, tmp, NUM_ECC_WORDS);
-	carry += uECC_vli_add(result, result, tmp, NUM_ECC_WORDS);
-
-	/* s3 */
-	tmp[0] = product[8];
-	tmp[1] = product[9];
-	tmp[2] = product[10];
-	tmp[3] = tmp[4] = tmp[5] = 0;
-	tmp[6] = product[14];
-	tmp[7] = product[15];
-  	carry += uECC_vli_add(result, result, tmp, NUM_ECC_WORDS);
-
-	/* s4 */
-	tmp[0] = product[9];
-	tmp[1] = product[10];
-	tmp[2] = product[11];
-	tmp[3] = product[13];
-	tmp[4] = product[14];
-	tmp[5] = product[15];
-	tmp[6] = product[13];
-	tmp[7] = product[8];
-	carry += uECC_vli_add(result, result, tmp, NUM_ECC_WORDS);
-
-	/* d1 */
-	tmp[0] = product[11];
-	tmp[1] = product[12];
-	tmp[2] = product[13];
-	tmp[3] = tmp[4] = tmp[5] = 0;
-	tmp[6] = product[8];
-	tmp[7] = product[10];
-	carry -= uECC_vli_sub(result, result, tmp, NUM_ECC_WORDS);
-
-	/* d2 */
-	tmp[0] = product[12];
-	tmp[1] = product[13];
-	tmp[2] = product[14];
-	tmp[3] = product[15];
-	tmp[4] = tmp[5] = 0;
-	tmp[6] = product[9];
-	tmp[7] = product[11];
-	carry -= uECC_vli_sub(result, result, tmp, NUM_ECC_WORDS);
-
-	/* d3 */
-	tmp[0] = product[13];
-	tmp[1] = product[14];
-	tmp[2] = product[15];
-	tmp[3] = product[8];
-	tmp[4] = product[9];
-	tmp[5] = product[10];
-	tmp[6] = 0;
-	tmp[7] = product[12];
-	carry -= uECC_vli_sub(result, result, tmp, NUM_ECC_WORDS);
-
-	/* d4 */
-	tmp[0] = product[14];
-	tmp[1] = product[15];
-	tmp[2] = 0;
-	tmp[3] = product[9];
-	tmp[4] = product[10];
-	tmp[5] = product[11];
-	tmp[6] = 0;
-	tmp[7] = product[13];
-	carry -= uECC_vli_sub(result, result, tmp, NUM_ECC_WORDS);
+	/* Sums the NIST terms t + 2 s1 + 2 s2 + s3 + s4 - d1 - d2 - d3 - d4 a
+	 * word at a time, so the carries are propagated once rather than once per
+	 * term. */
+	acc = (int64_t)c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14];
+	result[0] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15];
+	result[1] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+	result[2] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[3] + 2 * ((int64_t)c[11] + c[12]) + c[13] - c[15] -
+	       c[8] - c[9];
+	result[3] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[4] + 2 * ((int64_t)c[12] + c[13]) + c[14] - c[9] -
+	       c[10];
+	result[4] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[5] + 2 * ((int64_t)c[13] + c[14]) + c[15] - c[10] -
+	       c[11];
+	result[5] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[6] + 3 * (int64_t)c[14] + 2 * (int64_t)c[15] + c[13] -
+	       c[8] - c[9];
+	result[6] = (unsigned int)acc;
+	acc >>= 32;
+	acc += (int64_t)c[7] + 3 * (int64_t)c[15] + c[8] - c[10] - c[11] -
+	       c[12] - c[13];
+	result[7] = (unsigned int)acc;
+	carry = (int)(acc >> 32);
 
 	if (carry < 0) {
 		do {
@@ -788,11 +789,426 @@ uECC_word_t regularize_k(const uECC_word_t * const k, uECC_word_t *k0,
 	return carry;
 }
 
+#if MYNEWT_VAL(BLE_CRYPTO_ECC_COMB)
+
+/* ------ Signed comb point multiplication ------ */
+
+/* The scalar is made odd and recoded so that every comb column is an odd,
+ * signed value (see mbedtls ecp_comb_recode_core()). Each step is then one
+ * doubling and one mixed addition of a point picked from a table of
+ * 2^(w - 1) affine points, with a fixed sequence of operations for every
+ * scalar. The generator uses a 5 tooth comb from a table in flash, other
+ * points a 4 tooth comb built at run time. */
+#define COMB_G_TEETH 5
+#define COMB_G_COLS 52 /* ceil(256 / 5) */
+#define COMB_TEETH 4
+#define COMB_COLS 64 /* ceil(256 / 4) */
+#define COMB_MAX_POINTS (1 << (COMB_G_TEETH - 1))
+
+/* T[i] = G + sum(2^(j * COMB_G_COLS) * G) for each bit j - 1 set in i. */
+static const uECC_word_t comb_secp256r1_G[1 << (COMB_G_TEETH - 1)]
+					 [NUM_ECC_WORDS * 2] = {
+	{
+		BYTES_TO_WORDS_8(96, C2, 98, D8, 45, 39, A1, F4),
+		BYTES_TO_WORDS_8(A0, 33, EB, 2D, 81, 7D, 03, 77),
+		BYTES_TO_WORDS_8(F2, 40, A4, 63, E5, E6, BC, F8),
+		BYTES_TO_WORDS_8(47, 42, 2C, E1, F2, D1, 17, 6B),
+		BYTES_TO_WORDS_8(F5, 51, BF, 37, 68, 40, B6, CB),
+		BYTES_TO_WORDS_8(CE, 5E, 31, 6B, 57, 33, CE, 2B),
+		BYTES_TO_WORDS_8(16, 9E, 0F, 7C, 4A, EB, E7, 8E),
+		BYTES_TO_WORDS_8(9B, 7F, 1A, FE, E2, 42, E3, 4F)
+	},
+	{
+		BYTES_TO_WORDS_8(70, C8, BA, 04, B7, 4B, D2, F7),
+		BYTES_TO_WORDS_8(AB, C6, 23, 3A, A0, 09, 3A, 59),
+		BYTES_TO_WORDS_8(1D, 9D, 4C, F9, 58, 23, CC, DF),
+		BYTES_TO_WORDS_8(02, ED, 7B, 29, 87, 0F, FA, 3C),
+		BYTES_TO_WORDS_8(40, 69, F2, 40, 0B, A3, 98, CE),
+		BYTES_TO_WORDS_8(AF, A8, 48, 02, 0D, 1C, 12, 62),
+		BYTES_TO_WORDS_8(9B, AF, 09, 83, 80, AA, 58, A7),
+		BYTES_TO_WORDS_8(C6, 12, BE, 70, 94, 76, E3, E4)
+	},
+	{
+		BYTES_TO_WORDS_8(7D, 7D, EF, 86, FF, E3, 37, DD),
+		BYTES_TO_WORDS_8(DB, 86, 8B, 08, 27, 7C, D7, F6),
+		BYTES_TO_WORDS_8(91, 54, 4C, 25, 4F, 9A, FE, 28),
+		BYTES_TO_WORDS_8(5E, FD, F0, 6D, 37, 03, 69, D6),
+		BYTES_TO_WORDS_8(96, D5, DA, AD, 92, 49, F0, 9F),
+		BYTES_TO_WORDS_8(F9, 73, 43, 9E, AF, A7, D1, F3),
+		BYTES_TO_WORDS_8(67, 41, 07, DF, 78, 95, 3E, A1),
+		BYTES_TO_WORDS_8(22, 3D, D1, E6, 3C, A5, E2, 20)
+	},
+	{
+		BYTES_TO_WORDS_8(BF, 6A, 5D, 52, 35, D7, BF, AE),
+		BYTES_TO_WORDS_8(5A, A2, BE, 96, F4, F8, 02, C3),
+		BYTES_TO_WORDS_8(A4, 20, 49, 54, EA, B3, 82, DB),
+		BYTES_TO_WORDS_8(2E, DB, EA, 02, D1, 75, 1C, 62),
+		BYTES_TO_WORDS_8(F0, 85, F4, 9E, 4C, DC, 39, 89),
+		BYTES_TO_WORDS_8(63, 6D, C4, 57, D8, 03, 5D, 22),
+		BYTES_TO_WORDS_8(70, 7F, 2D, 52, 6F, C9, DA, 4F),
+		BYTES_TO_WORDS_8(9D, 64, FA, B4, FE, A4, C4, D7)
+	},
+	{
+		BYTES_TO_WORDS_8(2A, 37, B9, C0, AA, 59, C6, 8B),
+		BYTES_TO_WORDS_8(3F, 58, D9, ED, 58, 99, 65, F7),
+		BYTES_TO_WORDS_8(88, 7D, 26, 8C, 4A, F9, 05, 9F),
+		BYTES_TO_WORDS_8(9D, 73, 9A, C9, E7, 46, DC, 00),
+		BYTES_TO_WORDS_8(F2, D0, 55, DF, 00, 0A, F5, 4A),
+		BYTES_TO_WORDS_8(6A, BF, 56, 81, 2D, 20, EB, B5),
+		BYTES_TO_WORDS_8(11, C1, 28, 52, AB, E3, D1, 40),
+		BYTES_TO_WORDS_8(24, 34, 79, 45, 57, A5, 12, 03)
+	},
+	{
+		BYTES_TO_WORDS_8(EE, CF, B8, 7E, F7, 92, 96, 8D),
+		BYTES_TO_WORDS_8(3D, 01, 8C, 0D, 23, F2, E3, 05),
+		BYTES_TO_WORDS_8(59, 2E, E3, 84, 52, 7A, 34, 76),
+		BYTES_TO_WORDS_8(E5, A1, B0, 15, 90, E2, 53, 3C),
+		BYTES_TO_WORDS_8(D4, 98, E7, FA, A5, 7D, 8B, 53),
+		BYTES_TO_WORDS_8(91, 35, D2, 00, D1, 1B, 9F, 1B),
+		BYTES_TO_WORDS_8(3F, 69, 08, 9A, 72, F0, A9, 11),
+		BYTES_TO_WORDS_8(B3, FE, 0E, 14, DA, 7C, 0E, D3)
+	},
+	{
+		BYTES_TO_WORDS_8(83, F6, E8, F8, 87, F7, FC, 6D),
+		BYTES_TO_WORDS_8(90, BE, 7F, 3F, 7A, 2B, D7, 13),
+		BYTES_TO_WORDS_8(CF, 32, F2, 2D, 94, 6D, 42, FD),
+		BYTES_TO_WORDS_8(AD, 9A, E3, 5F, 42, BB, 84, ED),
+		BYTES_TO_WORDS_8(FC, 95, 29, 73, A1, 67, 3E, 02),
+		BYTES_TO_WORDS_8(E3, 30, 54, 35, 8E, 0A, DD, 67),
+		BYTES_TO_WORDS_8(03, D7, A1, 97, 61, 3B, F8, 0C),
+		BYTES_TO_WORDS_8(F2, 33, 3C, 58, 55, 34, 23, A3)
+	},
+	{
+		BYTES_TO_WORDS_8(99, 5D, 16, 5F, 7B, BC, BB, CE),
+		BYTES_TO_WORDS_8(61, EE, 4E, 8A, C1, 51, CC, 50),
+		BYTES_TO_WORDS_8(1F, 0D, 4D, 1B, 53, 23, 1D, B3),
+		BYTES_TO_WORDS_8(DA, 2A, 38, 66, 52, 84, E1, 95),
+		BYTES_TO_WORDS_8(5B, 9B, 83, 0A, 81, 4F, AD, AC),
+		BYTES_TO_WORDS_8(0F, FF, 42, 41, 6E, A9, A2, A0),
+		BYTES_TO_WORDS_8(2F, A1, 4F, 1F, 89, 82, AA, 3E),
+		BYTES_TO_WORDS_8(F3, B8, 0F, 6B, 8F, 8C, D6, 68)
+	},
+	{
+		BYTES_TO_WORDS_8(F1, B3, BB, 51, 69, A2, 11, 93),
+		BYTES_TO_WORDS_8(65, 4F, 0F, 8D, BD, 26, 0F, E8),
+		BYTES_TO_WORDS_8(B9, CB, EC, 6B, 34, C3, 3D, 9D),
+		BYTES_TO_WORDS_8(E4, 5D, 1E, 10, D5, 44, E2, 54),
+		BYTES_TO_WORDS_8(28, 9E, B1, F1, 6E, 4C, AD, B3),
+		BYTES_TO_WORDS_8(B7, E3, C2, 58, C0, FB, 34, 43),
+		BYTES_TO_WORDS_8(25, 9C, DF, 35, 07, 41, BD, 19),
+		BYTES_TO_WORDS_8(B6, 6E, 10, EC, 0E, EC, BB, D6)
+	},
+	{
+		BYTES_TO_WORDS_8(C8, CF, EF, 3F, 83, 1A, 88, E8),
+		BYTES_TO_WORDS_8(0B, 29, B5, B9, E0, C9, A3, AE),
+		BYTES_TO_WORDS_8(88, 46, 1E, 77, CD, 7E, B3, 10),
+		BYTES_TO_WORDS_8(B6, 21, D0, D4, A3, 16, 08, EE),
+		BYTES_TO_WORDS_8(A1, CA, A8, B3, BF, 29, 99, 8E),
+		BYTES_TO_WORDS_8(D1, F2, 05, C1, CF, 5D, 91, 48),
+		BYTES_TO_WORDS_8(9F, 01, 49, DB, 82, DF, 5F, 3A),
+		BYTES_TO_WORDS_8(E1, 06, 90, AD, E3, 38, A4, C4)
+	},
+	{
+		BYTES_TO_WORDS_8(C9, D2, 3A, E8, 03, C5, 6D, 5D),
+		BYTES_TO_WORDS_8(BE, 35, D0, AE, 1D, 7A, 9F, CA),
+		BYTES_TO_WORDS_8(33, 1E, D2, CB, AC, 88, 27, 55),
+		BYTES_TO_WORDS_8(F0, B9, 9C, E0, 31, DD, 99, 86),
+		BYTES_TO_WORDS_8(61, F9, 9B, 32, 96, 41, 58, 38),
+		BYTES_TO_WORDS_8(F9, 5A, 2A, B8, 96, 0E, B2, 4C),
+		BYTES_TO_WORDS_8(C1, 78, 2C, C7, 08, 99, 19, 24),
+		BYTES_TO_WORDS_8(B7, 59, 28, E9, 84, 54, E6, 16)
+	},
+	{
+		BYTES_TO_WORDS_8(DD, 38, 30, DB, 70, 2C, 0A, A2),
+		BYTES_TO_WORDS_8(7C, 5C, 9D, E9, D5, 46, 0B, 5F),
+		BYTES_TO_WORDS_8(83, 0B, 60, 4B, 37, 7D, B9, C9),
+		BYTES_TO_WORDS_8(5E, 24, F3, 3D, 79, 7F, 6C, 18),
+		BYTES_TO_WORDS_8(7F, E5, 1C, 4F, 60, 24, F7, 2A),
+		BYTES_TO_WORDS_8(ED, D8, E2, 91, 7F, 89, 49, 92),
+		BYTES_TO_WORDS_8(97, A7, 2E, 8D, 6A, B3, 39, 81),
+		BYTES_TO_WORDS_8(13, 89, B5, 9A, B8, 8D, 42, 9C)
+	},
+	{
+		BYTES_TO_WORDS_8(8D, 45, E6, 4B, 3F, 4F, 1E, 1F),
+		BYTES_TO_WORDS_8(47, 65, 5E, 59, 22, CC, 72, 5F),
+		BYTES_TO_WORDS_8(F1, 93, 1A, 27, 1E, 34, C5, 5B),
+		BYTES_TO_WORDS_8(63, F2, A5, 58, 5C, 15, 2E, C6),
+		BYTES_TO_WORDS_8(F4, 7F, BA, 58, 5A, 84, 6F, 5F),
+		BYTES_TO_WORDS_8(AD, A6, 36, 7E, DC, F7, E1, 67),
+		BYTES_TO_WORDS_8(04, 4D, AA, EE, 57, 76, 3A, D3),
+		BYTES_TO_WORDS_8(4E, 7E, 26, 18, 22, 23, 9F, FF)
+	},
+	{
+		BYTES_TO_WORDS_8(1D, 4C, 64, C7, 55, 02, 3F, E3),
+		BYTES_TO_WORDS_8(D8, 02, 90, BB, C3, EC, 30, 40),
+		BYTES_TO_WORDS_8(9F, 6F, 64, F4, 16, 69, 48, A4),
+		BYTES_TO_WORDS_8(FA, 44, 9C, 95, 0C, 7D, 67, 5E),
+		BYTES_TO_WORDS_8(44, 91, 8B, D8, D0, D7, E7, E2),
+		BYTES_TO_WORDS_8(1F, F9, 48, 62, 6F, A8, 93, 5D),
+		BYTES_TO_WORDS_8(EA, 3A, 99, 02, D5, 0B, 3D, E3),
+		BYTES_TO_WORDS_8(1E, D3, 00, 31, E6, 0C, 9F, 44)
+	},
+	{
+		BYTES_TO_WORDS_8(56, B2, AA, FD, 88, 15, DF, 52),
+		BYTES_TO_WORDS_8(4C, 35, 27, 31, 44, CD, C0, 68),
+		BYTES_TO_WORDS_8(53, F8, 91, A5, 71, 94, 84, 2A),
+		BYTES_TO_WORDS_8(92, CB, D0, 93, E9, 88, DA, E4),
+		BYTES_TO_WORDS_8(24, C6, 39, 16, 5D, A3, 1E, 6D),
+		BYTES_TO_WORDS_8(BA, 07, 37, 26, 36, 2A, FE, 60),
+		BYTES_TO_WORDS_8(51, BC, F3, D0, DE, 50, FC, 97),
+		BYTES_TO_WORDS_8(80, 2E, 06, 10, 15, 4D, FA, F7)
+	},
+	{
+		BYTES_TO_WORDS_8(27, 65, 69, 5B, 66, A2, 75, 2E),
+		BYTES_TO_WORDS_8(9C, 16, 00, 5A, B0, 30, 25, 1A),
+		BYTES_TO_WORDS_8(42, FB, 86, 42, 80, C1, C4, 76),
+		BYTES_TO_WORDS_8(5B, 1D, 83, 8E, 94, 01, 5F, 82),
+		BYTES_TO_WORDS_8(39, 37, 70, EF, 1F, A1, F0, DB),
+		BYTES_TO_WORDS_8(6A, 10, 5B, CE, C4, 9B, 6F, 10),
+		BYTES_TO_WORDS_8(50, 11, 11, 24, 4F, 4C, 79, 61),
+		BYTES_TO_WORDS_8(17, 3A, 72, BC, FE, 72, 58, 43)
+	}
+};
+
+/* Sets dest to src if cond is 1, leaves it if cond is 0, without branching. */
+static void vli_cond_set(uECC_word_t *dest, const uECC_word_t *src,
+			 uECC_word_t cond, wordcount_t num_words)
+{
+	uECC_word_t mask = (uECC_word_t)0 - cond;
+	wordcount_t i;
+
+	for (i = 0; i < num_words; ++i) {
+		dest[i] = (dest[i] & ~mask) | (src[i] & mask);
+	}
+}
+
+/* (X1, Y1, Z1) += (x2, y2), with P1 in jacobian and P2 in affine coordinates.
+ * The exceptional cases are branches, they only occur for a handful of
+ * scalars. */
+static void add_mixed(uECC_word_t * X1, uECC_word_t * Y1, uECC_word_t * Z1,
+		      const uECC_word_t * x2, const uECC_word_t * y2,
+		      uECC_Curve curve)
+{
+	uECC_word_t t1[NUM_ECC_WORDS];
+	uECC_word_t t2[NUM_ECC_WORDS];
+	uECC_word_t t3[NUM_ECC_WORDS];
+	uECC_word_t t4[NUM_ECC_WORDS];
+	wordcount_t num_words = curve->num_words;
+
+	if (uECC_vli_isZero(Z1, num_words)) {
+		/* P1 is the point at infinity. */
+		uECC_vli_set(X1, x2, num_words);
+		uECC_vli_set(Y1, y2, num_words);
+		uECC_vli_clear(Z1, num_words);
+		Z1[0] = 1;
+		return;
+	}
+
+	uECC_vli_modSquare_fast(t1, Z1, curve); /* t1 = z1^2 */
+	uECC_vli_modMult_fast(t2, t1, Z1, curve); /* t2 = z1^3 */
+	uECC_vli_modMult_fast(t1, t1, x2, curve); /* t1 = x2*z1^2 = U2 */
+	uECC_vli_modMult_fast(t2, t2, y2, curve); /* t2 = y2*z1^3 = S2 */
+	uECC_vli_modSub(t1, t1, X1, curve->p, num_words); /* t1 = U2 - x1 = H */
+	uECC_vli_modSub(t2, t2, Y1, curve->p, num_words); /* t2 = S2 - y1 = R */
+
+	if (uECC_vli_isZero(t1, num_words)) {
+		if (uECC_vli_isZero(t2, num_words)) {
+			/* P1 == P2 */
+			curve->double_jacobian(X1, Y1, Z1, curve);
+		} else {
+			/* P1 == -P2 */
+			uECC_vli_clear(Z1, num_words);
+		}
+		return;
+	}
+
+	uECC_vli_modMult_fast(Z1, Z1, t1, curve); /* z3 = z1*H */
+	uECC_vli_modSquare_fast(t3, t1, curve); /* t3 = H^2 */
+	uECC_vli_modMult_fast(t4, t3, t1, curve); /* t4 = H^3 */
+	uECC_vli_modMult_fast(t3, t3, X1, curve); /* t3 = x1*H^2 = V */
+	uECC_vli_modSquare_fast(X1, t2, curve); /* t1 = R^2 */
+	uECC_vli_modSub(X1, X1, t4, curve->p, num_words); /* t1 = R^2 - H^3 */
+	uECC_vli_modSub(X1, X1, t3, curve->p, num_words);
+	uECC_vli_modSub(X1, X1, t3, curve->p, num_words); /* x3 = R^2 - H^3 - 2V */
+	uECC_vli_modMult_fast(t4, t4, Y1, curve); /* t4 = y1*H^3 */
+	uECC_vli_modSub(t3, t3, X1, curve->p, num_words); /* t3 = V - x3 */
+	uECC_vli_modMult_fast(Y1, t3, t2, curve); /* t2 = R*(V - x3) */
+	uECC_vli_modSub(Y1, Y1, t4, curve->p, num_words); /* y3 */
+}
+
+/* Converts (X, Y, Z) to affine coordinates, the point at infinity to 0. */
+static void jacobian_to_affine(uECC_word_t * result, const uECC_word_t * X,
+			       const uECC_word_t * Y, const uECC_word_t * Z,
+			       uECC_Curve curve)
+{
+	uECC_word_t z[NUM_ECC_WORDS];
+	wordcount_t num_words = curve->num_words;
+
+	uECC_vli_set(result, X, num_words);
+	uECC_vli_set(result + num_words, Y, num_words);
+	if (uECC_vli_isZero(Z, num_words)) {
+		uECC_vli_clear(result, num_words * 2);
+		return;
+	}
+
+	uECC_vli_modInv(z, Z, curve->p, num_words);
+	apply_z(result, result + num_words, z, curve);
+}
+
+/* Recodes odd m into cols + 1 signed comb columns: bits 0 to teeth - 1 of
+ * x[i] are bits i + j * cols of m, bit 7 is the sign. Every column is odd. */
+static void comb_recode(uint8_t *x, const uECC_word_t *m, unsigned int teeth,
+			unsigned int cols, uECC_Curve curve)
+{
+	bitcount_t num_bits = curve->num_words * uECC_WORD_BITS;
+	unsigned int i, j;
+	bitcount_t bit;
+	uint8_t c, cc, adjust;
+
+	for (i = 0; i < cols; ++i) {
+		x[i] = 0;
+		for (j = 0; j < teeth; ++j) {
+			bit = i + j * cols;
+			if (bit < num_bits) {
+				x[i] |= (uECC_vli_testBit(m, bit) != 0) << j;
+			}
+		}
+	}
+	x[cols] = 0;
+
+	/* Makes x[1] to x[cols] odd, by borrowing from the column below:
+	 * x[i - 1] = -x[i - 1] + 2 * x[i - 1]. */
+	c = 0;
+	for (i = 1; i <= cols; ++i) {
+		cc = x[i] & c;
+		x[i] = x[i] ^ c;
+		c = cc;
+
+		adjust = 1 - (x[i] & 0x01);
+		c |= x[i] & (x[i - 1] * adjust);
+		x[i] = x[i] ^ (x[i - 1] * adjust);
+		x[i - 1] |= adjust << 7;
+	}
+}
+
+/* Sets (x, y) to the table point for column value v, reading every entry. */
+static void comb_select(uECC_word_t * x, uECC_word_t * y,
+			const uECC_word_t (*table)[NUM_ECC_WORDS * 2],
+			unsigned int num_points, uint8_t v, uECC_Curve curve)
+{
+	uECC_word_t neg[NUM_ECC_WORDS];
+	wordcount_t num_words = curve->num_words;
+	unsigned int index = (v & 0x7f) >> 1;
+	unsigned int i;
+
+	for (i = 0; i < num_points; ++i) {
+		vli_cond_set(x, table[i], i == index, num_words);
+		vli_cond_set(y, table[i] + num_words, i == index, num_words);
+	}
+
+	uECC_vli_sub(neg, curve->p, y, num_words);
+	vli_cond_set(y, neg, v >> 7, num_words);
+}
+
+static void comb_mult(uECC_word_t * result,
+		      const uECC_word_t (*table)[NUM_ECC_WORDS * 2],
+		      unsigned int teeth, unsigned int cols,
+		      const uECC_word_t * scalar, const uECC_word_t * initial_Z,
+		      uECC_Curve curve)
+{
+	uECC_word_t m[NUM_ECC_WORDS];
+	uECC_word_t X[NUM_ECC_WORDS];
+	uECC_word_t Y[NUM_ECC_WORDS];
+	uECC_word_t Z[NUM_ECC_WORDS];
+	uint8_t x[COMB_COLS + 1];
+	wordcount_t num_words = curve->num_words;
+	unsigned int num_points = 1 << (teeth - 1);
+	uECC_word_t odd = uECC_vli_testBit(scalar, 0) != 0;
+	unsigned int i;
+
+	/* k * P = -((n - k) * P), n - k is odd when k is even. */
+	uECC_vli_sub(m, curve->n, scalar, num_words);
+	vli_cond_set(m, scalar, odd, num_words);
+	comb_recode(x, m, teeth, cols, curve);
+
+	comb_select(X, Y, table, num_points, x[cols], curve);
+	uECC_vli_clear(Z, num_words);
+	Z[0] = 1;
+	if (initial_Z) {
+		apply_z(X, Y, initial_Z, curve);
+		uECC_vli_set(Z, initial_Z, num_words);
+	}
+
+	for (i = cols; i-- > 0;) {
+		curve->double_jacobian(X, Y, Z, curve);
+		comb_select(result, result + num_words, table, num_points, x[i],
+			    curve);
+		add_mixed(X, Y, Z, result, result + num_words, curve);
+	}
+
+	jacobian_to_affine(result, X, Y, Z, curve);
+	uECC_vli_sub(Y, curve->p, result + num_words, num_words);
+	vli_cond_set(result + num_words, Y, !odd &&
+		     !uECC_vli_isZero(result + num_words, num_words), num_words);
+
+	/* erasing temporary buffers used to store secrets: */
+	memset(m, 0, sizeof(m));
+	memset(x, 0, sizeof(x));
+}
+
+void EccPoint_mult_comb(uECC_word_t * result, const uECC_word_t * point,
+			const uECC_word_t * scalar,
+			const uECC_word_t * initial_Z, uECC_Curve curve)
+{
+	uECC_word_t table[1 << (COMB_TEETH - 1)][NUM_ECC_WORDS * 2];
+	uECC_word_t X[NUM_ECC_WORDS];
+	uECC_word_t Y[NUM_ECC_WORDS];
+	uECC_word_t Z[NUM_ECC_WORDS];
+	uECC_word_t Q[NUM_ECC_WORDS * 2];
+	wordcount_t num_words = curve->num_words;
+	unsigned int i, j, half;
+
+	/* table[i] = P + sum(2^(j * COMB_COLS) * P) for each bit j - 1 set in i,
+	 * built from Q = 2^(j * COMB_COLS) * P. */
+	uECC_vli_set(table[0], point, num_words * 2);
+	uECC_vli_set(Q, point, num_words * 2);
+	for (j = 1; j < COMB_TEETH; ++j) {
+		uECC_vli_set(X, Q, num_words);
+		uECC_vli_set(Y, Q + num_words, num_words);
+		uECC_vli_clear(Z, num_words);
+		Z[0] = 1;
+		for (i = 0; i < COMB_COLS; ++i) {
+			curve->double_jacobian(X, Y, Z, curve);
+		}
+		jacobian_to_affine(Q, X, Y, Z, curve);
+
+		half = 1 << (j - 1);
+		for (i = 0; i < half; ++i) {
+			uECC_vli_set(X, table[i], num_words);
+			uECC_vli_set(Y, table[i] + num_words, num_words);
+			uECC_vli_clear(Z, num_words);
+			Z[0] = 1;
+			add_mixed(X, Y, Z, Q, Q + num_words, curve);
+			jacobian_to_affine(table[half + i], X, Y, Z, curve);
+		}
+	}
+
+	comb_mult(result, (const uECC_word_t (*)[NUM_ECC_WORDS * 2])table,
+		  COMB_TEETH, COMB_COLS, scalar, initial_Z, curve);
+}
+
+#endif /* BLE_CRYPTO_ECC_COMB */
+
 uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
 					uECC_word_t *private_key,
 					uECC_Curve curve)
 {
 
+#if MYNEWT_VAL(BLE_CRYPTO_ECC_COMB)
+	/* The comb runs the same steps for every scalar, no regularizing needed. */
+	comb_mult(result, comb_secp256r1_G, COMB_G_TEETH, COMB_G_COLS, private_key,
+		  0, curve);
+#else
 	uECC_word_t tmp1[NUM_ECC_WORDS];
  	uECC_word_t tmp2[NUM_ECC_WORDS];
 	uECC_word_t *p2[2] = {tmp1, tmp2};
@@ -803,6 +1219,7 @@ uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
 	carry = regularize_k(private_key, tmp1, tmp2, curve);
 
 	EccPoint_mult(result, curve->G, p2[!carry], 0, curve->num_n_bits + 1, curve);
+#endif
 
 	if (EccPoint_isZero(result, curve)) {
 		return 0;
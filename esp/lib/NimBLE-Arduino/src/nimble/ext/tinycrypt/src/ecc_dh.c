@@ -57,6 +57,7 @@
 #include <nimble/ext/tinycrypt/include/tinycrypt/constants.h>
 #include <nimble/ext/tinycrypt/include/tinycrypt/ecc.h>
 #include <nimble/ext/tinycrypt/include/tinycrypt/ecc_dh.h>
+#include <nimble/porting/nimble/include/syscfg/syscfg.h>
 #include <string.h>
 
 #if default_RNG_defined
@@ -167,9 +168,15 @@ int uECC_shared_secret(const uint8_t *public_key, const uint8_t *private_key,
 			       public_key + num_bytes,
 			       num_bytes);
 
+#if MYNEWT_VAL(BLE_CRYPTO_ECC_COMB)
+	/* The comb does not depend on the bitcount of the private key, so it is
+	 * used as is and tmp only holds initial_Z. */
+	carry = 1;
+#else
 	/* Regularize the bitcount for the private key so that attackers cannot use a
 	 * side channel attack to learn the number of leading zeros. */
 	carry = regularize_k(_private, _private, tmp, curve);
+#endif
 
 	/* If an RNG function was specified, try to get a random initial Z value to
 	 * improve protection against side-channel attacks. */
@@ -181,8 +188,12 @@ int uECC_shared_secret(const uint8_t *public_key, const uint8_t *private_key,
     		initial_Z = p2[carry];
   	}
 
+#if MYNEWT_VAL(BLE_CRYPTO_ECC_COMB)
+	EccPoint_mult_comb(_public, _public, p2[!carry], initial_Z, curve);
+#else
 	EccPoint_mult(_public, _public, p2[!carry], initial_Z, curve->num_n_bits + 1,
 		      curve);
+#endif
 
 	uECC_vli_nativeToBytes(secret, num_bytes, _public);
 	r = !EccPoint_isZero(_public, curve);
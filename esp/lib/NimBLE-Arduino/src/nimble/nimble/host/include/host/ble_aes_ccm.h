@@ -12,9 +12,10 @@
 #include "nimble/nimble/host/include/host/ble_hs.h"
 
 #if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
-#include "nimble/ext/tinycrypt/include/tinycrypt/aes.h"
+#include "mbedtls/aes.h"
 #else
 #include "nimble/ext/tinycrypt/include/tinycrypt/aes.h"
+#include "nimble/ext/tinycrypt/include/tinycrypt/constants.h"
 #endif
 
 #ifdef __cplusplus
@@ -23,7 +24,24 @@ extern "C" {
 
 #if MYNEWT_VAL(ENC_ADV_DATA)
 
+/** An AES-CCM key with its expanded schedule. */
+struct ble_aes_ccm_key {
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    mbedtls_aes_context ctx;
+#else
+    struct tc_aes_key_sched_struct sched;
+#endif
+};
+
 const char *ble_aes_ccm_hex(const void *buf, size_t len);
+int ble_aes_ccm_key_set(struct ble_aes_ccm_key *ccm_key, const uint8_t key[16]);
+void ble_aes_ccm_key_clear(struct ble_aes_ccm_key *ccm_key);
+int ble_aes_ccm_decrypt_key(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
+                            const uint8_t *enc_msg, size_t msg_len, const uint8_t *aad,
+                            size_t aad_len, uint8_t *out_msg, size_t mic_size);
+int ble_aes_ccm_encrypt_key(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
+                            const uint8_t *msg, size_t msg_len, const uint8_t *aad,
+                            size_t aad_len, uint8_t *out_msg, size_t mic_size);
 int ble_aes_ccm_encrypt_be(const uint8_t *key, const uint8_t *plaintext, uint8_t *enc_data);
 int ble_aes_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_data,
                         size_t len, const uint8_t *aad, size_t aad_len,
@@ -350,6 +350,33 @@ int ble_att_set_preferred_mtu(uint16_t mtu);
 int ble_att_set_default_bearer_using_cid(uint16_t conn_handle, uint16_t cid);
 uint16_t ble_att_get_default_bearer_cid(uint16_t conn_handle);
 
+/** An ATT bearer of a connection. */
+struct ble_att_bearer_desc {
+    /** Local channel ID; BLE_L2CAP_CID_ATT for the unenhanced bearer. */
+    uint16_t cid;
+
+    /** The ATT MTU of the bearer. */
+    uint16_t mtu;
+
+    /** Client requests outstanding; only counted for Enhanced ATT bearers. */
+    uint8_t busy;
+};
+
+/**
+ * Retrieves the ATT bearers of the specified connection: the unenhanced
+ * bearer first, followed by each connected Enhanced ATT bearer.
+ *
+ * @param conn_handle           The handle of the connection to query.
+ * @param out_bearers           On success, the bearers are written here.
+ * @param max_bearers           The number of entries in out_bearers.
+ *
+ * @return                      The number of bearers written, or 0 if there
+ *                                  is no such connection.
+ */
+int ble_att_get_bearers(uint16_t conn_handle,
+                        struct ble_att_bearer_desc *out_bearers,
+                        int max_bearers);
+
 #ifdef __cplusplus
 }
 #endif
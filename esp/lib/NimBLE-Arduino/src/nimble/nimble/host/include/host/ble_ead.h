@@ -11,6 +11,7 @@
 #include <inttypes.h>
 #include "nimble/porting/nimble/include/syscfg/syscfg.h"
 #include "nimble/nimble/host/include/host/ble_gap.h"
+#include "nimble/nimble/host/include/host/ble_aes_ccm.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -115,12 +116,91 @@ int ble_ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE],
  *
  * @return                      0 on success;
  *                              BLE_HS_EINVAL if the specified value is not
- *                              within the allowed range.
+ *                              within the allowed range;
+ *                              BLE_HS_EAUTHEN if the MIC does not match, the
+ *                              payload is then wiped.
  */
 int ble_ead_decrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE],
                     const uint8_t iv[BLE_EAD_IV_SIZE], const uint8_t *encrypted_payload,
                     size_t encrypted_payload_size, uint8_t *payload);
 
+/**
+ * A Session Key and IV prepared for repeated use.  The key schedule is
+ * expanded once, so each encryption or decryption only runs the cipher.
+ */
+struct ble_ead_key {
+    struct ble_aes_ccm_key aes;
+    uint8_t iv[BLE_EAD_IV_SIZE];
+};
+
+/**
+ * @brief Prepare key material for ble_ead_encrypt_key() and
+ * ble_ead_decrypt_key().
+ *
+ * @key                 The context to initialise.
+ * @session_key         Key of BLE_EAD_KEY_SIZE bytes.
+ * @iv                  Initialisation Vector used to generate the nonce.
+ *
+ * @return              0 on success;
+ *                      BLE_HS_EINVAL if an argument is NULL;
+ *                      BLE_HS_EUNKNOWN if the key could not be expanded.
+ */
+int ble_ead_key_set(struct ble_ead_key *key,
+                    const uint8_t session_key[BLE_EAD_KEY_SIZE],
+                    const uint8_t iv[BLE_EAD_IV_SIZE]);
+
+/**
+ * @brief Wipe key material prepared by ble_ead_key_set().
+ */
+void ble_ead_key_clear(struct ble_ead_key *key);
+
+/**
+ * @brief Same as ble_ead_encrypt() with prepared key material.
+ */
+int ble_ead_encrypt_key(const struct ble_ead_key *key, const uint8_t *payload,
+                        size_t payload_size, uint8_t *encrypted_payload);
+
+/**
+ * @brief Same as ble_ead_decrypt() with prepared key material.
+ */
+int ble_ead_decrypt_key(const struct ble_ead_key *key,
+                        const uint8_t *encrypted_payload,
+                        size_t encrypted_payload_size, uint8_t *payload);
+
+/** One decryption for ble_ead_decrypt_batch(). */
+struct ble_ead_decrypt_op {
+    /** Key material of the advertiser, NULL to skip this entry. */
+    const struct ble_ead_key *key;
+
+    /** Encrypted Data of the advertising structure, without length and type. */
+    const uint8_t *encrypted_payload;
+
+    /** Size of encrypted_payload. */
+    size_t encrypted_payload_size;
+
+    /**
+     * Where the decrypted data is written, at least
+     * BLE_EAD_DECRYPTED_PAYLOAD_SIZE(encrypted_payload_size) bytes.
+     */
+    uint8_t *payload;
+
+    /** Set to the result of the decryption, as returned by ble_ead_decrypt(). */
+    int rc;
+};
+
+/**
+ * @brief Decrypt several Encrypted Data structures, possibly from
+ * different advertisers.
+ *
+ * Entries without key material are skipped and report BLE_HS_ENOENT.
+ *
+ * @ops                 The decryptions to perform.
+ * @num_ops             Number of entries in @p ops.
+ *
+ * @return              The number of entries decrypted and authenticated.
+ */
+int ble_ead_decrypt_batch(struct ble_ead_decrypt_op *ops, int num_ops);
+
 #endif /* ENC_ADV_DATA */
 
 #ifdef __cplusplus
@@ -694,6 +694,19 @@ int ble_gattc_read_by_uuid(uint16_t conn_handle, uint16_t start_handle,
 int ble_gattc_read_long(uint16_t conn_handle, uint16_t handle, uint16_t offset,
                         ble_gatt_attr_fn *cb, void *cb_arg);
 
+/**
+ * Retrieves the ATT MTU of the bearer that carried the request being
+ * reported to a Read Long Characteristic Values or Read Multiple Variable
+ * Length Characteristic Values callback.  With EATT the requests of a
+ * connection are spread over bearers of different MTUs, so a response
+ * shorter than the unenhanced bearer allows need not be complete.
+ *
+ * @return                      The bearer's ATT MTU;
+ *                              0 if not called from one of these callbacks
+ *                                  or the bearer no longer exists.
+ */
+uint16_t ble_gattc_read_bearer_mtu(void);
+
 /**
  * Initiates GATT procedure: Read Multiple Characteristic Values.
  *
@@ -955,7 +968,16 @@ int ble_gatts_indicate(uint16_t conn_handle, uint16_t chr_val_handle);
  */
 int ble_gattc_indicate(uint16_t conn_handle, uint16_t chr_val_handle);
 
-void ble_gattc_cache_conn_undisc_all(ble_addr_t peer_addr);
+/**
+ * Removes the cached attribute database of a peer.  Must be called from the
+ * host task.
+ *
+ * @param peer_addr             The identity address of the peer.
+ *
+ * @return                      0 if the cache entry was removed;
+ *                              BLE_HS_ENOENT if the peer has no cache entry.
+ */
+int ble_gattc_cache_conn_undisc_all(ble_addr_t peer_addr);
 
 /** Initialize the BLE GATT client. */
 int ble_gattc_init(void);
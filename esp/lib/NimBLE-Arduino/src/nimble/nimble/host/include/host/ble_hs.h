@@ -480,6 +480,55 @@ void ble_hs_init(void);
  */
 int ble_hs_shutdown(int reason);
 
+/** ACL transmit state of a connection. */
+struct ble_hs_conn_tx_state {
+    /** ACL packets handed to the controller and not yet transmitted. */
+    uint16_t outstanding;
+
+    /** Packets queued in the host waiting for a controller buffer. */
+    uint16_t queued;
+
+    /** Controller ACL buffers free, shared by all connections. */
+    uint16_t avail;
+
+    /** Controller ACL buffers in total. */
+    uint16_t total;
+};
+
+/**
+ * Reads how much of a connection's outgoing data is still held by the host
+ * and the controller.
+ *
+ * @param conn_handle           The connection to query.
+ * @param out_state             On success, the transmit state is written here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such connection.
+ */
+int ble_hs_conn_get_tx_state(uint16_t conn_handle,
+                             struct ble_hs_conn_tx_state *out_state);
+
+/**
+ * Called in the host task when the controller reports ACL packets of a
+ * connection as transmitted or flushed, or when the connection ends with
+ * packets still outstanding.
+ *
+ * @param conn_handle           The connection the packets belonged to.
+ * @param num_pkts              The number of packets completed.
+ * @param arg                   The argument given to ble_hs_set_tx_complete_cb().
+ */
+typedef void ble_hs_tx_complete_fn(uint16_t conn_handle, uint16_t num_pkts,
+                                   void *arg);
+
+/**
+ * Sets the function called when ACL packets have been transmitted.  Only one
+ * function can be set, it must not block.
+ *
+ * @param cb                    The function to call, NULL to stop.
+ * @param arg                   An argument passed to the function.
+ */
+void ble_hs_set_tx_complete_cb(ble_hs_tx_complete_fn *cb, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
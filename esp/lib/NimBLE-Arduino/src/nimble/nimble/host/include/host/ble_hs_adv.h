@@ -221,6 +221,60 @@ struct ble_hs_adv_fields {
 
 #define BLE_HS_ADV_ADV_ITVL_LONG_LEN            4
 
+/**
+ * Selective advertising data view.
+ *
+ * A view extracts only the AD types selected by its mask, in a single pass
+ * and without copying: each slot points into the caller's report buffer.
+ * The mask is normally a compile-time constant built from
+ * BLE_HS_ADV_VIEW_BIT() so that unrequested types cost a single test.
+ *
+ * AD types 0x01..0x3f map to the bit of the same number and manufacturer
+ * specific data (0xff) maps to bit 0; 0x00 is not a valid AD type and is
+ * never selected.
+ */
+#define BLE_HS_ADV_VIEW_BIT(type)                                           \
+    ((type) == BLE_HS_ADV_TYPE_MFG_DATA ? 1ULL :                            \
+     ((type) < 64 ? (1ULL << (type)) & ~1ULL : 0))
+
+/** Number of slots needed by a view selecting the types in mask. */
+#define BLE_HS_ADV_VIEW_NUM_FIELDS(mask)    __builtin_popcountll(mask)
+
+/** Defines a view and its slot storage for a constant selection mask. */
+#define BLE_HS_ADV_VIEW_DEFINE(name, mask)                                  \
+    struct ble_hs_adv_view_field name##_fields[                             \
+        BLE_HS_ADV_VIEW_NUM_FIELDS(mask)];                                  \
+    struct ble_hs_adv_view name = {                                         \
+        .want = (mask),                                                     \
+        .fields = name##_fields,                                            \
+    }
+
+struct ble_hs_adv_view_field {
+    /** Value of the first occurrence; points into the parsed buffer. */
+    const uint8_t *value;
+
+    /** Length of the first occurrence's value, excluding the type. */
+    uint8_t value_len;
+
+    /** Number of occurrences of this type in the buffer. */
+    uint16_t count;
+};
+
+struct ble_hs_adv_view {
+    /** Types to extract; set by the caller. */
+    uint64_t want;
+
+    /** Types that were present; filled in by the parser. */
+    uint64_t found;
+
+    /**
+     * One slot per bit set in want, in ascending bit order. Must hold
+     * BLE_HS_ADV_VIEW_NUM_FIELDS(want) entries. A slot is only valid if
+     * its type is set in found.
+     */
+    struct ble_hs_adv_view_field *fields;
+};
+
 int ble_hs_adv_set_fields_mbuf(const struct ble_hs_adv_fields *adv_fields,
                                struct os_mbuf *om);
 
@@ -233,6 +287,12 @@ int ble_hs_adv_parse_fields(struct ble_hs_adv_fields *adv_fields,
 int ble_hs_adv_parse(const uint8_t *data, uint8_t length,
                      ble_hs_adv_parse_func_t func, void *user_data);
 
+int ble_hs_adv_parse_view(struct ble_hs_adv_view *view,
+                          const uint8_t *data, uint16_t length);
+
+int ble_hs_adv_view_get(const struct ble_hs_adv_view *view, uint8_t type,
+                        const uint8_t **value, uint8_t *value_len);
+
 #ifdef __cplusplus
 }
 #endif
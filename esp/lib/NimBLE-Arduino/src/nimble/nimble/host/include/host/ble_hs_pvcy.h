@@ -66,6 +66,24 @@ extern "C" {
 int ble_hs_pvcy_rpa_config(uint8_t enable);
 
 void ble_hs_resolv_deinit(void);
+
+/** Counters for resolvable private address resolution in the host. */
+struct ble_hs_resolv_stats {
+    /** RPAs resolved from the resolution cache without any AES. */
+    uint32_t hits;
+    /** RPAs known from the cache not to resolve against any bonded IRK. */
+    uint32_t neg_hits;
+    /** RPAs that had to be resolved by trying bonded IRKs. */
+    uint32_t misses;
+    /** AES operations (ah() computations) performed to resolve RPAs. */
+    uint32_t aes_ops;
+};
+
+/* Reads the RPA resolution counters. */
+void ble_hs_resolv_stats(struct ble_hs_resolv_stats *out_stats);
+
+/* Clears the RPA resolution counters. */
+void ble_hs_resolv_stats_reset(void);
 #endif
 
 int ble_hs_pvcy_set_resolve_enabled(int enable);
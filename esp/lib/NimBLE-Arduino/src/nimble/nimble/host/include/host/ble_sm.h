@@ -119,6 +119,76 @@ int ble_sm_inject_io(uint16_t conn_handle, struct ble_sm_io *pkey);
     ((void)(conn_handle), BLE_HS_ENOTSUP)
 #endif
 
+#if NIMBLE_BLE_SM
+/** Counters for pairing and the key material it consumes. */
+struct ble_sm_pair_stats {
+    /** Pairings that completed successfully. */
+    uint32_t pairings;
+    /** Duration of the last pairing, from request to encryption, in ms. */
+    uint32_t last_ms;
+    /** Longest pairing duration, in ms. */
+    uint32_t max_ms;
+    /** Sum of all pairing durations, in ms. */
+    uint32_t total_ms;
+    /** P-256 key pairs generated on the host task during pairing. */
+    uint32_t keys_inline;
+    /** Time spent generating those key pairs, in ms. */
+    uint32_t keys_inline_ms;
+    /** P-256 key pairs taken ready-made from the precompute pool. */
+    uint32_t keys_precomputed;
+    /** Random bytes taken from the precompute pool. */
+    uint32_t rand_pool_bytes;
+    /** Random bytes read from the controller during pairing. */
+    uint32_t rand_hci_bytes;
+};
+
+/* Reads the pairing counters. */
+void ble_sm_pair_stats(struct ble_sm_pair_stats *out_stats);
+
+/* Clears the pairing counters. */
+void ble_sm_pair_stats_reset(void);
+
+#if MYNEWT_VAL(BLE_SM_SC)
+/**
+ * Sets when the local Secure Connections key pair is replaced.
+ *
+ * The key pair is reused across pairings and is only replaced when a new
+ * pairing starts with no other pairing in progress.  A pair used for OOB data
+ * is kept until the pairing that follows.
+ *
+ * @param max_pairings          Pairings a key pair may be used for,
+ *                                  0 for no limit.
+ * @param max_age_ms            Time a key pair may be used for in ms,
+ *                                  0 for no limit.
+ */
+void ble_sm_sc_set_key_reuse(uint16_t max_pairings, uint32_t max_age_ms);
+#endif
+
+#if MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+typedef void ble_sm_pre_kick_fn(void);
+
+/**
+ * Generates the next key pair and tops up the random pool used by pairing.
+ * Blocks for the duration of a key generation, so it should be called from
+ * a low priority task and not the host task.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTSYNCED if the host is not synced;
+ *                              other nonzero on error.
+ */
+int ble_sm_pre_fill(void);
+
+/**
+ * Sets the function called when pairing has consumed precomputed material.
+ * It should cause ble_sm_pre_fill() to run on the precompute task and must
+ * not block.
+ *
+ * @param cb                    The function to call, NULL to stop.
+ */
+void ble_sm_pre_set_kick_cb(ble_sm_pre_kick_fn *cb);
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -109,8 +109,80 @@ static inline void xor16(uint8_t *dst, const uint8_t *a, const uint8_t *b)
     dst[15] = a[15] ^ b[15];
 }
 
+/**
+ * Expands a key for use with ble_aes_ccm_encrypt_key() and
+ * ble_aes_ccm_decrypt_key().
+ *
+ * @param ccm_key               The key context to initialise.
+ * @param key                   The 128-bit key, in the byte order taken by
+ *                                  ble_aes_ccm_encrypt().
+ *
+ * @return                      0 on success; BLE_HS_EUNKNOWN on failure.
+ */
+int
+ble_aes_ccm_key_set(struct ble_aes_ccm_key *ccm_key, const uint8_t key[16])
+{
+    uint8_t key_reversed[16];
+    int rc;
+
+    /* Correcting the endian-ness of the key */
+    for (int i = 0; i < 16; i++) {
+        key_reversed[i] = key[15 - i];
+    }
+
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    mbedtls_aes_init(&ccm_key->ctx);
+    rc = mbedtls_aes_setkey_enc(&ccm_key->ctx, key_reversed, 128) == 0 ?
+         0 : BLE_HS_EUNKNOWN;
+    if (rc != 0) {
+        mbedtls_aes_free(&ccm_key->ctx);
+    }
+#else
+    rc = tc_aes128_set_encrypt_key(&ccm_key->sched, key_reversed) ==
+         TC_CRYPTO_FAIL ? BLE_HS_EUNKNOWN : 0;
+#endif
+
+    memset(key_reversed, 0, sizeof key_reversed);
+
+    return rc;
+}
+
+/**
+ * Wipes a key expanded by ble_aes_ccm_key_set().
+ */
+void
+ble_aes_ccm_key_clear(struct ble_aes_ccm_key *ccm_key)
+{
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    mbedtls_aes_free(&ccm_key->ctx);
+#else
+    memset(&ccm_key->sched, 0, sizeof ccm_key->sched);
+#endif
+}
+
+static int
+ble_aes_ccm_block(const struct ble_aes_ccm_key *ccm_key, const uint8_t *in,
+                  uint8_t *out)
+{
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    /* mbedtls does not modify the context when encrypting. */
+    if (mbedtls_aes_crypt_ecb((mbedtls_aes_context *)&ccm_key->ctx,
+                              MBEDTLS_AES_ENCRYPT, in, out) != 0) {
+        return BLE_HS_EUNKNOWN;
+    }
+#else
+    if (tc_aes_encrypt(out, in, (TCAesKeySched_t)&ccm_key->sched) ==
+        TC_CRYPTO_FAIL) {
+        return BLE_HS_EUNKNOWN;
+    }
+#endif
+
+    return 0;
+}
+
 /* pmsg is assumed to have the nonce already present in bytes 1-13 */
-static int ble_aes_ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t aad_len,
+static int ble_aes_ccm_calculate_X0(const struct ble_aes_ccm_key *key,
+                                    const uint8_t *aad, uint8_t aad_len,
                                     size_t mic_size, uint8_t msg_len, uint8_t b[16],
                                     uint8_t X0[16])
 {
@@ -121,7 +193,7 @@ static int ble_aes_ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, u
 
     sys_put_be16(msg_len, b + 14);
 
-    err = ble_aes_ccm_encrypt_be(key, b, X0);
+    err = ble_aes_ccm_block(key, b, X0);
     if (err) {
         return err;
     }
@@ -145,7 +217,7 @@ static int ble_aes_ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, u
             aad_len -= 16;
             i = 0;
 
-            err = ble_aes_ccm_encrypt_be(key, b, X0);
+            err = ble_aes_ccm_block(key, b, X0);
             if (err) {
                 return err;
             }
@@ -159,7 +231,7 @@ static int ble_aes_ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, u
             b[i] = X0[i];
         }
 
-        err = ble_aes_ccm_encrypt_be(key, b, X0);
+        err = ble_aes_ccm_block(key, b, X0);
         if (err) {
             return err;
         }
@@ -168,7 +240,7 @@ static int ble_aes_ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, u
     return 0;
 }
 
-static int ble_aes_ccm_auth(const uint8_t key[16], uint8_t nonce[13],
+static int ble_aes_ccm_auth(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
                             const uint8_t *cleartext_msg, size_t msg_len, const uint8_t *aad,
                             size_t aad_len, uint8_t *mic, size_t mic_size)
 {
@@ -188,12 +260,15 @@ static int ble_aes_ccm_auth(const uint8_t key[16], uint8_t nonce[13],
     /* S[0] = e(AppKey, 0x01 || nonce || 0x0000) */
     sys_put_be16(0x0000, &b[14]);
 
-    err = ble_aes_ccm_encrypt_be(key, b, s0);
+    err = ble_aes_ccm_block(key, b, s0);
     if (err) {
         return err;
     }
 
-    ble_aes_ccm_calculate_X0(key, aad, aad_len, mic_size, msg_len, b, Xn);
+    err = ble_aes_ccm_calculate_X0(key, aad, aad_len, mic_size, msg_len, b, Xn);
+    if (err) {
+        return err;
+    }
 
     for (j = 0; j < blk_cnt; j++) {
         /* X_1 = e(AppKey, X_0 ^ Payload[0-15]) */
@@ -207,7 +282,7 @@ static int ble_aes_ccm_auth(const uint8_t key[16], uint8_t nonce[13],
             xor16(b, Xn, &cleartext_msg[j * 16]);
         }
 
-        err = ble_aes_ccm_encrypt_be(key, b, Xn);
+        err = ble_aes_ccm_block(key, b, Xn);
         if (err) {
             return err;
         }
@@ -221,7 +296,7 @@ static int ble_aes_ccm_auth(const uint8_t key[16], uint8_t nonce[13],
     return 0;
 }
 
-static int ble_aes_ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
+static int ble_aes_ccm_crypt(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
                              const uint8_t *in_msg, uint8_t *out_msg, size_t msg_len)
 {
     uint8_t a_i[16], s_i[16];
@@ -242,7 +317,7 @@ static int ble_aes_ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
         /* S_1 = e(AppKey, 0x01 || nonce || 0x0001) */
         sys_put_be16(j + 1, &a_i[14]);
 
-        err = ble_aes_ccm_encrypt_be(key, a_i, s_i);
+        err = ble_aes_ccm_block(key, a_i, s_i);
         if (err) {
             return err;
         }
@@ -260,59 +335,113 @@ static int ble_aes_ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
     return 0;
 }
 
-int ble_aes_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_msg,
-                        size_t msg_len, const uint8_t *aad, size_t aad_len,
-                        uint8_t *out_msg, size_t mic_size)
+/**
+ * Decrypts a message and checks its MIC, which follows the message in
+ * enc_msg.  On a MIC mismatch the output is wiped.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EAUTHEN if the MIC does not match;
+ *                              BLE_HS_EINVAL or BLE_HS_EUNKNOWN on error.
+ */
+int ble_aes_ccm_decrypt_key(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
+                            const uint8_t *enc_msg, size_t msg_len, const uint8_t *aad,
+                            size_t aad_len, uint8_t *out_msg, size_t mic_size)
 {
     uint8_t mic[16];
-    uint8_t key_reversed[16];
+    uint8_t diff = 0;
+    int err;
 
     if (aad_len >= 0xff00 || mic_size > sizeof(mic)) {
         return BLE_HS_EINVAL;
     }
 
-    /** Setting the correct endian-ness of the key */
-    for (int i = 0; i < 16; i++) {
-        key_reversed[i] = key[15 - i];
+    err = ble_aes_ccm_crypt(key, nonce, enc_msg, out_msg, msg_len);
+    if (err == 0) {
+        err = ble_aes_ccm_auth(key, nonce, out_msg, msg_len, aad, aad_len, mic, mic_size);
     }
 
-    ble_aes_ccm_crypt(key_reversed, nonce, enc_msg, out_msg, msg_len);
+    if (err == 0) {
+        for (size_t i = 0; i < mic_size; i++) {
+            diff |= mic[i] ^ enc_msg[msg_len + i];
+        }
 
-    ble_aes_ccm_auth(key_reversed, nonce, out_msg, msg_len, aad, aad_len, mic, mic_size);
+        if (diff != 0) {
+            err = BLE_HS_EAUTHEN;
+        }
+    }
 
-    /*if (memcmp(mic, enc_msg + msg_len, mic_size)) {
-        printf("\n%s return here", __func__);
-        return -EBADMSG;
-    }*/
+    if (err != 0) {
+        memset(out_msg, 0, msg_len);
+    }
 
-    return 0;
+    return err;
 }
 
-int ble_aes_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *msg,
-                        size_t msg_len, const uint8_t *aad, size_t aad_len,
-                        uint8_t *out_msg, size_t mic_size)
+/**
+ * Encrypts a message and appends its MIC to out_msg.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EINVAL or BLE_HS_EUNKNOWN on error.
+ */
+int ble_aes_ccm_encrypt_key(const struct ble_aes_ccm_key *key, const uint8_t nonce[13],
+                            const uint8_t *msg, size_t msg_len, const uint8_t *aad,
+                            size_t aad_len, uint8_t *out_msg, size_t mic_size)
 {
     /** MIC starts after encrypted message and is part of encrypted advertisement data */
     uint8_t *mic = out_msg + msg_len;
-    uint8_t key_reversed[16];
+    int err;
 
     /* Unsupported AAD size */
     if (aad_len >= 0xff00 || mic_size > 16) {
         return BLE_HS_EINVAL;
     }
 
-    /* Correcting the endian-ness of the key */
-    for (int i = 0; i < 16; i++) {
-        key_reversed[i] = key[15 - i];
-    }
-
     /** Calculating MIC */
-    ble_aes_ccm_auth(key_reversed, nonce, msg, msg_len, aad, aad_len, mic, mic_size);
+    err = ble_aes_ccm_auth(key, nonce, msg, msg_len, aad, aad_len, mic, mic_size);
+    if (err) {
+        return err;
+    }
 
     /** Encrypting advertisment */
-    ble_aes_ccm_crypt(key_reversed, nonce, msg, out_msg, msg_len);
+    return ble_aes_ccm_crypt(key, nonce, msg, out_msg, msg_len);
+}
 
-    return 0;
+int ble_aes_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_msg,
+                        size_t msg_len, const uint8_t *aad, size_t aad_len,
+                        uint8_t *out_msg, size_t mic_size)
+{
+    struct ble_aes_ccm_key ccm_key;
+    int err;
+
+    err = ble_aes_ccm_key_set(&ccm_key, key);
+    if (err) {
+        return err;
+    }
+
+    err = ble_aes_ccm_decrypt_key(&ccm_key, nonce, enc_msg, msg_len, aad, aad_len,
+                                  out_msg, mic_size);
+    ble_aes_ccm_key_clear(&ccm_key);
+
+    return err;
+}
+
+int ble_aes_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *msg,
+                        size_t msg_len, const uint8_t *aad, size_t aad_len,
+                        uint8_t *out_msg, size_t mic_size)
+{
+    struct ble_aes_ccm_key ccm_key;
+    int err;
+
+    err = ble_aes_ccm_key_set(&ccm_key, key);
+    if (err) {
+        return err;
+    }
+
+    err = ble_aes_ccm_encrypt_key(&ccm_key, nonce, msg, msg_len, aad, aad_len,
+                                  out_msg, mic_size);
+    ble_aes_ccm_key_clear(&ccm_key);
+
+    return err;
 }
 
 #endif /* ENC_ADV_DATA */
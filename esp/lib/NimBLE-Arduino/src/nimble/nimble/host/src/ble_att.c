@@ -746,6 +746,40 @@ ble_att_get_default_bearer_cid(uint16_t conn_handle) {
     return 0;
 }
 
+int
+ble_att_get_bearers(uint16_t conn_handle,
+                    struct ble_att_bearer_desc *out_bearers,
+                    int max_bearers)
+{
+    uint16_t mtu;
+    int n;
+
+    if (max_bearers <= 0) {
+        return 0;
+    }
+
+    mtu = ble_att_mtu(conn_handle);
+    if (mtu == 0) {
+        return 0;
+    }
+
+    out_bearers[0].cid = BLE_L2CAP_CID_ATT;
+    out_bearers[0].mtu = mtu;
+    out_bearers[0].busy = 0;
+    n = 1;
+
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+    if (ble_hs_cfg.eatt) {
+        ble_hs_lock();
+        n += ble_eatt_get_bearers(conn_handle, out_bearers + 1,
+                                  max_bearers - 1);
+        ble_hs_unlock();
+    }
+#endif
+
+    return n;
+}
+
 int
 ble_att_init(void)
 {
@@ -154,6 +154,7 @@ int ble_att_svr_deregister(uint16_t start_handle, uint16_t end_group_handle);
 #if MYNEWT_VAL(BLE_GATT_CACHING)
 int ble_att_get_database_size(int *out_size);
 int ble_att_fill_database_info(uint8_t *out_data);
+uint32_t ble_att_svr_db_generation(void);
 #endif
 
 
@@ -164,6 +165,8 @@ struct ble_att_svr_entry {
     uint8_t ha_flags;
     uint8_t ha_min_key_size;
     uint16_t ha_handle_id;
+    /* Handle of the next visible attribute with the same UUID; 0 if none. */
+    uint16_t ha_uuid_next;
     ble_att_svr_access_fn *ha_cb;
     void *ha_cb_arg;
 };
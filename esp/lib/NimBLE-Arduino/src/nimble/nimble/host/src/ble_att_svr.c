@@ -57,6 +57,30 @@ static struct ble_att_svr_entry_list ble_att_svr_hidden_list;
 
 static uint16_t ble_att_svr_id;
 
+/**
+ * Attribute lookup indexes.  The handle index maps each handle to its visible
+ * entry (NULL for hidden or removed attributes); handles are allocated
+ * sequentially so it is a plain array.  The UUID index is sorted by UUID and
+ * holds the lowest visible handle of each attribute type, further entries of
+ * the same type are chained through ha_uuid_next.  The UUID index is rebuilt
+ * lazily on the first UUID lookup after the table changes.
+ */
+struct ble_att_svr_uuid_head {
+    const ble_uuid_t *uuid;
+    uint16_t first;
+};
+
+static struct ble_att_svr_entry **ble_att_svr_idx;
+static uint32_t ble_att_svr_idx_cap;
+
+static struct ble_att_svr_uuid_head *ble_att_svr_uuid_idx;
+static uint16_t ble_att_svr_uuid_idx_cnt;
+static uint16_t ble_att_svr_uuid_idx_cap;
+static uint8_t ble_att_svr_uuid_idx_dirty;
+
+/** Bumped whenever the visible attribute table changes. */
+static uint32_t ble_att_svr_db_gen;
+
 static void *ble_att_svr_entry_mem;
 static struct os_mempool ble_att_svr_entry_pool;
 
@@ -101,6 +125,187 @@ ble_att_svr_entry_free(struct ble_att_svr_entry *entry)
 #endif
 }
 
+/**
+ * Ensures the handle index can hold handles up to count - 1.
+ *
+ * @return 0 on success; BLE_HS_ENOMEM on allocation failure.
+ */
+static int
+ble_att_svr_idx_reserve(uint32_t count)
+{
+    struct ble_att_svr_entry **idx;
+    uint32_t cap;
+
+    if (count <= ble_att_svr_idx_cap) {
+        return 0;
+    }
+
+    cap = ble_att_svr_idx_cap * 2;
+    if (cap < count) {
+        cap = count;
+    }
+    if (cap > (uint32_t)UINT16_MAX + 1) {
+        cap = (uint32_t)UINT16_MAX + 1;
+    }
+
+    idx = nimble_platform_mem_malloc(cap * sizeof *idx);
+    if (idx == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    if (ble_att_svr_idx != NULL) {
+        memcpy(idx, ble_att_svr_idx, ble_att_svr_idx_cap * sizeof *idx);
+        nimble_platform_mem_free(ble_att_svr_idx);
+    }
+    memset(idx + ble_att_svr_idx_cap, 0,
+           (cap - ble_att_svr_idx_cap) * sizeof *idx);
+
+    ble_att_svr_idx = idx;
+    ble_att_svr_idx_cap = cap;
+    return 0;
+}
+
+static void
+ble_att_svr_idx_set(uint16_t handle_id, struct ble_att_svr_entry *entry)
+{
+    if (handle_id < ble_att_svr_idx_cap) {
+        ble_att_svr_idx[handle_id] = entry;
+    }
+    ble_att_svr_uuid_idx_dirty = 1;
+    ble_att_svr_db_gen++;
+}
+
+static void
+ble_att_svr_idx_free(void)
+{
+    nimble_platform_mem_free(ble_att_svr_idx);
+    ble_att_svr_idx = NULL;
+    ble_att_svr_idx_cap = 0;
+
+    nimble_platform_mem_free(ble_att_svr_uuid_idx);
+    ble_att_svr_uuid_idx = NULL;
+    ble_att_svr_uuid_idx_cnt = 0;
+    ble_att_svr_uuid_idx_cap = 0;
+    ble_att_svr_uuid_idx_dirty = 1;
+}
+
+/**
+ * Binary searches the UUID index.
+ *
+ * @param out_pos               On success, the position of the UUID; on
+ *                                  failure, the position it would be inserted
+ *                                  at.
+ *
+ * @return 0 if found; BLE_HS_ENOENT otherwise.
+ */
+static int
+ble_att_svr_uuid_idx_find(const ble_uuid_t *uuid, uint16_t *out_pos)
+{
+    uint16_t lo;
+    uint16_t hi;
+    uint16_t mid;
+    int cmp;
+
+    lo = 0;
+    hi = ble_att_svr_uuid_idx_cnt;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        cmp = ble_uuid_cmp(ble_att_svr_uuid_idx[mid].uuid, uuid);
+        if (cmp == 0) {
+            *out_pos = mid;
+            return 0;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *out_pos = lo;
+    return BLE_HS_ENOENT;
+}
+
+/**
+ * Rebuilds the UUID index from the handle index.
+ *
+ * @return 0 on success; BLE_HS_ENOMEM on allocation failure, in which case
+ *             UUID lookups fall back to walking the attribute list.
+ */
+static int
+ble_att_svr_uuid_idx_build(void)
+{
+    struct ble_att_svr_uuid_head *head;
+    struct ble_att_svr_entry *entry;
+    uint16_t num_entries;
+    uint16_t pos;
+    uint16_t h;
+
+    num_entries = 0;
+    STAILQ_FOREACH(entry, &ble_att_svr_list, ha_next) {
+        num_entries++;
+    }
+
+    if (num_entries > ble_att_svr_uuid_idx_cap) {
+        nimble_platform_mem_free(ble_att_svr_uuid_idx);
+        ble_att_svr_uuid_idx_cap = 0;
+        ble_att_svr_uuid_idx =
+            nimble_platform_mem_malloc(num_entries * sizeof *ble_att_svr_uuid_idx);
+        if (ble_att_svr_uuid_idx == NULL) {
+            return BLE_HS_ENOMEM;
+        }
+        ble_att_svr_uuid_idx_cap = num_entries;
+    }
+
+    /* Walk the handles backwards so each entry is pushed to the front of its
+     * chain, leaving the chains in ascending handle order.
+     */
+    ble_att_svr_uuid_idx_cnt = 0;
+    for (h = ble_att_svr_id; h > 0; h--) {
+        if (h >= ble_att_svr_idx_cap || ble_att_svr_idx[h] == NULL) {
+            continue;
+        }
+        entry = ble_att_svr_idx[h];
+
+        if (ble_att_svr_uuid_idx_find(entry->ha_uuid, &pos) != 0) {
+            memmove(ble_att_svr_uuid_idx + pos + 1, ble_att_svr_uuid_idx + pos,
+                    (ble_att_svr_uuid_idx_cnt - pos) *
+                    sizeof *ble_att_svr_uuid_idx);
+            ble_att_svr_uuid_idx[pos].uuid = entry->ha_uuid;
+            ble_att_svr_uuid_idx[pos].first = 0;
+            ble_att_svr_uuid_idx_cnt++;
+        }
+
+        head = ble_att_svr_uuid_idx + pos;
+        entry->ha_uuid_next = head->first;
+        head->first = h;
+    }
+
+    ble_att_svr_uuid_idx_dirty = 0;
+    return 0;
+}
+
+/**
+ * Finds the first visible attribute with a handle greater than or equal to
+ * the specified handle.
+ */
+static struct ble_att_svr_entry *
+ble_att_svr_find_from(uint16_t start_handle)
+{
+    uint32_t h;
+
+    for (h = start_handle > 0 ? start_handle : 1;
+         h <= ble_att_svr_id && h < ble_att_svr_idx_cap;
+         h++) {
+
+        if (ble_att_svr_idx[h] != NULL) {
+            return ble_att_svr_idx[h];
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Allocate the next handle id and return it.
  *
@@ -137,6 +342,11 @@ ble_att_svr_register(const ble_uuid_t *uuid, uint8_t flags,
         return BLE_HS_ENOMEM;
     }
 
+    if (ble_att_svr_idx_reserve((uint32_t)ble_att_svr_id + 2) != 0) {
+        ble_att_svr_entry_free(entry);
+        return BLE_HS_ENOMEM;
+    }
+
     entry->ha_uuid = uuid;
     entry->ha_flags = flags;
     entry->ha_min_key_size = min_key_size;
@@ -145,6 +355,7 @@ ble_att_svr_register(const ble_uuid_t *uuid, uint8_t flags,
     entry->ha_cb_arg = cb_arg;
 
     STAILQ_INSERT_TAIL(&ble_att_svr_list, entry, ha_next);
+    ble_att_svr_idx_set(entry->ha_handle_id, entry);
 
     if (handle_id != NULL) {
         *handle_id = entry->ha_handle_id;
@@ -167,7 +378,11 @@ int ble_att_svr_deregister(uint16_t start_handle, uint16_t end_group_handle) {
     struct ble_att_svr_entry *entry;
     for (idx = start_handle; idx <= end_group_handle; idx++) {
         entry = ble_att_svr_find_by_handle(idx);
+        if (entry == NULL) {
+            continue;
+        }
         STAILQ_REMOVE(&ble_att_svr_list, entry, ble_att_svr_entry, ha_next);
+        ble_att_svr_idx_set(idx, NULL);
         ble_att_svr_entry_free(entry);
     }
     return 0;
@@ -197,18 +412,11 @@ ble_att_svr_prev_handle(void)
 struct ble_att_svr_entry *
 ble_att_svr_find_by_handle(uint16_t handle_id)
 {
-    struct ble_att_svr_entry *entry;
-
-    for (entry = STAILQ_FIRST(&ble_att_svr_list);
-         entry != NULL;
-         entry = STAILQ_NEXT(entry, ha_next)) {
-
-        if (entry->ha_handle_id == handle_id) {
-            return entry;
-        }
+    if (handle_id == 0 || handle_id >= ble_att_svr_idx_cap) {
+        return NULL;
     }
 
-    return NULL;
+    return ble_att_svr_idx[handle_id];
 }
 
 /**
@@ -231,6 +439,36 @@ ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev, const ble_uuid_t *uuid,
                          uint16_t end_handle)
 {
     struct ble_att_svr_entry *entry;
+    uint16_t handle;
+    uint16_t pos;
+
+    if (uuid != NULL &&
+        (!ble_att_svr_uuid_idx_dirty || ble_att_svr_uuid_idx_build() == 0)) {
+
+        if (prev != NULL &&
+            ble_att_svr_find_by_handle(prev->ha_handle_id) == prev &&
+            ble_uuid_cmp(prev->ha_uuid, uuid) == 0) {
+
+            /* Continue along the chain of this UUID. */
+            handle = prev->ha_uuid_next;
+        } else {
+            if (ble_att_svr_uuid_idx_find(uuid, &pos) != 0) {
+                return NULL;
+            }
+
+            handle = ble_att_svr_uuid_idx[pos].first;
+            while (prev != NULL && handle != 0 &&
+                   handle <= prev->ha_handle_id) {
+                handle = ble_att_svr_idx[handle]->ha_uuid_next;
+            }
+        }
+
+        if (handle == 0 || handle > end_handle) {
+            return NULL;
+        }
+
+        return ble_att_svr_idx[handle];
+    }
 
     if (prev == NULL) {
         entry = STAILQ_FIRST(&ble_att_svr_list);
@@ -848,7 +1086,10 @@ ble_att_svr_fill_info(uint16_t start_handle, uint16_t end_handle,
     num_entries = 0;
     rc = 0;
 
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    for (ha = ble_att_svr_find_from(start_handle);
+         ha != NULL;
+         ha = STAILQ_NEXT(ha, ha_next)) {
+
         if (ha->ha_handle_id > end_handle) {
             rc = 0;
             goto done;
@@ -1133,10 +1374,9 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
      * matching group.  For each attribute entry, determine if data needs to be
      * written to the response.
      */
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
-        if (ha->ha_handle_id < start_handle) {
-            continue;
-        }
+    for (ha = ble_att_svr_find_from(start_handle);
+         ha != NULL;
+         ha = STAILQ_NEXT(ha, ha_next)) {
 
         /* Continue to look for end of group in case group is in progress. */
         if (!first && ha->ha_handle_id > end_handle) {
@@ -2049,10 +2289,10 @@ ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle, uint16_t cid,
     }
 
     rsp->bagp_length = 0;
-    STAILQ_FOREACH(entry, &ble_att_svr_list, ha_next) {
-        if (entry->ha_handle_id < start_handle) {
-            continue;
-        }
+    for (entry = ble_att_svr_find_from(start_handle);
+         entry != NULL;
+         entry = STAILQ_NEXT(entry, ha_next)) {
+
         if (entry->ha_handle_id > end_handle) {
             /* The full input range has been searched. */
             rc = 0;
@@ -3199,6 +3439,9 @@ ble_att_svr_move_entries(struct ble_att_svr_entry_list *src,
             STAILQ_REMOVE_AFTER(src, remove, ha_next);
         }
 
+        ble_att_svr_idx_set(entry->ha_handle_id,
+                            dst == &ble_att_svr_list ? entry : NULL);
+
         /* Insert current element */
         if (insert == NULL) {
             STAILQ_INSERT_HEAD(dst, entry, ha_next);
@@ -3246,6 +3489,13 @@ ble_att_svr_reset(void)
         ble_att_svr_entry_free(entry);
     }
 
+    if (ble_att_svr_idx != NULL) {
+        memset(ble_att_svr_idx, 0, ble_att_svr_idx_cap * sizeof *ble_att_svr_idx);
+    }
+    ble_att_svr_uuid_idx_cnt = 0;
+    ble_att_svr_uuid_idx_dirty = 1;
+    ble_att_svr_db_gen++;
+
     ble_att_svr_id = 0;
 
     /* Note: prep entries do not get freed here because it is assumed there are
@@ -3262,6 +3512,8 @@ ble_att_svr_free_start_mem(void)
     free(ble_att_svr_entry_mem);
 #endif
     ble_att_svr_entry_mem = NULL;
+
+    ble_att_svr_idx_free();
 }
 
 int
@@ -3291,6 +3543,14 @@ ble_att_svr_start(void)
             rc = BLE_HS_EOS;
             goto err;
         }
+
+        /* Size the handle index for the configured attributes up front;
+         * dynamic services grow it on registration.
+         */
+        rc = ble_att_svr_idx_reserve((uint32_t)ble_hs_max_attrs + 1);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     return 0;
@@ -3326,12 +3586,24 @@ ble_att_svr_init(void)
     STAILQ_INIT(&ble_att_svr_hidden_list);
 
     ble_att_svr_id = 0;
+    ble_att_svr_uuid_idx_dirty = 1;
 
     return 0;
 }
 
 /* Defined in Core spec v5.4 VOL 3 Part G 7.3.1 */
 #if MYNEWT_VAL(BLE_GATT_CACHING)
+/**
+ * Returns a counter that changes whenever attributes are added, removed,
+ * hidden or restored, so derived data such as the database hash can be
+ * cached until the table changes.
+ */
+uint32_t
+ble_att_svr_db_generation(void)
+{
+    return ble_att_svr_db_gen;
+}
+
 int ble_att_get_database_size(int *out_size)
 {
     struct ble_att_svr_entry *entry;
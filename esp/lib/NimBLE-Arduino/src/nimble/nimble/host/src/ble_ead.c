@@ -16,6 +16,24 @@ extern "C" {
 
 static uint8_t ble_ead_aad[] = {0xEA};
 
+int ble_ead_key_set(struct ble_ead_key *key,
+                    const uint8_t session_key[BLE_EAD_KEY_SIZE],
+                    const uint8_t iv[BLE_EAD_IV_SIZE])
+{
+    if (key == NULL || session_key == NULL || iv == NULL) {
+        return BLE_HS_EINVAL;
+    }
+
+    memcpy(key->iv, iv, BLE_EAD_IV_SIZE);
+    return ble_aes_ccm_key_set(&key->aes, session_key);
+}
+
+void ble_ead_key_clear(struct ble_ead_key *key)
+{
+    ble_aes_ccm_key_clear(&key->aes);
+    memset(key->iv, 0, sizeof key->iv);
+}
+
 static int ble_ead_rand(void *buf, size_t len)
 {
     int rc;
@@ -61,7 +79,7 @@ static int ble_ead_generate_nonce(const uint8_t iv[BLE_EAD_IV_SIZE],
     return 0;
 }
 
-static int ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t iv[BLE_EAD_IV_SIZE],
+static int ead_encrypt(const struct ble_ead_key *key,
                        const uint8_t randomizer[BLE_EAD_RANDOMIZER_SIZE], const uint8_t *payload,
                        size_t payload_size, uint8_t *encrypted_payload)
 {
@@ -69,7 +87,7 @@ static int ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_
     uint8_t nonce[BLE_EAD_NONCE_SIZE];
 
     /** Nonce is concatenation of Randomizer and IV */
-    err = ble_ead_generate_nonce(iv, randomizer, nonce);
+    err = ble_ead_generate_nonce(key->iv, randomizer, nonce);
     if (err != 0) {
         return -1;
     }
@@ -77,8 +95,8 @@ static int ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_
     /** Copying Randomizer to the start of encrypted advertisment data */
     memcpy(encrypted_payload, nonce, BLE_EAD_RANDOMIZER_SIZE);
 
-    err = ble_aes_ccm_encrypt(session_key, nonce, payload, payload_size, ble_ead_aad, BLE_EAD_AAD_SIZE,
-                              &encrypted_payload[BLE_EAD_RANDOMIZER_SIZE], BLE_EAD_MIC_SIZE);
+    err = ble_aes_ccm_encrypt_key(&key->aes, nonce, payload, payload_size, ble_ead_aad, BLE_EAD_AAD_SIZE,
+                                  &encrypted_payload[BLE_EAD_RANDOMIZER_SIZE], BLE_EAD_MIC_SIZE);
     
     if (err != 0) {
         BLE_HS_LOG(DEBUG, "Failed to encrypt the payload (ble_ccm_encrypt err %d)", err);
@@ -91,6 +109,9 @@ static int ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_
 int ble_ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t iv[BLE_EAD_IV_SIZE],
                     const uint8_t *payload, size_t payload_size, uint8_t *encrypted_payload)
 {
+    struct ble_ead_key key;
+    int err;
+
     if (session_key == NULL) {
         BLE_HS_LOG(DEBUG, "session_key is NULL");
         return BLE_HS_EINVAL;
@@ -116,10 +137,29 @@ int ble_ead_encrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t i
                    "Randomizer and the MIC.");
     }
 
-    return ead_encrypt(session_key, iv, NULL, payload, payload_size, encrypted_payload);
+    err = ble_ead_key_set(&key, session_key, iv);
+    if (err != 0) {
+        return err;
+    }
+
+    err = ead_encrypt(&key, NULL, payload, payload_size, encrypted_payload);
+    ble_ead_key_clear(&key);
+
+    return err;
 }
 
-static int ead_decrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t iv[BLE_EAD_IV_SIZE],
+int ble_ead_encrypt_key(const struct ble_ead_key *key, const uint8_t *payload,
+                        size_t payload_size, uint8_t *encrypted_payload)
+{
+    if (key == NULL || payload == NULL || encrypted_payload == NULL) {
+        BLE_HS_LOG(DEBUG, "NULL argument");
+        return BLE_HS_EINVAL;
+    }
+
+    return ead_encrypt(key, NULL, payload, payload_size, encrypted_payload);
+}
+
+static int ead_decrypt(const struct ble_ead_key *key,
                        const uint8_t *encrypted_payload, size_t encrypted_payload_size,
                        uint8_t *payload)
 {
@@ -131,13 +171,18 @@ static int ead_decrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_
 
     const uint8_t *randomizer = encrypted_payload;
 
-    err = ble_ead_generate_nonce(iv, randomizer, nonce);
+    err = ble_ead_generate_nonce(key->iv, randomizer, nonce);
     if (err != 0) {
         return -1;
     }
 
-    err = ble_aes_ccm_decrypt(session_key, nonce, encrypted_ad_data, payload_size, ble_ead_aad,
-                              BLE_EAD_AAD_SIZE, payload, BLE_EAD_MIC_SIZE);
+    err = ble_aes_ccm_decrypt_key(&key->aes, nonce, encrypted_ad_data, payload_size, ble_ead_aad,
+                                  BLE_EAD_AAD_SIZE, payload, BLE_EAD_MIC_SIZE);
+
+    if (err == BLE_HS_EAUTHEN) {
+        BLE_HS_LOG(DEBUG, "MIC mismatch, wrong key material or corrupted data");
+        return err;
+    }
 
     if (err != 0) {
         BLE_HS_LOG(DEBUG, "Failed to decrypt the data (ble_ccm_decrypt err %d)", err);
@@ -151,6 +196,9 @@ int ble_ead_decrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t i
                     const uint8_t *encrypted_payload, size_t encrypted_payload_size,
                     uint8_t *payload)
 {
+    struct ble_ead_key key;
+    int err;
+
     if (session_key == NULL) {
         BLE_HS_LOG(DEBUG, "session_key is NULL");
         return BLE_HS_EINVAL;
@@ -178,7 +226,53 @@ int ble_ead_decrypt(const uint8_t session_key[BLE_EAD_KEY_SIZE], const uint8_t i
         BLE_HS_LOG(WARN, "encrypted_payload_size not large enough to contain encrypted data.");
     }
 
-    return ead_decrypt(session_key, iv, encrypted_payload, encrypted_payload_size, payload);
+    err = ble_ead_key_set(&key, session_key, iv);
+    if (err != 0) {
+        return err;
+    }
+
+    err = ead_decrypt(&key, encrypted_payload, encrypted_payload_size, payload);
+    ble_ead_key_clear(&key);
+
+    return err;
+}
+
+int ble_ead_decrypt_key(const struct ble_ead_key *key,
+                        const uint8_t *encrypted_payload,
+                        size_t encrypted_payload_size, uint8_t *payload)
+{
+    if (key == NULL || encrypted_payload == NULL || payload == NULL) {
+        BLE_HS_LOG(DEBUG, "NULL argument");
+        return BLE_HS_EINVAL;
+    }
+
+    if (encrypted_payload_size < BLE_EAD_RANDOMIZER_SIZE + BLE_EAD_MIC_SIZE) {
+        BLE_HS_LOG(DEBUG, "encrypted_payload_size is not large enough.");
+        return BLE_HS_EINVAL;
+    }
+
+    return ead_decrypt(key, encrypted_payload, encrypted_payload_size, payload);
+}
+
+int ble_ead_decrypt_batch(struct ble_ead_decrypt_op *ops, int num_ops)
+{
+    int decrypted = 0;
+    int i;
+
+    for (i = 0; i < num_ops; i++) {
+        if (ops[i].key == NULL) {
+            ops[i].rc = BLE_HS_ENOENT;
+            continue;
+        }
+
+        ops[i].rc = ble_ead_decrypt_key(ops[i].key, ops[i].encrypted_payload,
+                                        ops[i].encrypted_payload_size, ops[i].payload);
+        if (ops[i].rc == 0) {
+            decrypted++;
+        }
+    }
+
+    return decrypted;
 }
 
 #endif /* ENC_ADV_DATA */
@@ -34,7 +34,9 @@ struct ble_eatt {
     SLIST_ENTRY(ble_eatt) next;
     uint16_t conn_handle;
     struct ble_l2cap_chan *chan;
-    uint8_t client_op;
+
+    /* Client requests outstanding on the channel. */
+    uint8_t client_busy;
 
     /* Packet transmit queue */
     STAILQ_HEAD(, os_mbuf_pkthdr) eatt_tx_q;
@@ -82,7 +84,7 @@ ble_eatt_find_not_busy(uint16_t conn_handle)
     struct ble_eatt *eatt;
 
     SLIST_FOREACH(eatt, &g_ble_eatt_list, next) {
-        if ((eatt->conn_handle == conn_handle) && !eatt->client_op && eatt->chan) {
+        if ((eatt->conn_handle == conn_handle) && !eatt->client_busy && eatt->chan) {
             return eatt;
         }
     }
@@ -103,20 +105,6 @@ ble_eatt_find_by_conn_handle(uint16_t conn_handle)
 
 }
 
-static struct ble_eatt *
-ble_eatt_find_by_conn_handle_and_busy_op(uint16_t conn_handle, uint8_t op)
-{
-    struct ble_eatt *eatt;
-
-    SLIST_FOREACH(eatt, &g_ble_eatt_list, next) {
-        if (eatt->conn_handle == conn_handle && eatt->client_op == op) {
-            return eatt;
-        }
-    }
-    return NULL;
-
-}
-
 static struct ble_eatt *
 ble_eatt_find(uint16_t conn_handle, uint16_t cid)
 {
@@ -190,7 +178,7 @@ ble_eatt_alloc(void)
 
     eatt->conn_handle = BLE_HS_CONN_HANDLE_NONE;
     eatt->chan = NULL;
-    eatt->client_op = 0;
+    eatt->client_busy = 0;
 
     STAILQ_INIT(&eatt->eatt_tx_q);
     ble_npl_event_init(&eatt->setup_ev, ble_eatt_setup_cb, eatt);
@@ -484,24 +472,54 @@ ble_eatt_get_available_chan_cid(uint16_t conn_handle, uint8_t op)
         return BLE_L2CAP_CID_ATT;
     }
 
-    eatt->client_op = op;
+    eatt->client_busy++;
     return eatt->chan->scid;
 }
 
-
+/**
+ * Releases the channel a client request was sent on.  Channels are released
+ * by CID rather than by op so that, with several requests of the same kind
+ * in flight, the channel that answered is the one that becomes available.
+ */
 void
-ble_eatt_release_chan(uint16_t conn_handle, uint8_t op)
+ble_eatt_release_chan(uint16_t conn_handle, uint16_t cid)
 {
     struct ble_eatt * eatt;
 
-    eatt = ble_eatt_find_by_conn_handle_and_busy_op(conn_handle, op);
-    if (!eatt) {
+    eatt = ble_eatt_find(conn_handle, cid);
+    if (!eatt || !eatt->client_busy) {
         BLE_EATT_LOG_DEBUG("ble_eatt_release_chan:"
-                          "EATT not found for conn_handle 0x%04x, operation 0x%02\n", conn_handle, op);
+                          "EATT not found for conn_handle 0x%04x, cid 0x%04x\n", conn_handle, cid);
         return;
     }
 
-    eatt->client_op = 0;
+    eatt->client_busy--;
+}
+
+int
+ble_eatt_get_bearers(uint16_t conn_handle, struct ble_att_bearer_desc *out,
+                     int max)
+{
+    struct ble_eatt *eatt;
+    int n;
+
+    n = 0;
+    SLIST_FOREACH(eatt, &g_ble_eatt_list, next) {
+        if (n >= max) {
+            break;
+        }
+
+        if (eatt->conn_handle != conn_handle || eatt->chan == NULL) {
+            continue;
+        }
+
+        out[n].cid = eatt->chan->scid;
+        out[n].mtu = ble_att_chan_mtu(eatt->chan);
+        out[n].busy = eatt->client_busy;
+        n++;
+    }
+
+    return n;
 }
 
 int
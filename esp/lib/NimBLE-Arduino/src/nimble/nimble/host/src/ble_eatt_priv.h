@@ -31,10 +31,14 @@ typedef int (* ble_eatt_att_rx_fn)(uint16_t conn_handle, uint16_t cid, struct os
 #define BLE_GATT_OP_SERVER 0xF1
 #define BLE_GATT_OP_DUMMY  0xF2
 
+struct ble_att_bearer_desc;
+
 #if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
 void ble_eatt_init(ble_eatt_att_rx_fn att_rx_fn);
 uint16_t ble_eatt_get_available_chan_cid(uint16_t conn_handle, uint8_t op);
-void ble_eatt_release_chan(uint16_t conn_handle, uint8_t op);
+void ble_eatt_release_chan(uint16_t conn_handle, uint16_t cid);
+int ble_eatt_get_bearers(uint16_t conn_handle, struct ble_att_bearer_desc *out,
+                         int max);
 int ble_eatt_tx(uint16_t conn_handle, uint16_t cid, struct os_mbuf *txom);
 #else
 static inline void
@@ -43,7 +47,7 @@ ble_eatt_init(ble_eatt_att_rx_fn att_rx_fn)
 }
 
 static inline void
-ble_eatt_release_chan(uint16_t conn_handle, uint8_t op)
+ble_eatt_release_chan(uint16_t conn_handle, uint16_t cid)
 {
 
 }
@@ -36,8 +36,9 @@
  * Notes on thread-safety:
  * 1. The ble_hs mutex must never be locked when an application callback is
  *    executed.  A callback is free to initiate additional host procedures.
- * 2. The only resource protected by the mutex is the list of active procedures
- *    (ble_gattc_procs).  Thread-safety is achieved by locking the mutex during
+ * 2. The only resource protected by the mutex is the index of active
+ *    procedures (ble_gattc_procs and ble_gattc_proc_buckets).  Thread-safety
+ *    is achieved by locking the mutex during
  *    removal and insertion operations.  Procedure objects are only modified
  *    while they are not in the list.  This is sufficient, as the host parent
  *    task is the only task which inspects or modifies individual procedure
@@ -104,10 +105,16 @@
 /** Procedure stalled due to resource exhaustion. */
 #define BLE_GATTC_PROC_F_STALLED                0x01
 
+/** Procedure is in the procedure index. */
+#define BLE_GATTC_PROC_F_INSERTED               0x02
+
 /** Represents an in-progress GATT procedure. */
 struct ble_gattc_proc {
     STAILQ_ENTRY(ble_gattc_proc) next;
+    TAILQ_ENTRY(ble_gattc_proc) bucket_next;
+    TAILQ_ENTRY(ble_gattc_proc) exp_next;
 
+    uint32_t seq;
     uint32_t exp_os_ticks;
     uint16_t conn_handle;
     uint16_t cid;
@@ -229,6 +236,7 @@ struct ble_gattc_proc {
 static struct ble_gattc_proc_list temp_proc_list;
 #endif
 STAILQ_HEAD(ble_gattc_proc_list, ble_gattc_proc);
+TAILQ_HEAD(ble_gattc_proc_tailq, ble_gattc_proc);
 
 /**
  * Error functions - these handle an incoming ATT error response and apply it
@@ -436,8 +444,28 @@ static os_membuf_t ble_gattc_proc_mem[
 
 static struct os_mempool ble_gattc_proc_pool;
 
-/* The list of active GATT client procedures. */
-static struct ble_gattc_proc_list ble_gattc_procs;
+/**
+ * Procedures are indexed in one row of per-op buckets for each connection
+ * slot.  Controllers hand out connection handles from a small range, so live
+ * connections normally map to different slots; connections that share a slot
+ * are told apart when the bucket is searched.
+ */
+#if MYNEWT_VAL(BLE_MAX_CONNECTIONS) > 0
+#define BLE_GATTC_PROC_CONN_SLOTS               MYNEWT_VAL(BLE_MAX_CONNECTIONS)
+#else
+#define BLE_GATTC_PROC_CONN_SLOTS               1
+#endif
+#define BLE_GATTC_PROC_BUCKETS                  \
+    (BLE_GATTC_PROC_CONN_SLOTS * BLE_GATT_OP_CNT)
+
+/* Active GATT client procedures by connection and op code, oldest first. */
+static struct ble_gattc_proc_tailq ble_gattc_proc_buckets[BLE_GATTC_PROC_BUCKETS];
+
+/* All active GATT client procedures, ordered by expiry time. */
+static struct ble_gattc_proc_tailq ble_gattc_procs;
+
+/* Numbers procedures as they are indexed, to find the oldest across buckets. */
+static uint32_t ble_gattc_proc_seq;
 
 /* The time when we should attempt to resume stalled procedures, in OS ticks.
  * A value of 0 indicates no stalled procedures.
@@ -496,14 +524,8 @@ static void
 ble_gattc_dbg_assert_proc_not_inserted(struct ble_gattc_proc *proc)
 {
 #if MYNEWT_VAL(BLE_HS_DEBUG)
-    struct ble_gattc_proc *cur;
-
     ble_hs_lock();
-
-    STAILQ_FOREACH(cur, &ble_gattc_procs, next) {
-        BLE_HS_DBG_ASSERT(cur != proc);
-    }
-
+    BLE_HS_DBG_ASSERT(!(proc->flags & BLE_GATTC_PROC_F_INSERTED));
     ble_hs_unlock();
 #endif
 }
@@ -705,6 +727,30 @@ ble_gattc_rx_entry_find(uint8_t op, const void *rx_entries, int num_entries)
     return NULL;
 }
 
+/**
+ * Returns the op codes of an rx entry table, one bit per op.
+ */
+static uint16_t
+ble_gattc_rx_entries_op_mask(const void *rx_entries, int num_entries)
+{
+    struct gen_entry {
+        uint8_t op;
+        void (*cb)(void);
+    };
+
+    const struct gen_entry *entries;
+    uint16_t op_mask;
+    int i;
+
+    entries = rx_entries;
+    op_mask = 0;
+    for (i = 0; i < num_entries; i++) {
+        op_mask |= 1 << entries[i].op;
+    }
+
+    return op_mask;
+}
+
 /*****************************************************************************
  * $proc                                                                    *
  *****************************************************************************/
@@ -768,7 +814,7 @@ ble_gattc_proc_free(struct ble_gattc_proc *proc)
 
 #if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
         if (ble_hs_cfg.eatt && proc->cid != BLE_L2CAP_CID_ATT) {
-            ble_eatt_release_chan(proc->conn_handle, proc->op);
+            ble_eatt_release_chan(proc->conn_handle, proc->cid);
         }
 #endif
 
@@ -780,13 +826,72 @@ ble_gattc_proc_free(struct ble_gattc_proc *proc)
     }
 }
 
+static struct ble_gattc_proc_tailq *
+ble_gattc_proc_bucket(uint16_t conn_handle, uint8_t op)
+{
+    BLE_HS_DBG_ASSERT(op < BLE_GATT_OP_CNT);
+
+    return ble_gattc_proc_buckets +
+           (conn_handle % BLE_GATTC_PROC_CONN_SLOTS) * BLE_GATT_OP_CNT + op;
+}
+
+/**
+ * Adds a procedure to the index.  Must be called with the host lock held.
+ */
 static void
-ble_gattc_proc_insert(struct ble_gattc_proc *proc)
+ble_gattc_proc_index(struct ble_gattc_proc *proc)
 {
-    ble_gattc_dbg_assert_proc_not_inserted(proc);
+    struct ble_gattc_proc *cur;
+
+    proc->flags |= BLE_GATTC_PROC_F_INSERTED;
+    proc->seq = ble_gattc_proc_seq++;
 
+    TAILQ_INSERT_TAIL(ble_gattc_proc_bucket(proc->conn_handle, proc->op),
+                      proc, bucket_next);
+
+    /* Every procedure gets the same timeout, so a new one nearly always
+     * belongs at the tail and this loop does not iterate.
+     */
+    cur = TAILQ_LAST(&ble_gattc_procs, ble_gattc_proc_tailq);
+    while (cur != NULL &&
+           (int32_t)(cur->exp_os_ticks - proc->exp_os_ticks) > 0) {
+
+        cur = TAILQ_PREV(cur, ble_gattc_proc_tailq, exp_next);
+    }
+
+    if (cur == NULL) {
+        TAILQ_INSERT_HEAD(&ble_gattc_procs, proc, exp_next);
+    } else {
+        TAILQ_INSERT_AFTER(&ble_gattc_procs, cur, proc, exp_next);
+    }
+}
+
+/**
+ * Removes a procedure from the index.  Must be called with the host lock held.
+ */
+static void
+ble_gattc_proc_unindex(struct ble_gattc_proc *proc)
+{
+    TAILQ_REMOVE(ble_gattc_proc_bucket(proc->conn_handle, proc->op),
+                 proc, bucket_next);
+    TAILQ_REMOVE(&ble_gattc_procs, proc, exp_next);
+
+    proc->flags &= ~BLE_GATTC_PROC_F_INSERTED;
+}
+
+static void
+ble_gattc_proc_insert(struct ble_gattc_proc *proc)
+{
     ble_hs_lock();
-    STAILQ_INSERT_TAIL(&ble_gattc_procs, proc, next);
+
+    /* A preempted procedure may have been indexed already; move it to its
+     * new expiry position.
+     */
+    if (proc->flags & BLE_GATTC_PROC_F_INSERTED) {
+        ble_gattc_proc_unindex(proc);
+    }
+    ble_gattc_proc_index(proc);
+
     ble_hs_unlock();
 }
 
@@ -890,129 +995,64 @@ ble_gattc_tmo_dispatch_get(uint8_t op)
 
 typedef int ble_gattc_match_fn(struct ble_gattc_proc *proc, void *arg);
 
-struct ble_gattc_criteria_conn_op {
-    uint16_t conn_handle;
-    uint16_t psm;
-    uint8_t op;
-};
-
 /**
- * Tests if a proc entry fits the specified criteria.
- *
- * @param proc                  The procedure to test.
- * @param conn_handle           The connection handle to match against.
- * @param op                    The op code to match against, or
- *                                  BLE_GATT_OP_NONE to ignore this criterion.
- *
- * @return                      1 if the proc matches; 0 otherwise.
+ * Returns the op code mask used by ble_gattc_extract_conn() for the specified
+ * op code; BLE_GATT_OP_NONE selects every op code.
  */
-static int
-ble_gattc_proc_matches_conn_op(struct ble_gattc_proc *proc, void *arg)
+static uint16_t
+ble_gattc_op_mask(uint8_t op)
 {
-    const struct ble_gattc_criteria_conn_op *criteria;
-
-    criteria = arg;
-
-    if (criteria->conn_handle != proc->conn_handle) {
-        return 0;
+    if (op == BLE_GATT_OP_NONE) {
+        return (1 << BLE_GATT_OP_CNT) - 1;
     }
 
-    if (criteria->op != proc->op && criteria->op != BLE_GATT_OP_NONE) {
-        return 0;
-    }
-
-    return 1;
+    return 1 << op;
 }
 
 static int
-ble_gattc_proc_matches_conn_cid_op(struct ble_gattc_proc *proc, void *arg)
+ble_gattc_proc_matches_cid(struct ble_gattc_proc *proc, void *arg)
 {
-    const struct ble_gattc_criteria_conn_op *criteria;
+    const uint16_t *cid;
 
-    criteria = arg;
-
-    if (criteria->conn_handle != proc->conn_handle) {
-        return 0;
-    }
+    cid = arg;
 
-    if (criteria->psm != proc->cid) {
-        return 0;
-    }
-
-    if (criteria->op != proc->op && criteria->op != BLE_GATT_OP_NONE) {
-        return 0;
-    }
-
-    return 1;
-}
-
-struct ble_gattc_criteria_exp {
-    ble_npl_time_t now;
-    int32_t next_exp_in;
-};
-
-static int
-ble_gattc_proc_matches_expired(struct ble_gattc_proc *proc, void *arg)
-{
-    struct ble_gattc_criteria_exp *criteria;
-    int32_t time_diff;
-
-    criteria = arg;
-
-    time_diff = proc->exp_os_ticks - criteria->now;
-
-    if (time_diff <= 0) {
-        /* Procedure is expired. */
-        return 1;
-    }
-
-    /* Procedure isn't expired; determine if it is the next to expire. */
-    if (time_diff < criteria->next_exp_in) {
-        criteria->next_exp_in = time_diff;
-    }
-    return 0;
+    return proc->cid == *cid;
 }
 
-struct ble_gattc_criteria_conn_rx_entry {
-    uint16_t conn_handle;
-    uint16_t cid;
-    const void *rx_entries;
-    int num_rx_entries;
-    const void *matching_rx_entry;
-};
-
-static int
-ble_gattc_proc_matches_conn_rx_entry(struct ble_gattc_proc *proc, void *arg)
+/**
+ * Indexes the procedures whose response was received before the call that
+ * initiated them returned.  Must be called with the host lock held.
+ */
+static void
+ble_gattc_index_preempted(void)
 {
-    struct ble_gattc_criteria_conn_rx_entry *criteria;
-
-    criteria = arg;
-
-    if (criteria->conn_handle != BLE_HS_CONN_HANDLE_NONE &&
-        criteria->conn_handle != proc->conn_handle &&
-        criteria->cid != proc->cid) {
+#if MYNEWT_VAL(BLE_GATTC_PROC_PREEMPTION_PROTECT)
+    struct ble_gattc_proc *proc;
 
-        return 0;
+    STAILQ_FOREACH(proc, &temp_proc_list, next) {
+        if (!(proc->flags & BLE_GATTC_PROC_F_INSERTED)) {
+            /* Detected a preemption case */
+            ble_gattc_proc_set_exp_timer(proc);
+            ble_gattc_proc_index(proc);
+        }
     }
 
-    /* Entry matches; indicate corresponding rx entry. */
-    criteria->matching_rx_entry = ble_gattc_rx_entry_find(
-        proc->op, criteria->rx_entries, criteria->num_rx_entries);
-
-    return (criteria->matching_rx_entry != NULL);
+    /* Clear the temp proc list */
+    STAILQ_INIT(&temp_proc_list);
+#endif
 }
 
+/**
+ * Removes all procedures matching the specified criteria from the index and
+ * inserts them into the destination list.  This visits every procedure, so it
+ * is only used where that cannot be avoided.
+ */
 static void
 ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
                   struct ble_gattc_proc_list *dst_list)
 {
     struct ble_gattc_proc *proc;
-    struct ble_gattc_proc *prev;
     struct ble_gattc_proc *next;
-#if MYNEWT_VAL(BLE_GATTC_PROC_PREEMPTION_PROTECT)
-    struct ble_gattc_proc *cur;
-    uint8_t flag = 0;
-#endif
     int num_extracted;
 
     /* Only the parent task is allowed to remove entries from the list. */
@@ -1023,39 +1063,14 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
 
     ble_hs_lock();
 
-    prev = NULL;
+    ble_gattc_index_preempted();
 
-#if MYNEWT_VAL(BLE_GATTC_PROC_PREEMPTION_PROTECT)
-    proc = STAILQ_FIRST(&temp_proc_list);
+    proc = TAILQ_FIRST(&ble_gattc_procs);
     while (proc != NULL) {
-        next = STAILQ_NEXT(proc, next);
-        STAILQ_FOREACH(cur, &ble_gattc_procs, next) {
-            if (proc == cur) {
-                flag = 1;
-                break;
-            }
-        }
-        if (!flag) {
-        /* Detected a preemption case */
-            STAILQ_INSERT_TAIL(&ble_gattc_procs, proc, next);
-        }
-        flag = 0;
-        proc = next;
-    }
-    /* Clear the temp proc list */
-    STAILQ_INIT(&temp_proc_list);
-#endif
-
-    proc = STAILQ_FIRST(&ble_gattc_procs);
-    while (proc != NULL) {
-        next = STAILQ_NEXT(proc, next);
+        next = TAILQ_NEXT(proc, exp_next);
 
         if (cb(proc, arg)) {
-            if (prev == NULL) {
-                STAILQ_REMOVE_HEAD(&ble_gattc_procs, next);
-            } else {
-                STAILQ_REMOVE_AFTER(&ble_gattc_procs, prev, next);
-            }
+            ble_gattc_proc_unindex(proc);
             STAILQ_INSERT_TAIL(dst_list, proc, next);
 
             if (max_procs > 0) {
@@ -1064,8 +1079,6 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
                     break;
                 }
             }
-        } else {
-            prev = proc;
         }
 
         proc = next;
@@ -1074,39 +1087,90 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
     ble_hs_unlock();
 }
 
-static struct ble_gattc_proc *
-ble_gattc_extract_one(ble_gattc_match_fn *cb, void *arg)
+/**
+ * Removes the procedures of one connection that match the specified criteria
+ * from the index and inserts them into the destination list, oldest first.
+ * Only the buckets of the specified connection and op codes are visited.
+ *
+ * @param conn_handle           The connection handle to match against.
+ * @param op_mask               The op codes to match against, one bit per op.
+ * @param cb                    Additional criteria to match, or NULL.
+ * @param arg                   The argument to pass to cb.
+ * @param max_procs             The maximum number of procedures to extract;
+ *                                  0 for no limit.
+ * @param dst_list              The list to insert extracted procedures into.
+ */
+static void
+ble_gattc_extract_conn(uint16_t conn_handle, uint16_t op_mask,
+                       ble_gattc_match_fn *cb, void *arg, int max_procs,
+                       struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_proc_list dst_list;
+    struct ble_gattc_proc *oldest;
+    struct ble_gattc_proc *proc;
+    int num_extracted;
+    uint8_t op;
 
-    ble_gattc_extract(cb, arg, 1, &dst_list);
-    return STAILQ_FIRST(&dst_list);
+    /* Only the parent task is allowed to remove entries from the list. */
+    BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
+
+    STAILQ_INIT(dst_list);
+    num_extracted = 0;
+
+    ble_hs_lock();
+
+    ble_gattc_index_preempted();
+
+    do {
+        /* Each bucket is in insertion order, so only its first match can be
+         * the oldest.
+         */
+        oldest = NULL;
+        for (op = 0; op < BLE_GATT_OP_CNT; op++) {
+            if (!(op_mask & (1 << op))) {
+                continue;
+            }
+
+            TAILQ_FOREACH(proc, ble_gattc_proc_bucket(conn_handle, op),
+                          bucket_next) {
+                if (proc->conn_handle == conn_handle && proc->op == op &&
+                    (cb == NULL || cb(proc, arg))) {
+
+                    if (oldest == NULL ||
+                        (int32_t)(proc->seq - oldest->seq) < 0) {
+
+                        oldest = proc;
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (oldest != NULL) {
+            ble_gattc_proc_unindex(oldest);
+            STAILQ_INSERT_TAIL(dst_list, oldest, next);
+            num_extracted++;
+        }
+    } while (oldest != NULL && (max_procs <= 0 || num_extracted < max_procs));
+
+    ble_hs_unlock();
 }
 
 static void
 ble_gattc_extract_by_conn_op(uint16_t conn_handle, uint8_t op, int max_procs,
                              struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_criteria_conn_op criteria;
-
-    criteria.conn_handle = conn_handle;
-    criteria.op = op;
-
-    ble_gattc_extract(ble_gattc_proc_matches_conn_op, &criteria, max_procs, dst_list);
+    ble_gattc_extract_conn(conn_handle, ble_gattc_op_mask(op), NULL, NULL,
+                           max_procs, dst_list);
 }
 
 static void
-ble_gattc_extract_by_conn_cid_op(uint16_t conn_handle, uint16_t psm, uint8_t op,
+ble_gattc_extract_by_conn_cid_op(uint16_t conn_handle, uint16_t cid, uint8_t op,
                                  int max_procs,
                                  struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_criteria_conn_op criteria;
-
-    criteria.conn_handle = conn_handle;
-    criteria.op = op;
-    criteria.psm = psm;
-
-    ble_gattc_extract(ble_gattc_proc_matches_conn_cid_op, &criteria, max_procs, dst_list);
+    ble_gattc_extract_conn(conn_handle, ble_gattc_op_mask(op),
+                           ble_gattc_proc_matches_cid, &cid, max_procs,
+                           dst_list);
 }
 
 static struct ble_gattc_proc *
@@ -1137,15 +1201,39 @@ ble_gattc_extract_stalled(struct ble_gattc_proc_list *dst_list)
 static int32_t
 ble_gattc_extract_expired(struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_criteria_exp criteria;
+    struct ble_gattc_proc *proc;
+    ble_npl_time_t now;
+    int32_t next_exp_in;
+    int32_t time_diff;
 
-    criteria.now = ble_npl_time_get();
-    criteria.next_exp_in = BLE_HS_FOREVER;
+    /* Only the parent task is allowed to remove entries from the list. */
+    BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
 
     STAILQ_INIT(dst_list);
-    ble_gattc_extract(ble_gattc_proc_matches_expired, &criteria, 0, dst_list);
+    next_exp_in = BLE_HS_FOREVER;
+    now = ble_npl_time_get();
+
+    ble_hs_lock();
+
+    ble_gattc_index_preempted();
 
-    return criteria.next_exp_in;
+    /* The list is ordered by expiry time; stop at the first procedure that
+     * has not expired yet, it is the next to expire.
+     */
+    while ((proc = TAILQ_FIRST(&ble_gattc_procs)) != NULL) {
+        time_diff = proc->exp_os_ticks - now;
+        if (time_diff > 0) {
+            next_exp_in = time_diff;
+            break;
+        }
+
+        ble_gattc_proc_unindex(proc);
+        STAILQ_INSERT_TAIL(dst_list, proc, next);
+    }
+
+    ble_hs_unlock();
+
+    return next_exp_in;
 }
 
 static struct ble_gattc_proc *
@@ -1153,26 +1241,29 @@ ble_gattc_extract_with_rx_entry(uint16_t conn_handle, uint16_t cid,
                                 const void *rx_entries, int num_rx_entries,
                                 const void **out_rx_entry)
 {
-    struct ble_gattc_criteria_conn_rx_entry criteria;
+    struct ble_gattc_proc_list dst_list;
     struct ble_gattc_proc *proc;
 
-    criteria.conn_handle = conn_handle;
-    criteria.cid = cid;
-    criteria.rx_entries = rx_entries;
-    criteria.num_rx_entries = num_rx_entries;
-    criteria.matching_rx_entry = NULL;
+    ble_gattc_extract_conn(conn_handle,
+                           ble_gattc_rx_entries_op_mask(rx_entries,
+                                                        num_rx_entries),
+                           ble_gattc_proc_matches_cid, &cid, 1, &dst_list);
 
-    proc = ble_gattc_extract_one(ble_gattc_proc_matches_conn_rx_entry,
-                                 &criteria);
-    *out_rx_entry = criteria.matching_rx_entry;
+    proc = STAILQ_FIRST(&dst_list);
+    if (proc != NULL) {
+        *out_rx_entry = ble_gattc_rx_entry_find(proc->op, rx_entries,
+                                                num_rx_entries);
+    } else {
+        *out_rx_entry = NULL;
+    }
 
     return proc;
 }
 
 /**
- * Searches the main proc list for an entry whose connection handle and op code
- * match those specified.  If a matching entry is found, it is removed from the
- * list and returned.
+ * Searches the procedure index for the oldest entry whose connection handle,
+ * CID and op code match those specified.  If a matching entry is found, it is
+ * removed from the index and returned.
  *
  * @param conn_handle           The connection handle to match against.
  * @param cid                   Source CID of L2CAP channel used
@@ -3255,6 +3346,22 @@ done:
  * $read long                                                                *
  *****************************************************************************/
 
+/* The read proc whose callback is running, for ble_gattc_read_bearer_mtu(). */
+static struct ble_gattc_proc *ble_gattc_read_cur_proc;
+
+uint16_t
+ble_gattc_read_bearer_mtu(void)
+{
+    struct ble_gattc_proc *proc;
+
+    proc = ble_gattc_read_cur_proc;
+    if (proc == NULL) {
+        return 0;
+    }
+
+    return ble_att_mtu_by_cid(proc->conn_handle, proc->cid);
+}
+
 /**
  * Calls a read-long-characteristic proc's callback with the specified
  * parameters.  If the proc has no callback, this function is a no-op.
@@ -3266,6 +3373,7 @@ static int
 ble_gattc_read_long_cb(struct ble_gattc_proc *proc, int status,
                        uint16_t att_handle, struct ble_gatt_attr *attr)
 {
+    struct ble_gattc_proc *prev_proc;
     int rc;
 
     BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
@@ -3284,9 +3392,12 @@ ble_gattc_read_long_cb(struct ble_gattc_proc *proc, int status,
     if (proc->read_long.cb == NULL) {
         rc = 0;
     } else {
+        prev_proc = ble_gattc_read_cur_proc;
+        ble_gattc_read_cur_proc = proc;
         rc = proc->read_long.cb(proc->conn_handle,
                                 ble_gattc_error(status, att_handle), attr,
                                 proc->read_long.cb_arg);
+        ble_gattc_read_cur_proc = prev_proc;
     }
 
     return rc;
@@ -3461,9 +3572,11 @@ ble_gattc_read_mult_cb_var(struct ble_gattc_proc *proc, int status,
                            uint16_t att_handle, struct os_mbuf **om)
 {
     struct ble_gatt_attr attr[proc->read_mult.num_handles];
+    struct ble_gattc_proc *prev_proc;
     int rc;
     int i;
     uint16_t attr_len;
+    uint16_t copy_len;
 
     if (proc->read_mult.cb_mult == NULL) {
         return 0;
@@ -3474,7 +3587,8 @@ ble_gattc_read_mult_cb_var(struct ble_gattc_proc *proc, int status,
     for (i = 0; i < proc->read_mult.num_handles; i++) {
         attr[i].handle = proc->read_mult.handles[i];
         attr[i].offset = 0;
-        if (om == NULL || OS_MBUF_PKTLEN(*om) == 0) {
+        /* A response cut at the MTU can end inside a length field. */
+        if (om == NULL || OS_MBUF_PKTLEN(*om) < 2) {
             continue;
         }
 
@@ -3486,32 +3600,39 @@ ble_gattc_read_mult_cb_var(struct ble_gattc_proc *proc, int status,
         os_mbuf_adj(*om, 2);
 
         if (attr_len > BLE_ATT_ATTR_MAX_LEN) {
-            /*TODO Figure out what to do here */
+            status = BLE_HS_EBADDATA;
             break;
         }
 
-        attr[i].om = os_msys_get_pkthdr(attr_len, 0);
+        /* The last value is cut short when the response is limited by the
+         * MTU.  Report what was received; the application can read the rest
+         * with a Read Blob from this length.  Values that did not fit at all
+         * are left without an mbuf.
+         */
+        copy_len = min(attr_len, OS_MBUF_PKTLEN(*om));
+
+        attr[i].om = os_msys_get_pkthdr(copy_len, 0);
         if (!attr[i].om) {
-            /*TODO Figure out what to do here */
+            status = BLE_HS_ENOMEM;
             break;
         }
 
-        rc = os_mbuf_appendfrom(attr[i].om, *om, 0, attr_len);
+        rc = os_mbuf_appendfrom(attr[i].om, *om, 0, copy_len);
         if (rc) {
-            /*TODO Figure out what to do here */
+            status = BLE_HS_ENOMEM;
             break;
         }
 
-        os_mbuf_adj(*om, attr_len);
+        os_mbuf_adj(*om, copy_len);
     }
 
-    /*FIXME Testing assert */
-    assert(i == proc->read_mult.num_handles);
-
+    prev_proc = ble_gattc_read_cur_proc;
+    ble_gattc_read_cur_proc = proc;
     proc->read_mult.cb_mult(proc->conn_handle,
                     ble_gattc_error(status, att_handle), &attr[0],
-                    i,
+                    proc->read_mult.num_handles,
                     proc->read_mult.cb_arg);
+    ble_gattc_read_cur_proc = prev_proc;
 
     for (i = 0; i < proc->read_mult.num_handles; i++) {
         if (attr[i].om != NULL) {
@@ -3734,7 +3855,7 @@ ble_gattc_write_no_rsp(uint16_t conn_handle, uint16_t attr_handle,
     if (rc != 0) {
         STATS_INC(ble_gattc_stats, write);
     }
-    ble_eatt_release_chan(conn_handle, BLE_GATT_OP_DUMMY);
+    ble_eatt_release_chan(conn_handle, cid);
 
     return rc;
 }
@@ -5395,18 +5516,22 @@ ble_gattc_connection_broken(uint16_t conn_handle)
 int
 ble_gattc_any_jobs(void)
 {
-    return !STAILQ_EMPTY(&ble_gattc_procs);
+    return !TAILQ_EMPTY(&ble_gattc_procs);
 }
 
 int
 ble_gattc_init(void)
 {
     int rc;
+    int i;
 
 #if MYNEWT_VAL(BLE_GATTC_PROC_PREEMPTION_PROTECT)
     STAILQ_INIT(&temp_proc_list);
 #endif
-    STAILQ_INIT(&ble_gattc_procs);
+    TAILQ_INIT(&ble_gattc_procs);
+    for (i = 0; i < BLE_GATTC_PROC_BUCKETS; i++) {
+        TAILQ_INIT(ble_gattc_proc_buckets + i);
+    }
 
     if (MYNEWT_VAL(BLE_GATT_MAX_PROCS) > 0) {
         rc = os_mempool_init(&ble_gattc_proc_pool,
@@ -862,16 +862,17 @@ ble_gattc_cache_conn_disc_complete(struct ble_gattc_cache_conn *peer, int rc)
     }
 }
 
-void
+int
 ble_gattc_cache_conn_undisc_all(ble_addr_t peer_addr)
 {
     struct ble_gattc_cache_conn * peer = NULL;
 
     peer = ble_gattc_cache_conn_find_by_addr(peer_addr);
     if (peer == NULL) {
-        return;
+        return BLE_HS_ENOENT;
     }
     ble_gattc_cacheReset(&peer->ble_gattc_cache_conn_addr);
+    peer->cache_state = CACHE_INVALID;
 
     struct ble_gattc_cache_conn_svc *svc;
 
@@ -879,6 +880,8 @@ ble_gattc_cache_conn_undisc_all(ble_addr_t peer_addr)
         SLIST_REMOVE_HEAD(&peer->svcs, next);
         ble_gattc_cache_conn_svc_delete(svc);
     }
+
+    return 0;
 }
 
 static int
@@ -1237,6 +1240,7 @@ ble_gattc_cache_conn_update(uint16_t conn_handle, uint16_t start_handle, uint16_
     peer = ble_gattc_cache_conn_find(conn_handle);
     if (peer == NULL) {
         BLE_HS_LOG(ERROR, "Cannot find connection with conn_handle %d", conn_handle);
+        return;
     }
 
     peer->cache_state = CACHE_INVALID;
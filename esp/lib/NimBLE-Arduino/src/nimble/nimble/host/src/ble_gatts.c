@@ -53,6 +53,11 @@ enum {
 struct ble_gatts_aware_state ble_gatts_conn_aware_states[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
 /* index of latest bonded peer */
 static int last_conn_aware_state_index;
+
+/* Database hash, valid while the attribute table generation matches */
+static uint8_t ble_gatts_hash[16];
+static uint32_t ble_gatts_hash_gen;
+static uint8_t ble_gatts_hash_valid;
 #endif
 static const ble_uuid_t *uuid_pri =
     BLE_UUID16_DECLARE(BLE_ATT_UUID_PRIMARY_SERVICE);
@@ -601,6 +606,16 @@ ble_gatts_calculate_hash(uint8_t *out_hash_key)
     int rc;
     uint8_t *buf;
     uint8_t key[16];
+    uint32_t gen;
+
+    /* The hash only changes with the attribute table, so it is computed on
+     * the first read after a change and served from the cache after that.
+     */
+    gen = ble_att_svr_db_generation();
+    if (ble_gatts_hash_valid && ble_gatts_hash_gen == gen) {
+        memcpy(out_hash_key, ble_gatts_hash, sizeof(ble_gatts_hash));
+        return 0;
+    }
 
     memset(key, 0, sizeof(key));
     /* data with all zeroes */
@@ -626,6 +641,10 @@ ble_gatts_calculate_hash(uint8_t *out_hash_key)
 
     swap_in_place(out_hash_key, 16);
 
+    memcpy(ble_gatts_hash, out_hash_key, sizeof(ble_gatts_hash));
+    ble_gatts_hash_gen = gen;
+    ble_gatts_hash_valid = 1;
+
     rc = 0;
 done:
     nimble_platform_mem_free(buf);
@@ -1486,7 +1505,9 @@ ble_gatts_connection_broken(uint16_t conn_handle)
 
 #if MYNEWT_VAL(BLE_GATT_CACHING)
     struct ble_hs_conn_addrs addrs;
+#if MYNEWT_VAL(BLE_DYNAMIC_SERVICE)
     int i;
+#endif
 #endif
 
     /* Find the specified connection and extract its CCCD entries.  Extracting
@@ -2111,9 +2132,6 @@ ble_gatts_chr_updated(uint16_t chr_val_handle)
 
     ble_hs_lock();
     for (i = 0; ; i++) {
-        /* XXX: This is inefficient when there are a lot of connections.
-         * Consider using a "foreach" function to walk the connection list.
-         */
         conn = ble_hs_conn_find_by_idx(i);
         if (conn == NULL) {
             break;
@@ -394,6 +394,11 @@ ble_hs_sync(void)
             ble_hs_cfg.sync_cb();
         }
 
+#if NIMBLE_BLE_CONNECT
+        /* Have the pairing key material ready before the first pairing. */
+        ble_sm_pre_kick();
+#endif
+
         STATS_INC(ble_hs_stats, sync);
     }
 
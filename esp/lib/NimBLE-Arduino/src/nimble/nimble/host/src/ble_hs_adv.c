@@ -26,11 +26,6 @@
 #include "nimble/nimble/host/include/host/ble_ead.h"
 #endif
 
-struct find_field_data {
-    uint8_t type;
-    const struct ble_hs_adv_field *field;
-};
-
 static ble_uuid16_t ble_hs_adv_uuids16[BLE_HS_ADV_MAX_FIELD_SZ / 2];
 static ble_uuid32_t ble_hs_adv_uuids32[BLE_HS_ADV_MAX_FIELD_SZ / 4];
 static ble_uuid128_t ble_hs_adv_uuids128[BLE_HS_ADV_MAX_FIELD_SZ / 16];
@@ -957,40 +952,137 @@ ble_hs_adv_parse(const uint8_t *data, uint8_t length,
     return 0;
 }
 
-static int
-find_field_func(const struct ble_hs_adv_field *field, void *user_data)
+int
+ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
+                      const struct ble_hs_adv_field **out)
 {
-    struct find_field_data *ffd = user_data;
+    const struct ble_hs_adv_field *field;
+
+    /* Walk the buffer directly rather than through ble_hs_adv_parse(); this
+     * is called for every advertising report during discovery.
+     */
+    while (length > 1) {
+        field = (const void *) data;
+
+        if (field->length >= length) {
+            return BLE_HS_EBADDATA;
+        }
 
-    if (field->type != ffd->type) {
-        return BLE_HS_EAGAIN;
+        /* A zero length field has no type octet; never match one. */
+        if (field->length != 0 && field->type == type) {
+            *out = field;
+            return 0;
+        }
+
+        length -= 1 + field->length;
+        data += 1 + field->length;
     }
 
-    ffd->field = field;
+    return BLE_HS_ENOENT;
+}
 
-    return 0;
+static inline int
+ble_hs_adv_view_slot(uint64_t want, uint64_t bit)
+{
+    /* Slots are packed in ascending bit order, so the slot index is the
+     * number of requested types below this one.
+     */
+    return __builtin_popcountll(want & (bit - 1));
 }
 
+/**
+ * Extracts the AD types selected by view->want from an advertising data
+ * buffer in a single pass.
+ *
+ * Nothing is copied: each found slot points into the supplied buffer, which
+ * must outlive the view. For types that occur more than once the slot
+ * describes the first occurrence and records the number of occurrences.
+ * Slots are only written for types that are present; check view->found or
+ * use ble_hs_adv_view_get() before reading one.
+ *
+ * @param view                  The view to fill. view->want and
+ *                                  view->fields must be set by the caller.
+ * @param data                  The advertising data to parse.
+ * @param length                The length of the advertising data, up to
+ *                                  the size of extended advertising data.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EBADDATA if a field overruns the
+ *                                  buffer. Fields preceding the bad one
+ *                                  are still reported.
+ */
 int
-ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
-                      const struct ble_hs_adv_field **out)
+ble_hs_adv_parse_view(struct ble_hs_adv_view *view,
+                      const uint8_t *data, uint16_t length)
 {
-    int rc;
-    struct find_field_data ffd = {
-            .type = type,
-            .field = NULL,
-    };
+    struct ble_hs_adv_view_field *slot;
+    uint8_t field_len;
+    uint64_t bit;
 
-    rc = ble_hs_adv_parse(data, length, find_field_func, &ffd);
-    if (rc != 0) {
-        return rc;
+    view->found = 0;
+
+    while (length > 1) {
+        field_len = data[0];
+        if (field_len >= length) {
+            return BLE_HS_EBADDATA;
+        }
+
+        /* A zero length field carries no type; step over it. */
+        if (field_len != 0) {
+            bit = BLE_HS_ADV_VIEW_BIT(data[1]) & view->want;
+            if (bit != 0) {
+                slot = &view->fields[ble_hs_adv_view_slot(view->want, bit)];
+                if (view->found & bit) {
+                    slot->count++;
+                } else {
+                    view->found |= bit;
+                    slot->value = data + 2;
+                    slot->value_len = field_len - 1;
+                    slot->count = 1;
+                }
+            }
+        }
+
+        length -= 1 + field_len;
+        data += 1 + field_len;
     }
 
-    if (!ffd.field) {
+    return 0;
+}
+
+/**
+ * Looks up an AD type in a view filled by ble_hs_adv_parse_view().
+ *
+ * @param view                  The parsed view.
+ * @param type                  The AD type to look up.
+ * @param value                 On success, points to the value of the first
+ *                                  occurrence. Can be NULL.
+ * @param value_len             On success, the length of that value. Can be
+ *                                  NULL.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if the type was not requested
+ *                                  or not present.
+ */
+int
+ble_hs_adv_view_get(const struct ble_hs_adv_view *view, uint8_t type,
+                    const uint8_t **value, uint8_t *value_len)
+{
+    const struct ble_hs_adv_view_field *slot;
+    uint64_t bit;
+
+    bit = BLE_HS_ADV_VIEW_BIT(type) & view->found;
+    if (bit == 0) {
         return BLE_HS_ENOENT;
     }
 
-    *out = ffd.field;
+    slot = &view->fields[ble_hs_adv_view_slot(view->want, bit)];
+    if (value != NULL) {
+        *value = slot->value;
+    }
+    if (value_len != NULL) {
+        *value_len = slot->value_len;
+    }
 
     return 0;
 }
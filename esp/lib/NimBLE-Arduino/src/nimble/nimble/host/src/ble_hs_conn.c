@@ -38,6 +38,77 @@ static os_membuf_t ble_hs_conn_elem_mem[
 
 static const uint8_t ble_hs_conn_null_addr[6];
 
+/**
+ * Lookup tables, rebuilt whenever a connection is inserted or removed or a
+ * peer address changes:
+ *     o ble_hs_conn_live: established connections in list order (newest
+ *       first), for index lookups and iteration.
+ *     o ble_hs_conn_handle_tbl: open-addressed hash keyed by connection
+ *       handle.
+ *     o ble_hs_conn_addr_tbl: open-addressed hash keyed by peer address; each
+ *       connection appears under its peer address and its peer RPA.
+ * Both hash tables are larger than the number of entries they can hold, so a
+ * probe always terminates at an empty slot.
+ */
+#define BLE_HS_CONN_HANDLE_TBL_SZ   (2 * MYNEWT_VAL(BLE_MAX_CONNECTIONS) + 1)
+#define BLE_HS_CONN_ADDR_TBL_SZ     (4 * MYNEWT_VAL(BLE_MAX_CONNECTIONS) + 1)
+
+static struct ble_hs_conn *ble_hs_conn_live[MYNEWT_VAL(BLE_MAX_CONNECTIONS)];
+static uint8_t ble_hs_conn_num_live;
+static struct ble_hs_conn *ble_hs_conn_handle_tbl[BLE_HS_CONN_HANDLE_TBL_SZ];
+static struct ble_hs_conn *ble_hs_conn_addr_tbl[BLE_HS_CONN_ADDR_TBL_SZ];
+
+static unsigned int
+ble_hs_conn_addr_hash(const uint8_t *val)
+{
+    return (get_le32(val) ^ ((uint32_t)get_le16(val + 4) << 7)) %
+           BLE_HS_CONN_ADDR_TBL_SZ;
+}
+
+static void
+ble_hs_conn_addr_tbl_insert(const ble_addr_t *addr, struct ble_hs_conn *conn)
+{
+    unsigned int i;
+
+    if (memcmp(addr->val, ble_hs_conn_null_addr, 6) == 0) {
+        return;
+    }
+
+    i = ble_hs_conn_addr_hash(addr->val);
+    while (ble_hs_conn_addr_tbl[i] != NULL) {
+        if (ble_hs_conn_addr_tbl[i] == conn) {
+            /* Peer address and RPA are the same. */
+            return;
+        }
+        i = (i + 1) % BLE_HS_CONN_ADDR_TBL_SZ;
+    }
+    ble_hs_conn_addr_tbl[i] = conn;
+}
+
+static void
+ble_hs_conn_reindex(void)
+{
+    struct ble_hs_conn *conn;
+    unsigned int i;
+    int idx;
+
+    memset(ble_hs_conn_handle_tbl, 0, sizeof ble_hs_conn_handle_tbl);
+    memset(ble_hs_conn_addr_tbl, 0, sizeof ble_hs_conn_addr_tbl);
+
+    for (idx = 0; idx < ble_hs_conn_num_live; idx++) {
+        conn = ble_hs_conn_live[idx];
+
+        i = conn->bhc_handle % BLE_HS_CONN_HANDLE_TBL_SZ;
+        while (ble_hs_conn_handle_tbl[i] != NULL) {
+            i = (i + 1) % BLE_HS_CONN_HANDLE_TBL_SZ;
+        }
+        ble_hs_conn_handle_tbl[i] = conn;
+
+        ble_hs_conn_addr_tbl_insert(&conn->bhc_peer_addr, conn);
+        ble_hs_conn_addr_tbl_insert(&conn->bhc_peer_rpa_addr, conn);
+    }
+}
+
 int
 ble_hs_conn_can_alloc(void)
 {
@@ -220,10 +291,12 @@ void
 ble_hs_conn_foreach(ble_hs_conn_foreach_fn *cb, void *arg)
 {
     struct ble_hs_conn *conn;
+    int i;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+    for (i = 0; i < ble_hs_conn_num_live; i++) {
+        conn = ble_hs_conn_live[i];
         if (cb(conn, arg) != 0) {
             return;
         }
@@ -275,7 +348,15 @@ ble_hs_conn_insert(struct ble_hs_conn *conn)
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
     BLE_HS_DBG_ASSERT_EVAL(ble_hs_conn_find(conn->bhc_handle) == NULL);
+    BLE_HS_DBG_ASSERT(ble_hs_conn_num_live < MYNEWT_VAL(BLE_MAX_CONNECTIONS));
     SLIST_INSERT_HEAD(&ble_hs_conns, conn, bhc_next);
+
+    memmove(ble_hs_conn_live + 1, ble_hs_conn_live,
+            ble_hs_conn_num_live * sizeof ble_hs_conn_live[0]);
+    ble_hs_conn_live[0] = conn;
+    ble_hs_conn_num_live++;
+
+    ble_hs_conn_reindex();
 }
 
 void
@@ -285,9 +366,38 @@ ble_hs_conn_remove(struct ble_hs_conn *conn)
     return;
 #endif
 
+    int i;
+
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
     SLIST_REMOVE(&ble_hs_conns, conn, ble_hs_conn, bhc_next);
+
+    for (i = 0; i < ble_hs_conn_num_live; i++) {
+        if (ble_hs_conn_live[i] == conn) {
+            ble_hs_conn_num_live--;
+            memmove(ble_hs_conn_live + i, ble_hs_conn_live + i + 1,
+                    (ble_hs_conn_num_live - i) * sizeof ble_hs_conn_live[0]);
+            break;
+        }
+    }
+
+    ble_hs_conn_reindex();
+}
+
+/**
+ * Refreshes the address index after a connection's peer address has been
+ * updated, e.g., when the peer distributes its identity address.
+ */
+void
+ble_hs_conn_peer_addr_updated(void)
+{
+#if !NIMBLE_BLE_CONNECT
+    return;
+#endif
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    ble_hs_conn_reindex();
 }
 
 struct ble_hs_conn *
@@ -298,13 +408,16 @@ ble_hs_conn_find(uint16_t conn_handle)
 #endif
 
     struct ble_hs_conn *conn;
+    unsigned int i;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+    i = conn_handle % BLE_HS_CONN_HANDLE_TBL_SZ;
+    while ((conn = ble_hs_conn_handle_tbl[i]) != NULL) {
         if (conn->bhc_handle == conn_handle) {
             return conn;
         }
+        i = (i + 1) % BLE_HS_CONN_HANDLE_TBL_SZ;
     }
 
     return NULL;
@@ -321,6 +434,26 @@ ble_hs_conn_find_assert(uint16_t conn_handle)
     return conn;
 }
 
+static int
+ble_hs_conn_addr_matches(struct ble_hs_conn *conn, const ble_addr_t *addr)
+{
+    struct ble_hs_conn_addrs addrs;
+
+    if (BLE_ADDR_IS_RPA(addr)) {
+        return ble_addr_cmp(&conn->bhc_peer_rpa_addr, addr) == 0;
+    }
+
+    if (ble_addr_cmp(&conn->bhc_peer_addr, addr) == 0) {
+        return 1;
+    }
+    if (conn->bhc_peer_addr.type < BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT) {
+        return 0;
+    }
+    /*If type 0x02 or 0x03 is used, let's double check if address is good */
+    ble_hs_conn_addrs(conn, &addrs);
+    return ble_addr_cmp(&addrs.peer_id_addr, addr) == 0;
+}
+
 struct ble_hs_conn *
 ble_hs_conn_find_by_addr(const ble_addr_t *addr)
 {
@@ -329,7 +462,7 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
 #endif
 
     struct ble_hs_conn *conn;
-    struct ble_hs_conn_addrs addrs;
+    unsigned int i;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
@@ -337,25 +470,28 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
         return NULL;
     }
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
-        if (BLE_ADDR_IS_RPA(addr)) {
-            if (ble_addr_cmp(&conn->bhc_peer_rpa_addr, addr) == 0) {
-                return conn;
-            }
-        } else {
-            if (ble_addr_cmp(&conn->bhc_peer_addr, addr) == 0) {
-                return conn;
-            }
-            if (conn->bhc_peer_addr.type < BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT) {
-                continue;
-            }
-            /*If type 0x02 or 0x03 is used, let's double check if address is good */
-            ble_hs_conn_addrs(conn, &addrs);
-            if (ble_addr_cmp(&addrs.peer_id_addr, addr) == 0) {
+    i = ble_hs_conn_addr_hash(addr->val);
+    while ((conn = ble_hs_conn_addr_tbl[i]) != NULL) {
+        if (ble_hs_conn_addr_matches(conn, addr)) {
+            return conn;
+        }
+        i = (i + 1) % BLE_HS_CONN_ADDR_TBL_SZ;
+    }
+
+#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
+    /* The identity address may come from the resolving list rather than the
+     * connection itself, so it is not indexed.
+     */
+    if (!BLE_ADDR_IS_RPA(addr)) {
+        for (i = 0; i < ble_hs_conn_num_live; i++) {
+            conn = ble_hs_conn_live[i];
+            if (conn->bhc_peer_addr.type >= BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT &&
+                ble_hs_conn_addr_matches(conn, addr)) {
                 return conn;
             }
         }
     }
+#endif
 
     return NULL;
 }
@@ -367,21 +503,13 @@ ble_hs_conn_find_by_idx(int idx)
     return NULL;
 #endif
 
-    struct ble_hs_conn *conn;
-    int i;
-
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    i = 0;
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
-        if (i == idx) {
-            return conn;
-        }
-
-        i++;
+    if (idx < 0 || idx >= ble_hs_conn_num_live) {
+        return NULL;
     }
 
-    return NULL;
+    return ble_hs_conn_live[idx];
 }
 
 int
@@ -587,5 +715,8 @@ ble_hs_conn_init(void)
 
     SLIST_INIT(&ble_hs_conns);
 
+    ble_hs_conn_num_live = 0;
+    ble_hs_conn_reindex();
+
     return 0;
 }
@@ -275,7 +275,7 @@ static struct ble_hs_hci_sup_cmd ble_hs_hci_sup_cmd;
 #if CONFIG_BT_NIMBLE_LEGACY_VHCI_ENABLE
 #define BLE_HS_HCI_FRAG_DATABUF_SIZE    \
     (BLE_ACL_MAX_PKT_SIZE +             \
-     BLE_HCI_DATA_HDR_SZ +              \
+     BLE_HCI_DATA_HDR_SZ + 1 +          \
      sizeof (struct os_mbuf_pkthdr) +   \
      sizeof (struct ble_mbuf_hdr) +     \
      sizeof (struct os_mbuf))
@@ -356,6 +356,35 @@ ble_hs_hci_set_buf_sz(uint16_t pktlen, uint16_t max_pkts)
     return 0;
 }
 
+int
+ble_hs_conn_get_tx_state(uint16_t conn_handle,
+                         struct ble_hs_conn_tx_state *out_state)
+{
+    const struct os_mbuf_pkthdr *omp;
+    struct ble_hs_conn *conn;
+    int rc;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        out_state->outstanding = conn->bhc_outstanding_pkts;
+        out_state->queued = 0;
+        STAILQ_FOREACH(omp, &conn->bhc_tx_q, omp_next) {
+            out_state->queued++;
+        }
+        out_state->avail = ble_hs_hci_avail_pkts;
+        out_state->total = ble_hs_hci_max_pkts;
+        rc = 0;
+    }
+
+    ble_hs_unlock();
+
+    return rc;
+}
+
 /**
  * Increases the count of available controller ACL buffers.
  */
@@ -719,7 +748,8 @@ ble_hs_hci_frag_alloc(uint16_t frag_size, void *arg)
 #endif
     if (om != NULL) {
 #if CONFIG_BT_NIMBLE_LEGACY_VHCI_ENABLE
-        om->om_data += BLE_HCI_DATA_HDR_SZ;
+        /* Leave room for the H4 indicator so VHCI can send in place. */
+        om->om_data += BLE_HCI_DATA_HDR_SZ + 1;
 #else
         om->om_data += BLE_HCI_DATA_HDR_SZ + BLE_HS_CTRL_DATA_HDR_SZ;
 #endif
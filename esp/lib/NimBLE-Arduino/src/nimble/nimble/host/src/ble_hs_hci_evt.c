@@ -40,6 +40,9 @@ extern int ble_gap_slave_adv_reattempt(void);
 extern int slave_conn[MYNEWT_VAL(BLE_MAX_CONNECTIONS) + 1];
 #endif
 
+static ble_hs_tx_complete_fn *ble_hs_hci_evt_tx_complete_cb;
+static void *ble_hs_hci_evt_tx_complete_cb_arg;
+
 #if MYNEWT_VAL(BLE_QUEUE_CONG_CHECK)
 static struct ble_npl_mutex adv_list_lock;
 static uint16_t ble_adv_list_count;
@@ -239,6 +242,7 @@ ble_hs_hci_evt_disconn_complete(uint8_t event_code, const void *data,
 {
     const struct ble_hci_ev_disconn_cmp *ev = data;
     const struct ble_hs_conn *conn;
+    uint16_t num_pkts = 0;
 
     if (len != sizeof(*ev)) {
         return BLE_HS_ECONTROLLER;
@@ -247,10 +251,17 @@ ble_hs_hci_evt_disconn_complete(uint8_t event_code, const void *data,
     ble_hs_lock();
     conn = ble_hs_conn_find(le16toh(ev->conn_handle));
     if (conn != NULL) {
-        ble_hs_hci_add_avail_pkts(conn->bhc_outstanding_pkts);
+        num_pkts = conn->bhc_outstanding_pkts;
+        ble_hs_hci_add_avail_pkts(num_pkts);
     }
     ble_hs_unlock();
 
+    /* Wake anyone waiting for the packets that will now never complete. */
+    if (num_pkts > 0 && ble_hs_hci_evt_tx_complete_cb != NULL) {
+        ble_hs_hci_evt_tx_complete_cb(le16toh(ev->conn_handle), num_pkts,
+                                      ble_hs_hci_evt_tx_complete_cb_arg);
+    }
+
 #if MYNEWT_VAL(BLE_ENABLE_CONN_REATTEMPT)
     if (conn) {
         uint16_t handle;
@@ -374,6 +385,13 @@ ble_hs_hci_evt_enc_key_refresh(uint8_t event_code, const void *data,
 }
 #endif
 
+void
+ble_hs_set_tx_complete_cb(ble_hs_tx_complete_fn *cb, void *arg)
+{
+    ble_hs_hci_evt_tx_complete_cb = cb;
+    ble_hs_hci_evt_tx_complete_cb_arg = arg;
+}
+
 static int
 ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, const void *data,
                                   unsigned int len)
@@ -407,6 +425,12 @@ ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, const void *data,
                 ble_hs_hci_add_avail_pkts(num_pkts);
             }
             ble_hs_unlock();
+
+            if (conn != NULL && ble_hs_hci_evt_tx_complete_cb != NULL) {
+                ble_hs_hci_evt_tx_complete_cb(le16toh(ev->completed[i].handle),
+                                              num_pkts,
+                                              ble_hs_hci_evt_tx_complete_cb_arg);
+            }
         }
     }
 
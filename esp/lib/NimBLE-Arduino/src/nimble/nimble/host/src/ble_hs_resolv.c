@@ -26,6 +26,7 @@
 #include <string.h>
 #include "ble_hs_priv.h"
 #include "nimble/nimble/host/include/host/ble_hs_id.h"
+#include "nimble/nimble/host/include/host/ble_hs_pvcy.h"
 #include "nimble/nimble/include/nimble/ble.h"
 #include "nimble/nimble/include/nimble/nimble_opt.h"
 #include "ble_hs_resolv_priv.h"
@@ -39,10 +40,43 @@
 struct ble_hs_resolv_data {
     uint8_t addr_res_enabled;
     uint8_t rl_cnt;
+    /* Resolving list index of the last peer resolved; tried first. */
+    uint8_t last_match;
     uint32_t rpa_tmo;
     struct ble_npl_callout rpa_timer;
 };
 
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+/*
+ * Recently seen RPAs and the IRK that resolved them. A peer keeps the same
+ * RPA for many minutes and advertises it many times a second, so once it
+ * has been resolved there is no need to try every bonded IRK again.
+ *
+ * RPAs that resolve against no bonded IRK are remembered too; in a busy
+ * environment most reports come from strangers. These are tagged with the
+ * IRK generation and dropped as soon as a device joins the resolving list.
+ *
+ * Entries store the IRK rather than a list index, so they stay correct when
+ * the lists are reordered: a hit is only used if the IRK is still present.
+ */
+struct ble_hs_resolv_cache_entry {
+    uint8_t rpa[BLE_DEV_ADDR_LEN];
+    uint8_t valid;
+    uint8_t resolved;
+    uint8_t irk[16];
+    uint16_t irk_gen;
+    uint16_t last_used;
+    ble_npl_time_t added;
+};
+
+static struct ble_hs_resolv_cache_entry
+    g_ble_hs_resolv_cache[MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE)];
+static uint16_t g_ble_hs_resolv_irk_gen;
+static uint16_t g_ble_hs_resolv_cache_seq;
+#endif
+
+static struct ble_hs_resolv_stats g_ble_hs_resolv_stats;
+
 static struct ble_hs_resolv_data g_ble_hs_resolv_data;
 static struct ble_hs_resolv_entry g_ble_hs_resolv_list[BLE_RESOLV_LIST_SIZE];
 /* Allocate one extra space for peer_records than no. of Bonds, it will take
@@ -53,6 +87,94 @@ static int ble_store_num_peer_dev_rec;
 /* NRPA bit: Enables NRPA as private address. */
 static bool nrpa_pvcy;
 
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+static void
+ble_hs_resolv_cache_clear(void)
+{
+    memset(g_ble_hs_resolv_cache, 0, sizeof g_ble_hs_resolv_cache);
+}
+
+/* Finds a live cache entry for the RPA, expiring stale ones on the way. */
+static struct ble_hs_resolv_cache_entry *
+ble_hs_resolv_cache_find(const uint8_t *rpa)
+{
+    struct ble_hs_resolv_cache_entry *entry;
+    ble_npl_time_t now;
+    int i;
+
+    now = ble_npl_time_get();
+
+    for (i = 0; i < MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE); i++) {
+        entry = &g_ble_hs_resolv_cache[i];
+        if (!entry->valid) {
+            continue;
+        }
+
+        /* The peer will have moved to a new RPA by now. */
+        if ((ble_npl_time_t)(now - entry->added) >=
+            g_ble_hs_resolv_data.rpa_tmo) {
+            entry->valid = 0;
+            continue;
+        }
+
+        if (memcmp(entry->rpa, rpa, BLE_DEV_ADDR_LEN) != 0) {
+            continue;
+        }
+
+        if (!entry->resolved && entry->irk_gen != g_ble_hs_resolv_irk_gen) {
+            /* A device has been added since; it may resolve now. */
+            entry->valid = 0;
+            return NULL;
+        }
+
+        entry->last_used = ++g_ble_hs_resolv_cache_seq;
+        return entry;
+    }
+
+    return NULL;
+}
+
+/* Records the IRK an RPA resolved to, or NULL if it resolved to none. */
+static void
+ble_hs_resolv_cache_add(const uint8_t *rpa, const uint8_t *irk)
+{
+    struct ble_hs_resolv_cache_entry *victim;
+    struct ble_hs_resolv_cache_entry *entry;
+    int i;
+
+    victim = &g_ble_hs_resolv_cache[0];
+    for (i = 0; i < MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE); i++) {
+        entry = &g_ble_hs_resolv_cache[i];
+        if (!entry->valid) {
+            victim = entry;
+            break;
+        }
+
+        /* Resolved entries are worth more than unresolvable ones. */
+        if (entry->resolved != victim->resolved) {
+            if (!entry->resolved) {
+                victim = entry;
+            }
+        } else if ((int16_t)(entry->last_used - victim->last_used) < 0) {
+            victim = entry;
+        }
+    }
+
+    memcpy(victim->rpa, rpa, BLE_DEV_ADDR_LEN);
+    if (irk != NULL) {
+        memcpy(victim->irk, irk, 16);
+        victim->resolved = 1;
+    } else {
+        memset(victim->irk, 0, 16);
+        victim->resolved = 0;
+    }
+    victim->irk_gen = g_ble_hs_resolv_irk_gen;
+    victim->last_used = ++g_ble_hs_resolv_cache_seq;
+    victim->added = ble_npl_time_get();
+    victim->valid = 1;
+}
+#endif
+
 /*** APIs for Peer Device Records.
  *
  * These Peer records are necessary to take care of Peers with RPA address when
@@ -173,10 +295,30 @@ ble_rpa_find_peer_dev_by_irk(uint8_t *irk)
 static bool
 is_rpa_resolvable_by_peer_rec(struct ble_hs_dev_records *p_dev_rec, uint8_t *peer_add)
 {
-    if (p_dev_rec->peer_sec.irk_present) {
-        if (ble_hs_resolv_rpa(peer_add, p_dev_rec->peer_sec.irk) == 0) {
-            return true;
-        }
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    struct ble_hs_resolv_cache_entry *entry;
+#endif
+
+    if (!p_dev_rec->peer_sec.irk_present) {
+        return false;
+    }
+
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    /* An RPA resolves under exactly one IRK, so a cached resolution
+     * answers the question for every record. Unresolvable entries are not
+     * used here: peer records can hold IRKs not yet on the resolving list.
+     */
+    entry = ble_hs_resolv_cache_find(peer_add);
+    if (entry != NULL && entry->resolved) {
+        return memcmp(entry->irk, p_dev_rec->peer_sec.irk, 16) == 0;
+    }
+#endif
+
+    if (ble_hs_resolv_rpa(peer_add, p_dev_rec->peer_sec.irk) == 0) {
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+        ble_hs_resolv_cache_add(peer_add, p_dev_rec->peer_sec.irk);
+#endif
+        return true;
     }
     return false;
 }
@@ -210,6 +352,7 @@ ble_rpa_replace_id_with_rand_addr(uint8_t *addr_type, uint8_t *peer_addr)
                 memcpy(&conn->bhc_peer_rpa_addr.val[0], p_dev_rec->rand_addr, BLE_DEV_ADDR_LEN);
                 conn->bhc_peer_addr.type = p_dev_rec->rand_addr_type;
                 memcpy(&conn->bhc_peer_addr.val[0], p_dev_rec->rand_addr, BLE_DEV_ADDR_LEN);
+                ble_hs_conn_peer_addr_updated();
                 BLE_HS_LOG(DEBUG, "\n Replace Identity addr with random addr received at"
                                   " start of the connection\n");
             }
@@ -455,6 +598,10 @@ ble_hs_resolv_rpa_timer_cb(struct ble_npl_event *ev)
     if (ble_host_rpa_enabled() || (nrpa_pvcy)) {
         BLE_HS_LOG(DEBUG, "RPA/NRPA Timeout; start active adv & scan with new Private address \n");
         ble_gap_preempt();
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+        /* Peers rotate their RPAs on the same kind of timer. */
+        ble_hs_resolv_cache_clear();
+#endif
         /* Generate local private address */
         ble_hs_gen_own_private_rnd();
         ble_npl_callout_reset(&g_ble_hs_resolv_data.rpa_timer,
@@ -590,6 +737,9 @@ ble_hs_resolv_list_add(uint8_t *cmdbuf)
     ble_hs_resolv_gen_priv_addr(rl, 1);
     ble_hs_resolv_gen_priv_addr(rl, 0);
     ++(g_ble_hs_resolv_data.rl_cnt);
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    ++g_ble_hs_resolv_irk_gen;
+#endif
     BLE_HS_LOG(DEBUG, "Device added to RL, Resolving list count = %d\n", g_ble_hs_resolv_data.rl_cnt);
 
     return 0;
@@ -637,6 +787,9 @@ void
 ble_hs_resolv_list_clear_all(void)
 {
     g_ble_hs_resolv_data.rl_cnt = 0;
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    ble_hs_resolv_cache_clear();
+#endif
     memset(g_ble_hs_resolv_list, 0, BLE_RESOLV_LIST_SIZE * sizeof(struct
            ble_hs_resolv_entry));
 
@@ -722,23 +875,109 @@ ble_hs_resolv_set_rpa_tmo(uint16_t tmo_secs)
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_STORE_MAX_BONDS)
+/* Finds the resolving list entry holding a peer IRK.
+ *
+ * @return the entry's index, 0 if none holds it. */
+static int
+ble_hs_resolv_list_find_irk(const uint8_t *irk)
+{
+    int i;
+
+    for (i = 1; i < g_ble_hs_resolv_data.rl_cnt; ++i) {
+        if (memcmp(g_ble_hs_resolv_list[i].rl_peer_irk, irk, 16) == 0) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+/* Tries the peer IRKs on the resolving list against an RPA, starting with
+ * the one that matched last time.
+ *
+ * @return the matching entry's index, 0 if none matches. */
+static int
+ble_hs_resolv_list_search(uint8_t *addr)
+{
+    int first;
+    int i;
+
+    first = g_ble_hs_resolv_data.last_match;
+    if (first > 0 && first < g_ble_hs_resolv_data.rl_cnt &&
+        ble_hs_resolv_rpa(addr, g_ble_hs_resolv_list[first].rl_peer_irk) == 0) {
+        return first;
+    }
+
+    for (i = 1; i < g_ble_hs_resolv_data.rl_cnt; ++i) {
+        if (i == first) {
+            continue;
+        }
+
+        if (ble_hs_resolv_rpa(addr, g_ble_hs_resolv_list[i].rl_peer_irk) == 0) {
+            g_ble_hs_resolv_data.last_match = i;
+            return i;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 struct ble_hs_resolv_entry *
 ble_hs_resolv_rpa_addr(uint8_t *addr, uint8_t addr_type) {
 #if MYNEWT_VAL(BLE_STORE_MAX_BONDS)
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    struct ble_hs_resolv_cache_entry *entry;
+#endif
+    struct ble_hs_resolv_entry *rl;
     int i;
-    struct ble_hs_resolv_entry *rl = &g_ble_hs_resolv_list[1];
 
-    for (i = 1; i < g_ble_hs_resolv_data.rl_cnt; ++i) {
-        if(ble_hs_resolv_rpa(addr, rl->rl_peer_irk) == 0) {
-            memcpy(g_ble_hs_resolv_list[i].rl_peer_rpa, addr, BLE_DEV_ADDR_LEN);
-            g_ble_hs_resolv_list[i].rl_addr_type = addr_type;
-            return rl;
+    /* Only resolvable private addresses can resolve; skip the AES for
+     * public, static and non-resolvable addresses.
+     */
+    if (g_ble_hs_resolv_data.rl_cnt <= 1 || !ble_hs_is_rpa(addr, addr_type)) {
+        return NULL;
+    }
+
+    i = 0;
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    entry = ble_hs_resolv_cache_find(addr);
+    if (entry != NULL) {
+        if (!entry->resolved) {
+            g_ble_hs_resolv_stats.neg_hits++;
+            return NULL;
         }
 
-        ++rl;
+        i = ble_hs_resolv_list_find_irk(entry->irk);
+        if (i == 0) {
+            /* The bond has been removed. */
+            entry->valid = 0;
+        } else {
+            g_ble_hs_resolv_stats.hits++;
+        }
     }
 #endif
+
+    if (i == 0) {
+        g_ble_hs_resolv_stats.misses++;
+        i = ble_hs_resolv_list_search(addr);
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+        ble_hs_resolv_cache_add(addr, i != 0 ?
+                                g_ble_hs_resolv_list[i].rl_peer_irk : NULL);
+#endif
+        if (i == 0) {
+            return NULL;
+        }
+    }
+
+    rl = &g_ble_hs_resolv_list[i];
+    memcpy(rl->rl_peer_rpa, addr, BLE_DEV_ADDR_LEN);
+    rl->rl_addr_type = addr_type;
+    return rl;
+#else
     return NULL;
+#endif
 }
 
 /**
@@ -759,6 +998,8 @@ ble_hs_resolv_rpa(uint8_t *rpa, uint8_t *irk)
         return BLE_HS_EINVAL;
     }
 
+    g_ble_hs_resolv_stats.aes_ops++;
+
     swap_buf(ecb.key, irk, 16);
     memset(ecb.plain_text, 0, 16);
 
@@ -785,6 +1026,18 @@ ble_hs_resolv_rpa(uint8_t *rpa, uint8_t *irk)
     return rc;
 }
 
+void
+ble_hs_resolv_stats(struct ble_hs_resolv_stats *out_stats)
+{
+    *out_stats = g_ble_hs_resolv_stats;
+}
+
+void
+ble_hs_resolv_stats_reset(void)
+{
+    memset(&g_ble_hs_resolv_stats, 0, sizeof g_ble_hs_resolv_stats);
+}
+
 void ble_hs_resolv_init(void)
 {
     g_ble_hs_resolv_data.rpa_tmo = ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_RPA_TIMEOUT) * 1000);
@@ -799,5 +1052,8 @@ void ble_hs_resolv_deinit(void)
 {
     ble_npl_callout_stop(&g_ble_hs_resolv_data.rpa_timer);
     ble_npl_callout_deinit(&g_ble_hs_resolv_data.rpa_timer);
+#if MYNEWT_VAL(BLE_HS_RESOLV_CACHE_SIZE) > 0
+    ble_hs_resolv_cache_clear();
+#endif
 }
 #endif  /* if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY) */
@@ -506,8 +506,11 @@ ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
          * that for first packet we need to decrease data size by 2 bytes for sdu
          * size
          */
-        rc = os_mbuf_appendfrom(txom, tx->sdus[0], tx->data_offset,
-                                len - sdu_size_offset);
+        rc = os_mbuf_cursor_seek(&tx->cursor, tx->sdus[0], tx->data_offset);
+        if (rc == 0) {
+            rc = os_mbuf_cursor_appendto(txom, &tx->cursor,
+                                         len - sdu_size_offset);
+        }
         if (rc) {
             rc = BLE_HS_ENOMEM;
             BLE_HS_LOG(DEBUG, "Could not append data rc=%d", rc);
@@ -535,6 +538,7 @@ ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
             os_mbuf_free_chain(tx->sdus[0]);
             tx->sdus[0] = NULL;
             tx->data_offset = 0;
+            os_mbuf_cursor_init(&tx->cursor, NULL);
             break;
         }
     }
@@ -559,6 +563,7 @@ ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
 failed:
     os_mbuf_free_chain(tx->sdus[0]);
     tx->sdus[0] = NULL;
+    os_mbuf_cursor_init(&tx->cursor, NULL);
 
     os_mbuf_free_chain(txom);
     if (tx->flags & BLE_L2CAP_COC_FLAG_STALLED) {
@@ -49,6 +49,8 @@ struct ble_l2cap_coc_endpoint {
     uint16_t credits;
     uint16_t data_offset;
     uint8_t flags;
+    /* TX position in sdus[0], so each fragment does not rewalk the SDU */
+    struct os_mbuf_cursor cursor;
 };
 
 struct ble_l2cap_coc_srv {
@@ -272,7 +272,7 @@ ble_sm_gen_pair_rand(uint8_t *pair_rand)
     }
 #endif
 
-    rc = ble_hs_hci_util_rand(pair_rand, 16);
+    rc = ble_sm_pre_rand(pair_rand, 16);
     if (rc != 0) {
         return rc;
     }
@@ -293,7 +293,7 @@ ble_sm_gen_ediv(struct ble_sm_master_id *master_id)
     }
 #endif
 
-    rc = ble_hs_hci_util_rand(&master_id->ediv, sizeof master_id->ediv);
+    rc = ble_sm_pre_rand(&master_id->ediv, sizeof master_id->ediv);
     if (rc != 0) {
         return rc;
     }
@@ -314,7 +314,7 @@ ble_sm_gen_master_id_rand(struct ble_sm_master_id *master_id)
     }
 #endif
 
-    rc = ble_hs_hci_util_rand(&master_id->rand_val, sizeof master_id->rand_val);
+    rc = ble_sm_pre_rand(&master_id->rand_val, sizeof master_id->rand_val);
     if (rc != 0) {
         return rc;
     }
@@ -336,7 +336,7 @@ ble_sm_gen_ltk(struct ble_sm_proc *proc, uint8_t *ltk)
     }
 #endif
 
-    rc = ble_hs_hci_util_rand(ltk, proc->key_size);
+    rc = ble_sm_pre_rand(ltk, proc->key_size);
     if (rc != 0) {
         return rc;
     }
@@ -361,7 +361,7 @@ ble_sm_gen_csrk(struct ble_sm_proc *proc, uint8_t *csrk)
     }
 #endif
 
-    rc = ble_hs_hci_util_rand(csrk, 16);
+    rc = ble_sm_pre_rand(csrk, 16);
     if (rc != 0) {
         return rc;
     }
@@ -594,6 +594,8 @@ ble_sm_persist_keys(struct ble_sm_proc *proc)
             }
 #endif
         }
+
+        ble_hs_conn_peer_addr_updated();
     } else {
         peer_addr = conn->bhc_peer_addr;
         peer_addr.type =
@@ -703,6 +705,18 @@ ble_sm_insert(struct ble_sm_proc *proc)
     STAILQ_INSERT_HEAD(&ble_sm_procs, proc, next);
 }
 
+/**
+ * Marks a newly inserted procedure as a pairing so its duration is counted,
+ * and gives SC a chance to replace its key pair before this pairing uses it.
+ */
+static void
+ble_sm_pair_start(struct ble_sm_proc *proc)
+{
+    proc->flags |= BLE_SM_PROC_F_PAIRING;
+    proc->pair_start = ble_npl_time_get();
+    ble_sm_sc_pair_start();
+}
+
 static int32_t
 ble_sm_extract_expired(struct ble_sm_proc_list *dst_list)
 {
@@ -1034,6 +1048,11 @@ ble_sm_process_result(uint16_t conn_handle, struct ble_sm_result *res,
 
         if (res->enc_cb) {
             BLE_HS_DBG_ASSERT(proc == NULL || rm);
+            if (res->app_status == 0 &&
+                proc->flags & BLE_SM_PROC_F_PAIRING) {
+
+                ble_sm_pre_pair_done(proc->pair_start);
+            }
             ble_gap_enc_event(conn_handle, res->app_status, res->restore, res->bonded);
         }
 
@@ -1914,6 +1933,7 @@ ble_sm_pair_req_rx(uint16_t conn_handle, struct os_mbuf **om,
         proc->conn_handle = conn_handle;
         proc->state = BLE_SM_PROC_STATE_PAIR;
         ble_sm_insert(proc);
+        ble_sm_pair_start(proc);
 
         proc->pair_req[0] = BLE_SM_OP_PAIR_REQ;
         memcpy(proc->pair_req + 1, req, sizeof(*req));
@@ -2819,6 +2839,7 @@ ble_sm_pair_initiate(uint16_t conn_handle)
 
         ble_hs_lock();
         ble_sm_insert(proc);
+        ble_sm_pair_start(proc);
         ble_hs_unlock();
 
         res.execute = 1;
@@ -3102,6 +3123,7 @@ ble_sm_init(void)
     }
 
     ble_sm_sc_init();
+    ble_sm_alg_key_cache_clear();
 
     return 0;
 }
@@ -59,6 +59,12 @@
 #if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
 #if MYNEWT_VAL(BLE_SM_SC)
 static mbedtls_ecp_keypair keypair;
+static mbedtls_entropy_context ble_sm_alg_entropy_ctx;
+static mbedtls_ctr_drbg_context ble_sm_alg_drbg_ctx;
+static bool ble_sm_alg_drbg_seeded;
+/* Serialises the generator between the host and precompute tasks. */
+static struct ble_npl_mutex ble_sm_alg_drbg_mutex;
+static bool ble_sm_alg_drbg_mutex_inited;
 #endif
 #else
 #if MYNEWT_VAL(BLE_SM_SC) && MYNEWT_VAL(TRNG)
@@ -90,41 +96,71 @@ ble_sm_alg_xor_128(const uint8_t *p, const uint8_t *q, uint8_t *r)
     }
 }
 
+/**
+ * Expands an AES-128 encryption key schedule.
+ *
+ * @param aes                   The key context to initialise.
+ * @param key                   128-bit key, in the little-endian order used
+ *                                  by ble_sm_alg_encrypt().
+ *
+ * @return                      0 on success; BLE_HS_EUNKNOWN on failure.
+ */
 int
-ble_sm_alg_encrypt(const uint8_t *key, const uint8_t *plaintext,
-                   uint8_t *enc_data)
+ble_sm_alg_aes_key_set(struct ble_sm_alg_aes_key *aes, const uint8_t *key)
 {
     uint8_t tmp[16];
+    int rc;
 
     swap_buf(tmp, key, 16);
 
 #if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
-    mbedtls_aes_context s = {0};
-
-    mbedtls_aes_init(&s);
-    if (mbedtls_aes_setkey_enc(&s, tmp, 128) != 0) {
-        mbedtls_aes_free(&s);
-        return BLE_HS_EUNKNOWN;
+    mbedtls_aes_init(&aes->ctx);
+    rc = mbedtls_aes_setkey_enc(&aes->ctx, tmp, 128) == 0 ? 0 : BLE_HS_EUNKNOWN;
+    if (rc != 0) {
+        mbedtls_aes_free(&aes->ctx);
     }
+#else
+    rc = tc_aes128_set_encrypt_key(&aes->sched, tmp) == TC_CRYPTO_FAIL ?
+         BLE_HS_EUNKNOWN : 0;
+#endif
 
-    swap_buf(tmp, plaintext, 16);
+    memset(tmp, 0, sizeof tmp);
 
-    if (mbedtls_aes_crypt_ecb(&s, MBEDTLS_AES_ENCRYPT, tmp, enc_data) != 0) {
-        mbedtls_aes_free(&s);
-        return BLE_HS_EUNKNOWN;
-    }
+    return rc;
+}
 
-    mbedtls_aes_free(&s);
+/**
+ * Wipes an expanded key schedule.
+ */
+void
+ble_sm_alg_aes_key_clear(struct ble_sm_alg_aes_key *aes)
+{
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    mbedtls_aes_free(&aes->ctx);
 #else
-    struct tc_aes_key_sched_struct s;
+    memset(&aes->sched, 0, sizeof aes->sched);
+#endif
+}
 
-    if (tc_aes128_set_encrypt_key(&s, tmp) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
+/**
+ * Encrypts one block under an expanded key. Byte order matches
+ * ble_sm_alg_encrypt().
+ */
+int
+ble_sm_alg_encrypt_key(struct ble_sm_alg_aes_key *aes,
+                       const uint8_t *plaintext, uint8_t *enc_data)
+{
+    uint8_t tmp[16];
 
     swap_buf(tmp, plaintext, 16);
 
-    if (tc_aes_encrypt(enc_data, tmp, &s) == TC_CRYPTO_FAIL) {
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    if (mbedtls_aes_crypt_ecb(&aes->ctx, MBEDTLS_AES_ENCRYPT, tmp,
+                              enc_data) != 0) {
+        return BLE_HS_EUNKNOWN;
+    }
+#else
+    if (tc_aes_encrypt(enc_data, tmp, &aes->sched) == TC_CRYPTO_FAIL) {
         return BLE_HS_EUNKNOWN;
     }
 #endif
@@ -134,6 +170,191 @@ ble_sm_alg_encrypt(const uint8_t *key, const uint8_t *plaintext,
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE) > 0
+/*
+ * Expanded schedules for the most recently used keys. The same few keys
+ * (bonded IRKs, the local IRK, an LTK or TK during pairing) are used over
+ * and over, so keeping their schedules saves a key expansion per block.
+ *
+ * Entries are claimed with a reference count under a short critical
+ * section and used outside it, so an entry is never evicted while another
+ * task is encrypting with it.
+ */
+struct ble_sm_alg_key_cache_entry {
+    struct ble_sm_alg_aes_key aes;
+    uint8_t key[16];
+    uint32_t last_used;
+    uint8_t refs;
+    uint8_t valid;
+};
+
+static struct ble_sm_alg_key_cache_entry
+    ble_sm_alg_key_cache[MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE)];
+static uint32_t ble_sm_alg_key_cache_clock;
+
+static struct ble_sm_alg_key_cache_entry *
+ble_sm_alg_key_cache_get(const uint8_t *key)
+{
+    struct ble_sm_alg_key_cache_entry *victim;
+    struct ble_sm_alg_key_cache_entry *entry;
+    uint32_t ctx;
+    int i;
+
+    victim = NULL;
+
+    ctx = ble_npl_hw_enter_critical();
+    for (i = 0; i < MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE); i++) {
+        entry = &ble_sm_alg_key_cache[i];
+        if (entry->valid && memcmp(entry->key, key, 16) == 0) {
+            entry->refs++;
+            entry->last_used = ++ble_sm_alg_key_cache_clock;
+            ble_npl_hw_exit_critical(ctx);
+            return entry;
+        }
+
+        if (entry->refs == 0 &&
+            (victim == NULL || !entry->valid ||
+             (victim->valid &&
+              (int32_t)(entry->last_used - victim->last_used) < 0))) {
+            victim = entry;
+        }
+    }
+
+    if (victim != NULL) {
+        /* Claim the slot; it is not visible to lookups until it holds the
+         * new schedule.
+         */
+        victim->refs = 1;
+        victim->valid = 0;
+    }
+    ble_npl_hw_exit_critical(ctx);
+
+    if (victim == NULL) {
+        /* Every entry is in use by another task. */
+        return NULL;
+    }
+
+    ble_sm_alg_aes_key_clear(&victim->aes);
+    if (ble_sm_alg_aes_key_set(&victim->aes, key) != 0) {
+        ctx = ble_npl_hw_enter_critical();
+        victim->refs = 0;
+        ble_npl_hw_exit_critical(ctx);
+        return NULL;
+    }
+
+    ctx = ble_npl_hw_enter_critical();
+    memcpy(victim->key, key, 16);
+    victim->last_used = ++ble_sm_alg_key_cache_clock;
+    victim->valid = 1;
+    ble_npl_hw_exit_critical(ctx);
+
+    return victim;
+}
+
+static void
+ble_sm_alg_key_cache_put(struct ble_sm_alg_key_cache_entry *entry)
+{
+    uint32_t ctx;
+
+    ctx = ble_npl_hw_enter_critical();
+    entry->refs--;
+    ble_npl_hw_exit_critical(ctx);
+}
+#endif
+
+/**
+ * Drops all cached key schedules, wiping the key material.
+ */
+void
+ble_sm_alg_key_cache_clear(void)
+{
+#if MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE) > 0
+    struct ble_sm_alg_key_cache_entry *entry;
+    uint32_t ctx;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE); i++) {
+        entry = &ble_sm_alg_key_cache[i];
+
+        ctx = ble_npl_hw_enter_critical();
+        if (entry->refs != 0) {
+            /* In use; it will be reclaimed by a later lookup. */
+            ble_npl_hw_exit_critical(ctx);
+            continue;
+        }
+        entry->valid = 0;
+        ble_npl_hw_exit_critical(ctx);
+
+        ble_sm_alg_aes_key_clear(&entry->aes);
+        memset(entry->key, 0, sizeof entry->key);
+    }
+#endif
+}
+
+/**
+ * Encrypts a run of 16-byte blocks in ECB mode under one key, expanding
+ * the key schedule at most once. Byte order matches ble_sm_alg_encrypt()
+ * for every block.
+ *
+ * @param key                   128-bit key.
+ * @param plaintext             num_blocks * 16 bytes of input.
+ * @param enc_data              num_blocks * 16 bytes of output; may alias
+ *                                  plaintext.
+ * @param num_blocks            Number of blocks to encrypt.
+ *
+ * @return                      0 on success; BLE_HS_EUNKNOWN on failure.
+ */
+int
+ble_sm_alg_encrypt_ecb(const uint8_t *key, const uint8_t *plaintext,
+                       uint8_t *enc_data, size_t num_blocks)
+{
+#if MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE) > 0
+    struct ble_sm_alg_key_cache_entry *entry;
+#endif
+    struct ble_sm_alg_aes_key tmp_aes;
+    struct ble_sm_alg_aes_key *aes;
+    size_t i;
+    int rc;
+
+#if MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE) > 0
+    entry = ble_sm_alg_key_cache_get(key);
+    if (entry != NULL) {
+        aes = &entry->aes;
+    } else
+#endif
+    {
+        rc = ble_sm_alg_aes_key_set(&tmp_aes, key);
+        if (rc != 0) {
+            return rc;
+        }
+        aes = &tmp_aes;
+    }
+
+    rc = 0;
+    for (i = 0; i < num_blocks && rc == 0; i++) {
+        rc = ble_sm_alg_encrypt_key(aes, plaintext + i * 16,
+                                    enc_data + i * 16);
+    }
+
+#if MYNEWT_VAL(BLE_SM_ALG_KEY_CACHE_SIZE) > 0
+    if (entry != NULL) {
+        ble_sm_alg_key_cache_put(entry);
+    } else
+#endif
+    {
+        ble_sm_alg_aes_key_clear(&tmp_aes);
+    }
+
+    return rc;
+}
+
+int
+ble_sm_alg_encrypt(const uint8_t *key, const uint8_t *plaintext,
+                   uint8_t *enc_data)
+{
+    return ble_sm_alg_encrypt_ecb(key, plaintext, enc_data, 1);
+}
+
 int
 ble_sm_alg_s1(const uint8_t *k, const uint8_t *r1, const uint8_t *r2,
               uint8_t *out)
@@ -515,6 +736,53 @@ ble_sm_alg_g2(const uint8_t *u, const uint8_t *v, const uint8_t *x,
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+/**
+ * Seeding gathers fresh entropy, which is slow, so the generator is seeded
+ * once and shared by every key pair and DH key computation. Key pairs are
+ * also generated on the precompute task, so seeding and every draw from the
+ * generator hold ble_sm_alg_drbg_mutex; use ble_sm_alg_drbg_random() as the
+ * RNG callback rather than mbedtls_ctr_drbg_random().
+ */
+static mbedtls_ctr_drbg_context *
+ble_sm_alg_ctr_drbg(void)
+{
+    mbedtls_ctr_drbg_context *ctr_drbg = &ble_sm_alg_drbg_ctx;
+
+    ble_npl_mutex_pend(&ble_sm_alg_drbg_mutex, BLE_NPL_TIME_FOREVER);
+
+    if (!ble_sm_alg_drbg_seeded) {
+        mbedtls_entropy_init(&ble_sm_alg_entropy_ctx);
+        mbedtls_ctr_drbg_init(&ble_sm_alg_drbg_ctx);
+
+        if (mbedtls_ctr_drbg_seed(&ble_sm_alg_drbg_ctx, mbedtls_entropy_func,
+                                  &ble_sm_alg_entropy_ctx, NULL, 0) != 0) {
+            mbedtls_ctr_drbg_free(&ble_sm_alg_drbg_ctx);
+            mbedtls_entropy_free(&ble_sm_alg_entropy_ctx);
+            ctr_drbg = NULL;
+        } else {
+            ble_sm_alg_drbg_seeded = true;
+        }
+    }
+
+    ble_npl_mutex_release(&ble_sm_alg_drbg_mutex);
+
+    return ctr_drbg;
+}
+
+static int
+ble_sm_alg_drbg_random(void *ctx, unsigned char *out, size_t len)
+{
+    int rc;
+
+    ble_npl_mutex_pend(&ble_sm_alg_drbg_mutex, BLE_NPL_TIME_FOREVER);
+    rc = mbedtls_ctr_drbg_random(ctx, out, len);
+    ble_npl_mutex_release(&ble_sm_alg_drbg_mutex);
+
+    return rc;
+}
+#endif
+
 #if !CONFIG_BT_LE_CONTROLLER_NPL_OS_PORTING_SUPPORT
 int
 ble_sm_alg_gen_dhkey(const uint8_t *peer_pub_key_x, const uint8_t *peer_pub_key_y,
@@ -532,8 +800,7 @@ ble_sm_alg_gen_dhkey(const uint8_t *peer_pub_key_x, const uint8_t *peer_pub_key_
 #if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
     struct mbedtls_ecp_point pt = {0}, Q = {0};
     mbedtls_mpi z = {0}, d = {0};
-    mbedtls_ctr_drbg_context ctr_drbg = {0};
-    mbedtls_entropy_context entropy = {0};
+    mbedtls_ctr_drbg_context *ctr_drbg;
 
     uint8_t pub[65] = {0};
     /* Hardcoded first byte of pub key for MBEDTLS_ECP_PF_UNCOMPRESSED */
@@ -543,13 +810,13 @@ ble_sm_alg_gen_dhkey(const uint8_t *peer_pub_key_x, const uint8_t *peer_pub_key_
     /* Initialize the required structures here */
     mbedtls_ecp_point_init(&pt);
     mbedtls_ecp_point_init(&Q);
-    mbedtls_ctr_drbg_init(&ctr_drbg);
-    mbedtls_entropy_init(&entropy);
     mbedtls_mpi_init(&d);
     mbedtls_mpi_init(&z);
 
-    /* Below 3 steps are to validate public key on curve secp256r1 */
-    if (mbedtls_ecp_group_load(&keypair.MBEDTLS_PRIVATE(grp), MBEDTLS_ECP_DP_SECP256R1) != 0) {
+    /* Below 3 steps are to validate public key on curve secp256r1. The group
+     * is already loaded when our key pair was generated here. */
+    if (keypair.MBEDTLS_PRIVATE(grp).id != MBEDTLS_ECP_DP_SECP256R1 &&
+        mbedtls_ecp_group_load(&keypair.MBEDTLS_PRIVATE(grp), MBEDTLS_ECP_DP_SECP256R1) != 0) {
         goto exit;
     }
 
@@ -562,8 +829,9 @@ ble_sm_alg_gen_dhkey(const uint8_t *peer_pub_key_x, const uint8_t *peer_pub_key_
     }
 
     /* Set PRNG */
-    if ( ( rc = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
-                                      NULL, 0) ) != 0) {
+    ctr_drbg = ble_sm_alg_ctr_drbg();
+    if (ctr_drbg == NULL) {
+        rc = BLE_HS_EUNKNOWN;
         goto exit;
     }
 
@@ -577,7 +845,7 @@ ble_sm_alg_gen_dhkey(const uint8_t *peer_pub_key_x, const uint8_t *peer_pub_key_
     }
 
     rc = mbedtls_ecdh_compute_shared(&keypair.MBEDTLS_PRIVATE(grp), &z, &Q, &d,
-                                     mbedtls_ctr_drbg_random, &ctr_drbg);
+                                     ble_sm_alg_drbg_random, ctr_drbg);
     if (rc != 0) {
         goto exit;
     }
@@ -592,8 +860,6 @@ exit:
     mbedtls_mpi_free(&z);
     mbedtls_mpi_free(&d);
     mbedtls_ecp_point_free(&Q);
-    mbedtls_entropy_free(&entropy);
-    mbedtls_ctr_drbg_free(&ctr_drbg);
     if (rc != 0) {
         return BLE_HS_EUNKNOWN;
     }
@@ -635,40 +901,37 @@ static const uint8_t ble_sm_alg_dbg_pub_key[64] = {
 #endif
 
 #if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+/**
+ * Generates into a key pair of its own rather than the shared one, as the
+ * precompute task may run this while a DH key is computed on the host task.
+ */
 static int
 mbedtls_gen_keypair(uint8_t *public_key, uint8_t *private_key)
 {
     int rc = BLE_HS_EUNKNOWN;
-    mbedtls_entropy_context entropy = {0};
-    mbedtls_ctr_drbg_context ctr_drbg = {0};
-
-
-    mbedtls_entropy_init(&entropy);
-    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_ctr_drbg_context *ctr_drbg;
+    mbedtls_ecp_keypair kp;
 
-    /* Free the previously allocate keypair */
-    mbedtls_ecp_keypair_free(&keypair);
-
-    mbedtls_ecp_keypair_init(&keypair);
+    mbedtls_ecp_keypair_init(&kp);
 
-    if (( rc = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
-                                NULL, 0)) != 0) {
+    ctr_drbg = ble_sm_alg_ctr_drbg();
+    if (ctr_drbg == NULL) {
         goto exit;
     }
 
-    if ((rc = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, &keypair,
-                                  mbedtls_ctr_drbg_random, &ctr_drbg)) != 0) {
+    if ((rc = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, &kp,
+                                  ble_sm_alg_drbg_random, ctr_drbg)) != 0) {
         goto exit;
     }
 
-    if (( rc = mbedtls_mpi_write_binary(&keypair.MBEDTLS_PRIVATE(d), private_key, 32)) != 0) {
+    if (( rc = mbedtls_mpi_write_binary(&kp.MBEDTLS_PRIVATE(d), private_key, 32)) != 0) {
         goto exit;
     }
 
     size_t olen = 0;
     uint8_t pub[65] = {0};
 
-    if ((rc = mbedtls_ecp_point_write_binary(&keypair.MBEDTLS_PRIVATE(grp), &keypair.MBEDTLS_PRIVATE(Q), MBEDTLS_ECP_PF_UNCOMPRESSED,
+    if ((rc = mbedtls_ecp_point_write_binary(&kp.MBEDTLS_PRIVATE(grp), &kp.MBEDTLS_PRIVATE(Q), MBEDTLS_ECP_PF_UNCOMPRESSED,
                                              &olen, pub, 65)) != 0) {
         goto exit;
     }
@@ -676,10 +939,8 @@ mbedtls_gen_keypair(uint8_t *public_key, uint8_t *private_key)
     memcpy(public_key, &pub[1], 64);
 
 exit:
-    mbedtls_ctr_drbg_free( &ctr_drbg );
-    mbedtls_entropy_free( &entropy );
+    mbedtls_ecp_keypair_free(&kp);
     if (rc != 0) {
-        mbedtls_ecp_keypair_free(&keypair);
         return BLE_HS_EUNKNOWN;
     }
 
@@ -753,7 +1014,7 @@ ble_sm_alg_rand(uint8_t *dst, unsigned int size)
         size -= num;
     }
 #else
-    if (ble_hs_hci_util_rand(dst, size)) {
+    if (ble_sm_pre_rand(dst, size)) {
         return 0;
     }
 #endif
@@ -767,6 +1028,12 @@ ble_sm_alg_ecc_init(void)
 {
 #if (!MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS))
     uECC_set_rng(ble_sm_alg_rand);
+#else
+    /* Runs again when the host is reinitialised, the generator outlives it. */
+    if (!ble_sm_alg_drbg_mutex_inited) {
+        ble_npl_mutex_init(&ble_sm_alg_drbg_mutex);
+        ble_sm_alg_drbg_mutex_inited = true;
+    }
 #endif
     return;
 }
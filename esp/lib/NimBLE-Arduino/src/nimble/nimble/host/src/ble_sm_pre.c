@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Pairing material: our P-256 key pairs and the random values pairing
+ * consumes.
+ *
+ * With BLE_SM_PRECOMPUTE, ble_sm_pre_fill() keeps the next key pair and a
+ * pool of random bytes ready.  It is meant to run on a low priority task,
+ * which the port wakes through the kick callback whenever pairing has taken
+ * something.  Pairing takes from the pool and only generates on the host task
+ * when the pool is empty.
+ *
+ * The pairing counters are kept either way, so the time pairing spends
+ * waiting on key generation can be compared with and without the pool.
+ */
+
+#include <string.h>
+#include "nimble/porting/nimble/include/syscfg/syscfg.h"
+#include "nimble/nimble/include/nimble/nimble_opt.h"
+#include "nimble/nimble/host/include/host/ble_sm.h"
+#include "ble_hs_priv.h"
+
+#if NIMBLE_BLE_CONNECT
+#if NIMBLE_BLE_SM
+
+static struct ble_sm_pair_stats ble_sm_pair_stats_data;
+
+#if MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+
+/** Enough for a DH key check, a pairing random and a full key distribution. */
+#define BLE_SM_PRE_RAND_LEN     128
+
+static uint8_t ble_sm_pre_rand_pool[BLE_SM_PRE_RAND_LEN];
+static uint8_t ble_sm_pre_rand_len;
+
+#if MYNEWT_VAL(BLE_SM_SC)
+static uint8_t ble_sm_pre_pub_key[64];
+static uint8_t ble_sm_pre_priv_key[32];
+static uint8_t ble_sm_pre_key_ready;
+#endif
+
+/** The task that last ran ble_sm_pre_fill(). */
+static void *ble_sm_pre_task;
+static ble_sm_pre_kick_fn *ble_sm_pre_kick_cb;
+
+void
+ble_sm_pre_set_kick_cb(ble_sm_pre_kick_fn *cb)
+{
+    ble_sm_pre_kick_cb = cb;
+}
+
+void
+ble_sm_pre_kick(void)
+{
+    ble_sm_pre_kick_fn *cb;
+
+    cb = ble_sm_pre_kick_cb;
+    if (cb != NULL) {
+        cb();
+    }
+}
+
+int
+ble_sm_pre_fill(void)
+{
+    uint8_t buf[BLE_SM_PRE_RAND_LEN];
+    uint32_t ctx;
+    int need;
+    int rc;
+#if MYNEWT_VAL(BLE_SM_SC)
+    uint8_t pub[64];
+    uint8_t priv[32];
+#endif
+
+    if (!ble_hs_synced()) {
+        return BLE_HS_ENOTSYNCED;
+    }
+
+    ble_sm_pre_task = ble_npl_get_current_task_id();
+
+#if MYNEWT_VAL(BLE_SM_SC)
+    if (!ble_sm_pre_key_ready) {
+        rc = ble_sm_alg_gen_key_pair(pub, priv);
+        if (rc != 0) {
+            return rc;
+        }
+
+        ctx = ble_npl_hw_enter_critical();
+        if (!ble_sm_pre_key_ready) {
+            memcpy(ble_sm_pre_pub_key, pub, sizeof pub);
+            memcpy(ble_sm_pre_priv_key, priv, sizeof priv);
+            ble_sm_pre_key_ready = 1;
+        }
+        ble_npl_hw_exit_critical(ctx);
+
+        memset(priv, 0, sizeof priv);
+    }
+#endif
+
+    need = BLE_SM_PRE_RAND_LEN - ble_sm_pre_rand_len;
+    if (need > 0) {
+        rc = ble_hs_hci_util_rand(buf, need);
+        if (rc != 0) {
+            return rc;
+        }
+
+        /* Pairing may have taken more while the controller was asked. */
+        ctx = ble_npl_hw_enter_critical();
+        memcpy(ble_sm_pre_rand_pool + ble_sm_pre_rand_len, buf, need);
+        ble_sm_pre_rand_len += need;
+        ble_npl_hw_exit_critical(ctx);
+
+        memset(buf, 0, sizeof buf);
+    }
+
+    return 0;
+}
+#endif
+
+int
+ble_sm_pre_rand(void *dst, int len)
+{
+#if MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+    uint8_t *u8p;
+    uint32_t ctx;
+    int n;
+
+    /* The fill task reads the controller directly, so generating the next
+     * key pair does not drain the pool it is about to top up.
+     */
+    if (ble_npl_get_current_task_id() == ble_sm_pre_task) {
+        return ble_hs_hci_util_rand(dst, len);
+    }
+
+    u8p = dst;
+
+    ctx = ble_npl_hw_enter_critical();
+    n = len < ble_sm_pre_rand_len ? len : ble_sm_pre_rand_len;
+    ble_sm_pre_rand_len -= n;
+    memcpy(u8p, ble_sm_pre_rand_pool + ble_sm_pre_rand_len, n);
+    memset(ble_sm_pre_rand_pool + ble_sm_pre_rand_len, 0, n);
+    ble_npl_hw_exit_critical(ctx);
+
+    ble_sm_pair_stats_data.rand_pool_bytes += n;
+    if (ble_sm_pre_rand_len < BLE_SM_PRE_RAND_LEN / 2) {
+        ble_sm_pre_kick();
+    }
+
+    u8p += n;
+    len -= n;
+    if (len == 0) {
+        return 0;
+    }
+
+    ble_sm_pair_stats_data.rand_hci_bytes += len;
+    return ble_hs_hci_util_rand(u8p, len);
+#else
+    ble_sm_pair_stats_data.rand_hci_bytes += len;
+    return ble_hs_hci_util_rand(dst, len);
+#endif
+}
+
+#if MYNEWT_VAL(BLE_SM_SC)
+int
+ble_sm_pre_key_pair(uint8_t *pub, uint8_t *priv)
+{
+    ble_npl_time_t start;
+    int rc;
+#if MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+    uint32_t ctx;
+    int taken;
+
+    ctx = ble_npl_hw_enter_critical();
+    taken = ble_sm_pre_key_ready;
+    if (taken) {
+        memcpy(pub, ble_sm_pre_pub_key, sizeof ble_sm_pre_pub_key);
+        memcpy(priv, ble_sm_pre_priv_key, sizeof ble_sm_pre_priv_key);
+        memset(ble_sm_pre_priv_key, 0, sizeof ble_sm_pre_priv_key);
+        ble_sm_pre_key_ready = 0;
+    }
+    ble_npl_hw_exit_critical(ctx);
+
+    /* Have the next pair ready for when this one is rotated out. */
+    ble_sm_pre_kick();
+
+    if (taken) {
+        ble_sm_pair_stats_data.keys_precomputed++;
+        return 0;
+    }
+#endif
+
+    start = ble_npl_time_get();
+    rc = ble_sm_alg_gen_key_pair(pub, priv);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_sm_pair_stats_data.keys_inline++;
+    ble_sm_pair_stats_data.keys_inline_ms +=
+        ble_npl_time_ticks_to_ms32(ble_npl_time_get() - start);
+
+    return 0;
+}
+#endif
+
+void
+ble_sm_pre_pair_done(ble_npl_time_t start)
+{
+    uint32_t ms;
+
+    ms = ble_npl_time_ticks_to_ms32(ble_npl_time_get() - start);
+
+    ble_sm_pair_stats_data.pairings++;
+    ble_sm_pair_stats_data.last_ms = ms;
+    ble_sm_pair_stats_data.total_ms += ms;
+    if (ms > ble_sm_pair_stats_data.max_ms) {
+        ble_sm_pair_stats_data.max_ms = ms;
+    }
+}
+
+void
+ble_sm_pair_stats(struct ble_sm_pair_stats *out_stats)
+{
+    *out_stats = ble_sm_pair_stats_data;
+}
+
+void
+ble_sm_pair_stats_reset(void)
+{
+    memset(&ble_sm_pair_stats_data, 0, sizeof ble_sm_pair_stats_data);
+}
+
+#endif
+#endif
@@ -27,6 +27,13 @@
 #if MYNEWT_VAL(ENC_ADV_DATA)
 #include "nimble/nimble/host/include/host/ble_ead.h"
 #endif
+#if NIMBLE_BLE_SM
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+#include "mbedtls/aes.h"
+#else
+#include "nimble/ext/tinycrypt/include/tinycrypt/aes.h"
+#endif
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -219,6 +226,7 @@ struct ble_sm_dhkey_check {
 #define BLE_SM_PROC_F_AUTHENTICATED         0x08
 #define BLE_SM_PROC_F_SC                    0x10
 #define BLE_SM_PROC_F_BONDING               0x20
+#define BLE_SM_PROC_F_PAIRING               0x40
 
 #define BLE_SM_KE_F_ENC_INFO                0x01
 #define BLE_SM_KE_F_MASTER_ID               0x02
@@ -249,6 +257,7 @@ struct ble_sm_proc {
     STAILQ_ENTRY(ble_sm_proc) next;
 
     ble_npl_time_t exp_os_ticks;
+    ble_npl_time_t pair_start;
     ble_sm_proc_flags flags;
     uint16_t conn_handle;
     uint8_t pair_alg;
@@ -364,6 +373,7 @@ bool ble_sm_sc_oob_data_check(struct ble_sm_proc *proc,
                               bool oob_data_local_present,
                               bool oob_data_remote_present);
 void ble_sm_sc_oob_confirm(struct ble_sm_proc *proc, struct ble_sm_result *res);
+void ble_sm_sc_pair_start(void);
 void ble_sm_sc_init(void);
 #else
 #define ble_sm_sc_io_action(proc, action) (BLE_HS_ENOTSUP)
@@ -374,10 +384,22 @@ void ble_sm_sc_init(void);
 #define ble_sm_sc_public_key_rx(conn_handle, op, om, res)
 #define ble_sm_sc_dhkey_check_exec(proc, res, arg)
 #define ble_sm_sc_dhkey_check_rx(conn_handle, op, om, res)
+#define ble_sm_sc_pair_start()
 #define ble_sm_sc_init()
 
 #endif
 
+int ble_sm_pre_rand(void *dst, int len);
+#if MYNEWT_VAL(BLE_SM_SC)
+int ble_sm_pre_key_pair(uint8_t *pub, uint8_t *priv);
+#endif
+void ble_sm_pre_pair_done(ble_npl_time_t start);
+#if MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+void ble_sm_pre_kick(void);
+#else
+#define ble_sm_pre_kick()
+#endif
+
 struct ble_sm_proc *ble_sm_proc_find(uint16_t conn_handle, uint8_t state,
                                      int is_initiator,
                                      struct ble_sm_proc **out_prev);
@@ -406,6 +428,24 @@ int ble_sm_enc_initiate(uint16_t conn_handle, uint8_t key_size,
                         uint64_t rand_val, int auth);
 int ble_sm_alg_encrypt(const uint8_t *key, const uint8_t *plaintext,
                        uint8_t *enc_data);
+int ble_sm_alg_encrypt_ecb(const uint8_t *key, const uint8_t *plaintext,
+                           uint8_t *enc_data, size_t num_blocks);
+
+/** An AES-128 key with its expanded encryption schedule. */
+struct ble_sm_alg_aes_key {
+#if MYNEWT_VAL(BLE_CRYPTO_STACK_MBEDTLS)
+    mbedtls_aes_context ctx;
+#else
+    struct tc_aes_key_sched_struct sched;
+#endif
+};
+
+int ble_sm_alg_aes_key_set(struct ble_sm_alg_aes_key *aes,
+                           const uint8_t *key);
+void ble_sm_alg_aes_key_clear(struct ble_sm_alg_aes_key *aes);
+int ble_sm_alg_encrypt_key(struct ble_sm_alg_aes_key *aes,
+                           const uint8_t *plaintext, uint8_t *enc_data);
+void ble_sm_alg_key_cache_clear(void);
 int ble_sm_init(void);
 #else
 
@@ -427,6 +467,10 @@ int ble_sm_init(void);
 
 #define ble_sm_alg_encrypt(key, plaintext, enc_data) \
         BLE_HS_ENOTSUP
+#define ble_sm_alg_encrypt_ecb(key, plaintext, enc_data, num_blocks) \
+        BLE_HS_ENOTSUP
+#define ble_sm_alg_key_cache_clear()
+#define ble_sm_pre_kick()
 
 #endif
 
@@ -39,6 +39,20 @@ static uint8_t ble_sm_sc_priv_key[32];
  */
 static uint8_t ble_sm_sc_keys_generated;
 
+/** Key reuse limits set by ble_sm_sc_set_key_reuse(), 0 for no limit. */
+static uint16_t ble_sm_sc_key_max_uses;
+static uint32_t ble_sm_sc_key_max_age_ms;
+
+/** Pairings our key pair has been sent in, and when it was generated. */
+static uint16_t ble_sm_sc_key_uses;
+static ble_npl_time_t ble_sm_sc_key_born;
+
+/**
+ * Whether our public key was handed out in OOB data, in which case it is
+ * kept for the pairing that follows.
+ */
+static uint8_t ble_sm_sc_key_oob;
+
 /**
  * Create some shortened names for the passkey actions so that the table is
  * easier to read.
@@ -164,7 +178,7 @@ ble_sm_gen_pub_priv(uint8_t *pub, uint8_t *priv)
     }
 #endif
 
-    rc = ble_sm_alg_gen_key_pair(pub, priv);
+    rc = ble_sm_pre_key_pair(pub, priv);
     if (rc != 0) {
         return rc;
     }
@@ -184,6 +198,8 @@ ble_sm_sc_ensure_keys_generated(void)
         }
 
         ble_sm_sc_keys_generated = 1;
+        ble_sm_sc_key_uses = 0;
+        ble_sm_sc_key_born = ble_npl_time_get();
     }
 
     BLE_HS_LOG(DEBUG, "our pubkey=");
@@ -196,6 +212,54 @@ ble_sm_sc_ensure_keys_generated(void)
     return 0;
 }
 
+void
+ble_sm_sc_set_key_reuse(uint16_t max_pairings, uint32_t max_age_ms)
+{
+    ble_hs_lock();
+    ble_sm_sc_key_max_uses = max_pairings;
+    ble_sm_sc_key_max_age_ms = max_age_ms;
+    ble_hs_unlock();
+}
+
+/**
+ * Called with the host lock held when a pairing procedure has been added.
+ * Drops our key pair if it has reached its reuse limits, so that the new
+ * pairing generates or takes the next one.  The pair is never replaced
+ * while another procedure may still be using it.
+ */
+void
+ble_sm_sc_pair_start(void)
+{
+    uint32_t age_ms;
+    int expired;
+
+    if (!ble_sm_sc_keys_generated) {
+        return;
+    }
+
+    if (ble_sm_sc_key_oob) {
+        ble_sm_sc_key_oob = 0;
+        return;
+    }
+
+    if (ble_sm_num_procs() != 1) {
+        return;
+    }
+
+    expired = ble_sm_sc_key_max_uses != 0 &&
+              ble_sm_sc_key_uses >= ble_sm_sc_key_max_uses;
+
+    if (!expired && ble_sm_sc_key_max_age_ms != 0) {
+        age_ms = ble_npl_time_ticks_to_ms32(ble_npl_time_get() -
+                                            ble_sm_sc_key_born);
+        expired = age_ms >= ble_sm_sc_key_max_age_ms;
+    }
+
+    if (expired) {
+        ble_sm_sc_keys_generated = 0;
+    }
+}
+
 /* Initiator does not send a confirm when pairing algorithm is any of:
  *     o just works
  *     o numeric comparison
@@ -547,6 +611,8 @@ ble_sm_sc_public_key_exec(struct ble_sm_proc *proc, struct ble_sm_result *res,
         return;
     }
 
+    ble_sm_sc_key_uses++;
+
     cmd = ble_sm_cmd_get(BLE_SM_OP_PAIR_PUBLIC_KEY, sizeof(*cmd), &txom);
     if (!cmd) {
         res->app_status = BLE_HS_ENOMEM;
@@ -903,7 +969,9 @@ ble_sm_sc_oob_generate_data(struct ble_sm_sc_oob_data *oob_data)
         return rc;
     }
 
-    rc = ble_hs_hci_util_rand(oob_data->r, 16);
+    ble_sm_sc_key_oob = 1;
+
+    rc = ble_sm_pre_rand(oob_data->r, 16);
     if (rc) {
         return rc;
     }
@@ -922,6 +990,8 @@ ble_sm_sc_init(void)
 {
     ble_sm_alg_ecc_init();
     ble_sm_sc_keys_generated = 0;
+    ble_sm_sc_key_uses = 0;
+    ble_sm_sc_key_oob = 0;
 }
 
 #endif  /* MYNEWT_VAL(BLE_SM_SC) */
@@ -20,6 +20,8 @@
 #ifndef H_BLE_STORE_CONFIG_
 #define H_BLE_STORE_CONFIG_
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,6 +34,37 @@ int ble_store_config_read(int obj_type, const union ble_store_key *key,
 int ble_store_config_write(int obj_type, const union ble_store_value *val);
 int ble_store_config_delete(int obj_type, const union ble_store_key *key);
 
+/**
+ * Counters of the NVS write-back cache.
+ */
+struct ble_store_config_nvs_stats {
+    /** Store updates deferred instead of written to NVS immediately */
+    uint32_t deferred;
+    /** NVS record writes and erases issued by flushes */
+    uint32_t nvs_ops;
+    /** Flash operations avoided by coalescing (deferred - nvs_ops) */
+    uint32_t saved;
+    /** Number of completed flushes */
+    uint32_t flushes;
+};
+
+/**
+ * Writes all deferred store updates to NVS.  Must be called from the host
+ * task, or after the host has been stopped.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ESTORE_FAIL if NVS could not be
+ *                                  updated; the updates stay pending.
+ */
+int ble_store_config_flush(void);
+
+/**
+ * Reads the counters of the NVS write-back cache.
+ *
+ * @param stats                 Filled with the current counters.
+ */
+void ble_store_config_nvs_stats(struct ble_store_config_nvs_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,8 @@
 #include "esp_log.h"
 #include "nvs.h"
 #include "nimble/nimble/host/src/ble_hs_resolv_priv.h"
+#include "nimble/nimble/host/src/ble_hs_priv.h"
+#include "nimble/porting/nimble/include/nimble/nimble_port.h"
 
 
 #define NIMBLE_NVS_STR_NAME_MAX_LEN              16
@@ -54,6 +56,29 @@ typedef uint32_t nvs_handle_t;
 
 static const char *LOG_TAG = "NIMBLE_NVS";
 
+/*
+ * When BLE_STORE_NVS_WRITE_BACK_MS is set, CCCD, CSFC and EAD updates are
+ * kept in RAM and written to NVS after the store has been quiet for that
+ * long, so a reconnecting peer re-subscribing to several characteristics
+ * costs one flush instead of one flash write per CCCD.  A reset before the
+ * flush loses them.  Security keys are always written through.  The default
+ * of 0 writes every update through.
+ */
+#define BLE_STORE_NVS_WRITE_BACK    (MYNEWT_VAL(BLE_STORE_NVS_WRITE_BACK_MS) > 0)
+
+#if BLE_STORE_NVS_WRITE_BACK
+/* A flush is never postponed for longer than this many quiet periods. */
+#define BLE_STORE_NVS_WB_MAX_PERIODS    4
+
+static struct ble_npl_callout ble_store_nvs_wb_timer;
+static bool ble_store_nvs_wb_timer_init;
+static uint16_t ble_store_nvs_wb_dirty;
+static ble_npl_time_t ble_store_nvs_wb_dirty_since;
+static struct ble_store_config_nvs_stats ble_store_nvs_wb_stats;
+
+static void ble_store_nvs_wb_defer(int obj_type);
+#endif
+
 /*****************************************************************************
  * $ MISC                                                                    *
  *****************************************************************************/
@@ -454,6 +479,329 @@ ble_store_nvs_peer_records(int obj_type, const struct ble_hs_dev_records *p_dev_
 }
 #endif
 
+#if BLE_STORE_NVS_WRITE_BACK
+/*****************************************************************************
+ * $ write-back                                                              *
+ *****************************************************************************/
+
+#define BLE_STORE_NVS_WB_MAX(a, b)      ((a) > (b) ? (a) : (b))
+#if MYNEWT_VAL(ENC_ADV_DATA)
+#define BLE_STORE_NVS_WB_MAX_SLOTS                                          \
+    BLE_STORE_NVS_WB_MAX(BLE_STORE_NVS_WB_MAX(MYNEWT_VAL(BLE_STORE_MAX_CCCDS), \
+                                              MYNEWT_VAL(BLE_STORE_MAX_CSFCS)), \
+                         MYNEWT_VAL(BLE_STORE_MAX_EADS))
+#else
+#define BLE_STORE_NVS_WB_MAX_SLOTS                                          \
+    BLE_STORE_NVS_WB_MAX(MYNEWT_VAL(BLE_STORE_MAX_CCCDS),                   \
+                         MYNEWT_VAL(BLE_STORE_MAX_CSFCS))
+#endif
+
+#if MYNEWT_VAL(BLE_STORE_MAX_CCCDS)
+static struct ble_store_value_cccd
+    ble_store_nvs_wb_cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+#endif
+#if MYNEWT_VAL(BLE_STORE_MAX_CSFCS)
+static struct ble_store_value_csfc
+    ble_store_nvs_wb_csfcs[MYNEWT_VAL(BLE_STORE_MAX_CSFCS)];
+#endif
+#if MYNEWT_VAL(ENC_ADV_DATA)
+static struct ble_store_value_ead
+    ble_store_nvs_wb_eads[MYNEWT_VAL(BLE_STORE_MAX_EADS)];
+#endif
+
+static void
+ble_store_nvs_wb_timer_cb(struct ble_npl_event *ev)
+{
+    ble_store_config_flush();
+}
+
+/* Marks an object type dirty and (re)arms the flush timer.  Called by the
+ * store write and delete callbacks, which do not hold the host lock; the
+ * dirty set is shared with ble_store_config_flush() and only touched in a
+ * critical section.
+ */
+static void
+ble_store_nvs_wb_defer(int obj_type)
+{
+    ble_npl_time_t delay;
+    ble_npl_time_t since;
+    ble_npl_time_t now;
+    ble_npl_time_t due;
+    uint32_t ctx;
+
+    now = ble_npl_time_get();
+    delay = ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_STORE_NVS_WRITE_BACK_MS));
+
+    ctx = ble_npl_hw_enter_critical();
+    if (ble_store_nvs_wb_dirty == 0) {
+        ble_store_nvs_wb_dirty_since = now;
+    }
+    ble_store_nvs_wb_dirty |= 1 << obj_type;
+    ble_store_nvs_wb_stats.deferred++;
+    since = ble_store_nvs_wb_dirty_since;
+    ble_npl_hw_exit_critical(ctx);
+
+    /* Wait for the store to go quiet, but not forever. */
+    due = since + BLE_STORE_NVS_WB_MAX_PERIODS * delay;
+    if ((int32_t)(due - now) > (int32_t)delay) {
+        due = now + delay;
+    }
+    if ((int32_t)(due - now) < 0) {
+        due = now;
+    }
+
+    if (ble_store_nvs_wb_timer_init) {
+        ble_npl_callout_reset(&ble_store_nvs_wb_timer, due - now);
+    }
+}
+
+/* Makes the NVS records of one object type match the given RAM copy.
+ *
+ * Records that are already correct are left alone.  A record that changed is
+ * written over a stale slot; NVS keeps the old record until the new one is
+ * complete, so after a reset each slot holds either the old or the new value.
+ * Stale slots that are not reused are erased last.
+ */
+static int
+ble_store_nvs_wb_sync(nvs_handle_t nimble_handle, int obj_type,
+                      const void *db, int db_num, size_t item_size)
+{
+    uint8_t stale[BLE_STORE_NVS_WB_MAX_SLOTS];
+    uint8_t empty[BLE_STORE_NVS_WB_MAX_SLOTS];
+    uint8_t matched[BLE_STORE_NVS_WB_MAX_SLOTS];
+    char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
+    const uint8_t *item;
+    union ble_store_value cur;
+    esp_err_t err;
+    size_t len;
+    int num_stale;
+    int num_empty;
+    int slot;
+    int max;
+    int i;
+    int j;
+
+    max = get_nvs_max_obj_value(obj_type);
+    num_stale = 0;
+    num_empty = 0;
+    memset(matched, 0, sizeof matched);
+
+    for (i = 1; i <= max; i++) {
+        get_nvs_key_string(obj_type, i, key_string);
+
+        len = item_size;
+        err = nvs_get_blob(nimble_handle, key_string, &cur, &len);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            empty[num_empty++] = i;
+            continue;
+        }
+        if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+            stale[num_stale++] = i;
+            continue;
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(LOG_TAG, "NVS read operation failed !!");
+            return BLE_HS_ESTORE_FAIL;
+        }
+
+        item = db;
+        for (j = 0; j < db_num; j++, item += item_size) {
+            if (!matched[j] && len == item_size &&
+                memcmp(&cur, item, item_size) == 0) {
+                break;
+            }
+        }
+
+        if (j < db_num) {
+            matched[j] = 1;
+        } else {
+            stale[num_stale++] = i;
+        }
+    }
+
+    item = db;
+    for (j = 0; j < db_num; j++, item += item_size) {
+        if (matched[j]) {
+            continue;
+        }
+
+        if (num_stale > 0) {
+            slot = stale[--num_stale];
+        } else if (num_empty > 0) {
+            slot = empty[--num_empty];
+        } else {
+            return BLE_HS_ESTORE_CAP;
+        }
+
+        get_nvs_key_string(obj_type, slot, key_string);
+        err = nvs_set_blob(nimble_handle, key_string, item, item_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(LOG_TAG, "NVS write operation failed !!");
+            return BLE_HS_ESTORE_FAIL;
+        }
+        ble_store_nvs_wb_stats.nvs_ops++;
+    }
+
+    while (num_stale > 0) {
+        get_nvs_key_string(obj_type, stale[--num_stale], key_string);
+        err = nvs_erase_key(nimble_handle, key_string);
+        if (err != ESP_OK) {
+            ESP_LOGE(LOG_TAG, "NVS delete operation failed !!");
+            return BLE_HS_ESTORE_FAIL;
+        }
+        ble_store_nvs_wb_stats.nvs_ops++;
+    }
+
+    return 0;
+}
+
+int
+ble_store_config_flush(void)
+{
+    nvs_handle_t nimble_handle;
+    uint16_t dirty;
+    esp_err_t err;
+    uint32_t ctx;
+    int num;
+    int rc;
+
+    if (ble_store_nvs_wb_timer_init) {
+        ble_npl_callout_stop(&ble_store_nvs_wb_timer);
+    }
+
+    /* Take the dirty set atomically; anything written while NVS is being
+     * updated marks its type dirty again and re-arms the timer.
+     */
+    ctx = ble_npl_hw_enter_critical();
+    dirty = ble_store_nvs_wb_dirty;
+    ble_store_nvs_wb_dirty = 0;
+    ble_npl_hw_exit_critical(ctx);
+
+    if (dirty == 0) {
+        return 0;
+    }
+
+    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "NVS open operation failed !!");
+        rc = BLE_HS_ESTORE_FAIL;
+        goto err;
+    }
+
+    rc = 0;
+
+#if MYNEWT_VAL(BLE_STORE_MAX_CCCDS)
+    if (rc == 0 && (dirty & (1 << BLE_STORE_OBJ_TYPE_CCCD))) {
+        ble_hs_lock();
+        num = ble_store_config_num_cccds;
+        memcpy(ble_store_nvs_wb_cccds, ble_store_config_cccds,
+               num * sizeof ble_store_nvs_wb_cccds[0]);
+        ble_hs_unlock();
+
+        rc = ble_store_nvs_wb_sync(nimble_handle, BLE_STORE_OBJ_TYPE_CCCD,
+                                   ble_store_nvs_wb_cccds, num,
+                                   sizeof ble_store_nvs_wb_cccds[0]);
+        if (rc == 0) {
+            dirty &= ~(1 << BLE_STORE_OBJ_TYPE_CCCD);
+        }
+    }
+#endif
+
+#if MYNEWT_VAL(BLE_STORE_MAX_CSFCS)
+    if (rc == 0 && (dirty & (1 << BLE_STORE_OBJ_TYPE_CSFC))) {
+        ble_hs_lock();
+        num = ble_store_config_num_csfcs;
+        memcpy(ble_store_nvs_wb_csfcs, ble_store_config_csfcs,
+               num * sizeof ble_store_nvs_wb_csfcs[0]);
+        ble_hs_unlock();
+
+        rc = ble_store_nvs_wb_sync(nimble_handle, BLE_STORE_OBJ_TYPE_CSFC,
+                                   ble_store_nvs_wb_csfcs, num,
+                                   sizeof ble_store_nvs_wb_csfcs[0]);
+        if (rc == 0) {
+            dirty &= ~(1 << BLE_STORE_OBJ_TYPE_CSFC);
+        }
+    }
+#endif
+
+#if MYNEWT_VAL(ENC_ADV_DATA)
+    if (rc == 0 && (dirty & (1 << BLE_STORE_OBJ_TYPE_ENC_ADV_DATA))) {
+        ble_hs_lock();
+        num = ble_store_config_num_eads;
+        memcpy(ble_store_nvs_wb_eads, ble_store_config_eads,
+               num * sizeof ble_store_nvs_wb_eads[0]);
+        ble_hs_unlock();
+
+        rc = ble_store_nvs_wb_sync(nimble_handle,
+                                   BLE_STORE_OBJ_TYPE_ENC_ADV_DATA,
+                                   ble_store_nvs_wb_eads, num,
+                                   sizeof ble_store_nvs_wb_eads[0]);
+        if (rc == 0) {
+            dirty &= ~(1 << BLE_STORE_OBJ_TYPE_ENC_ADV_DATA);
+        }
+    }
+#endif
+
+    if (rc == 0) {
+        err = nvs_commit(nimble_handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(LOG_TAG, "NVS commit operation failed !!");
+            rc = BLE_HS_ESTORE_FAIL;
+        }
+    }
+    nvs_close(nimble_handle);
+
+    if (rc == 0) {
+        ble_store_nvs_wb_stats.flushes++;
+        return 0;
+    }
+
+err:
+    /* Keep whatever could not be written dirty and try again later. */
+    ctx = ble_npl_hw_enter_critical();
+    if (ble_store_nvs_wb_dirty == 0) {
+        ble_store_nvs_wb_dirty_since = ble_npl_time_get();
+    }
+    ble_store_nvs_wb_dirty |= dirty;
+    ble_npl_hw_exit_critical(ctx);
+
+    if (ble_store_nvs_wb_timer_init) {
+        ble_npl_callout_reset(&ble_store_nvs_wb_timer,
+            ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_STORE_NVS_WRITE_BACK_MS)));
+    }
+
+    return rc;
+}
+
+void
+ble_store_config_nvs_stats(struct ble_store_config_nvs_stats *stats)
+{
+    uint32_t ctx;
+
+    ctx = ble_npl_hw_enter_critical();
+    *stats = ble_store_nvs_wb_stats;
+    ble_npl_hw_exit_critical(ctx);
+
+    if (stats->deferred > stats->nvs_ops) {
+        stats->saved = stats->deferred - stats->nvs_ops;
+    } else {
+        stats->saved = 0;
+    }
+}
+#else
+int
+ble_store_config_flush(void)
+{
+    return 0;
+}
+
+void
+ble_store_config_nvs_stats(struct ble_store_config_nvs_stats *stats)
+{
+    memset(stats, 0, sizeof *stats);
+}
+#endif
+
 static int
 populate_db_from_nvs(int obj_type, void *dst, int *db_num)
 {
@@ -672,6 +1020,11 @@ int ble_store_config_persist_cccds(void)
     int nvs_count, nvs_idx;
     union ble_store_value val;
 
+#if BLE_STORE_NVS_WRITE_BACK
+    ble_store_nvs_wb_defer(BLE_STORE_OBJ_TYPE_CCCD);
+    return 0;
+#endif
+
     nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_CCCD, 0, NULL, 0);
     if (nvs_count == -1) {
         ESP_LOGE(LOG_TAG, "NVS operation failed while persisting CCCD");
@@ -705,6 +1058,11 @@ int ble_store_config_persist_csfcs(void)
     int nvs_count, nvs_idx;
     union ble_store_value val;
 
+#if BLE_STORE_NVS_WRITE_BACK
+    ble_store_nvs_wb_defer(BLE_STORE_OBJ_TYPE_CSFC);
+    return 0;
+#endif
+
     nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_CSFC, 0, NULL, 0);
     if (nvs_count == -1) {
         ESP_LOGE(LOG_TAG, "NVS operation failed while persisting CSFC");
@@ -737,6 +1095,11 @@ int ble_store_config_persist_eads(void)
     int nvs_count, nvs_idx;
     union ble_store_value val;
 
+#if BLE_STORE_NVS_WRITE_BACK
+    ble_store_nvs_wb_defer(BLE_STORE_OBJ_TYPE_ENC_ADV_DATA);
+    return 0;
+#endif
+
     nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_ENC_ADV_DATA, 0, NULL, 0);
     if (nvs_count == -1) {
         ESP_LOGE(LOG_TAG, "NVS operation failed while persisting EAD");
@@ -923,6 +1286,16 @@ void ble_store_config_conf_init(void)
 {
     int err;
 
+#if BLE_STORE_NVS_WRITE_BACK
+    if (ble_store_nvs_wb_timer_init) {
+        ble_npl_callout_deinit(&ble_store_nvs_wb_timer);
+    }
+    ble_npl_callout_init(&ble_store_nvs_wb_timer, nimble_port_get_dflt_eventq(),
+                         ble_store_nvs_wb_timer_cb, NULL);
+    ble_store_nvs_wb_timer_init = true;
+    ble_store_nvs_wb_dirty = 0;
+#endif
+
     err = ble_nvs_restore_sec_keys();
     if (err != 0) {
         ESP_LOGE(LOG_TAG, "NVS operation failed, can't retrieve the bonding info");
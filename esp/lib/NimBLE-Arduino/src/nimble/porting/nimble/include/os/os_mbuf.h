@@ -1132,7 +1132,179 @@ int os_mbuf_widen(struct os_mbuf *om, uint16_t off, uint16_t len);
  */
 struct os_mbuf *os_mbuf_pack_chains(struct os_mbuf *m1, struct os_mbuf *m2);
 
+#if MYNEWT_VAL(OS_MBUF_TRACE)
+/**
+ * Called for each outstanding mbuf recorded by the allocation trace.
+ *
+ * @param om                    The outstanding mbuf.
+ * @param site                  Return address of the code that allocated it.
+ * @param age_ms                Milliseconds since it was allocated.
+ * @param arg                   The argument given to os_mbuf_trace_foreach().
+ */
+typedef void os_mbuf_trace_fn(const struct os_mbuf *om, const void *site,
+                              uint32_t age_ms, void *arg);
+
+/**
+ * Calls a function for each mbuf that has been allocated and not yet freed.
+ * Each mbuf is tagged with the return address of the outermost os_mbuf or
+ * os_msys allocation call; resolve it with addr2line.  The callback runs
+ * without the OS critical section held, so the mbuf may be freed while it
+ * runs and must not be dereferenced from another task's context.
+ *
+ * @param cb                    The function to call.
+ * @param arg                   Optional argument passed to the function.
+ *
+ * @return                      The number of outstanding mbufs.
+ */
+int os_mbuf_trace_foreach(os_mbuf_trace_fn *cb, void *arg);
+
+/**
+ * Logs every outstanding mbuf chain with its allocation site, age, packet
+ * length and number of mbufs, followed by any outstanding mbufs that are not
+ * part of a recorded chain.  The chains are walked with the OS critical
+ * section held, which blocks every mbuf free until the walk finishes; this is
+ * a debugging aid and should not be called on a hot path.
+ */
+void os_mbuf_trace_report(void);
+
+/**
+ * Returns the number of allocations that could not be recorded because the
+ * trace table was full.
+ */
+uint32_t os_mbuf_trace_dropped(void);
+#endif
+
 #endif
+
+/**
+ * A position in an mbuf chain.  Seeking forward and copying from a cursor
+ * resume at the remembered mbuf instead of walking the chain from its head,
+ * so consuming a chain piece by piece is linear in its length.
+ */
+struct os_mbuf_cursor {
+    /** Head of the chain the position refers to */
+    const struct os_mbuf *omc_head;
+    /** The mbuf containing the position */
+    const struct os_mbuf *omc_om;
+    /** Offset of the position within omc_om */
+    uint16_t omc_off;
+    /** Offset of the position from the start of the chain */
+    int omc_pos;
+};
+
+/**
+ * Positions a cursor at the start of an mbuf chain.
+ *
+ * @param omc                   The cursor to initialize.
+ * @param om                    The mbuf chain, may be NULL.
+ */
+static inline void
+os_mbuf_cursor_init(struct os_mbuf_cursor *omc, const struct os_mbuf *om)
+{
+    omc->omc_head = om;
+    omc->omc_om = om;
+    omc->omc_off = 0;
+    omc->omc_pos = 0;
+}
+
+/**
+ * Moves a cursor to an offset in an mbuf chain.  Seeking forward within the
+ * same chain continues from the current position; seeking backwards or into
+ * a different chain restarts from the head.  Like os_mbuf_off(), an offset
+ * equal to the chain length is valid and refers to the end of the last mbuf.
+ *
+ * @param omc                   The cursor to move.
+ * @param om                    The head of the mbuf chain.
+ * @param off                   The offset from the start of the chain.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the offset is past the end of
+ *                                  the chain.
+ */
+static inline int
+os_mbuf_cursor_seek(struct os_mbuf_cursor *omc, const struct os_mbuf *om,
+                    int off)
+{
+    const struct os_mbuf *cur;
+    const struct os_mbuf *next;
+    int rel;
+
+    if (omc->omc_head != om || omc->omc_om == NULL || off < omc->omc_pos) {
+        os_mbuf_cursor_init(omc, om);
+    }
+
+    cur = omc->omc_om;
+    rel = omc->omc_off + (off - omc->omc_pos);
+    while (cur != NULL) {
+        next = SLIST_NEXT(cur, om_next);
+        if (cur->om_len > rel || (cur->om_len == rel && next == NULL)) {
+            omc->omc_om = cur;
+            omc->omc_off = rel;
+            omc->omc_pos = off;
+            return 0;
+        }
+
+        rel -= cur->om_len;
+        cur = next;
+    }
+
+    return OS_EINVAL;
+}
+
+/**
+ * Appends data from the cursor position to an mbuf chain and advances the
+ * cursor past it.
+ *
+ * @param dst                   The mbuf chain to append to.
+ * @param omc                   The cursor to copy from.
+ * @param len                   The number of bytes to append.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the source chain is too short;
+ *                              OS_ENOMEM if mbuf allocation fails.
+ */
+static inline int
+os_mbuf_cursor_appendto(struct os_mbuf *dst, struct os_mbuf_cursor *omc,
+                        uint16_t len)
+{
+    const struct os_mbuf *next;
+    uint16_t chunk_sz;
+    int rc;
+
+    while (len > 0) {
+        if (omc->omc_om == NULL) {
+            return OS_EINVAL;
+        }
+
+        chunk_sz = omc->omc_om->om_len - omc->omc_off;
+        if (chunk_sz > len) {
+            chunk_sz = len;
+        }
+
+        if (chunk_sz > 0) {
+            rc = os_mbuf_append(dst, omc->omc_om->om_data + omc->omc_off,
+                                chunk_sz);
+            if (rc != 0) {
+                return rc;
+            }
+
+            len -= chunk_sz;
+            omc->omc_off += chunk_sz;
+            omc->omc_pos += chunk_sz;
+        }
+
+        /* Stay at the end of the last mbuf so the cursor remains valid. */
+        next = SLIST_NEXT(omc->omc_om, om_next);
+        if (omc->omc_off == omc->omc_om->om_len && next != NULL) {
+            omc->omc_om = next;
+            omc->omc_off = 0;
+        } else if (chunk_sz == 0) {
+            return OS_EINVAL;
+        }
+    }
+
+    return 0;
+}
 #ifdef __cplusplus
 }
 #endif
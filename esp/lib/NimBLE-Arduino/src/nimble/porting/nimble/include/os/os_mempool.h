@@ -46,6 +46,14 @@ struct os_memblock {
     SLIST_ENTRY(os_memblock) mb_next;
 };
 
+/*
+ * Per-pool failure counters add a field to struct os_mempool, so they are not
+ * available when the mempool code and layout come from the controller ROM.
+ */
+#define OS_MEMPOOL_HAS_STATS                                            \
+    (MYNEWT_VAL(OS_MEMPOOL_STATS) &&                                    \
+     !(SOC_ESP_NIMBLE_CONTROLLER && CONFIG_BT_CONTROLLER_ENABLED))
+
 /* XXX: Change this structure so that we keep the first address in the pool? */
 /* XXX: add memory debug structure and associated code */
 /* XXX: Change how I coded the SLIST_HEAD here. It should be named:
@@ -61,7 +69,11 @@ struct os_mempool {
     uint16_t mp_num_blocks;
     /** The number of free blocks left */
     uint16_t mp_num_free;
-    /** The lowest number of free blocks seen */
+    /**
+     * The lowest number of free blocks seen.  With per-core caches attached
+     * this includes cached blocks but is only sampled on refills, so it can
+     * read high by up to one cache's worth of blocks per core.
+     */
     uint16_t mp_min_free;
     /** Bitmap of OS_MEMPOOL_F_[...] values. */
     uint8_t mp_flags;
@@ -71,6 +83,10 @@ struct os_mempool {
     SLIST_HEAD(,os_memblock);
     /** Name for memory block */
     const char *name;
+#if OS_MEMPOOL_HAS_STATS
+    /** The number of allocations that found the pool empty */
+    uint32_t mp_num_fail;
+#endif
 };
 
 /**
@@ -79,6 +95,12 @@ struct os_mempool {
  */
 #define OS_MEMPOOL_F_EXT        0x01
 
+/**
+ * Indicates a mempool with per-core block caches attached; see
+ * os_mempool_pcpu_attach().
+ */
+#define OS_MEMPOOL_F_PCPU       0x02
+
 struct os_mempool_ext;
 
 /**
@@ -125,6 +147,8 @@ struct os_mempool_info {
     int omi_num_free;
     /** Minimum number of free memory blocks ever */
     int omi_min_free;
+    /** Number of failed allocations, 0 if not tracked */
+    uint32_t omi_num_fail;
     /** Name of the memory pool */
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
 };
@@ -142,6 +166,23 @@ struct os_mempool_info {
 struct os_mempool *os_mempool_info_get_next(struct os_mempool *,
                                             struct os_mempool_info *);
 
+/**
+ * Takes a snapshot of every registered memory pool, in registration order.
+ * The counters of each pool are read together under the OS critical section.
+ *
+ * @param omi       Array to fill with one entry per pool.
+ * @param max_omi   Number of entries in the array.
+ *
+ * @return The number of registered pools, which may exceed max_omi.
+ */
+int os_mempool_snapshot(struct os_mempool_info *omi, int max_omi);
+
+/**
+ * Restarts the statistics of every registered memory pool: the minimum free
+ * count is set to the current free count and the failure counter is cleared.
+ */
+void os_mempool_reset_stats(void);
+
 /*
  * To calculate size of the memory buffer needed for the pool. NOTE: This size
  * is NOT in bytes! The size is the number of os_membuf_t elements required for
@@ -401,6 +442,85 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 #endif
 
+/* Per-core caches are not available with the controller's ROM mempools. */
+#if MYNEWT_VAL(OS_MEMPOOL_PCPU_CACHE) && \
+    !(SOC_ESP_NIMBLE_CONTROLLER && CONFIG_BT_CONTROLLER_ENABLED)
+#define OS_MEMPOOL_PCPU_ENABLED 1
+#else
+#define OS_MEMPOOL_PCPU_ENABLED 0
+#endif
+
+#if OS_MEMPOOL_PCPU_ENABLED
+
+#if defined(ESP_PLATFORM) && !defined(CONFIG_FREERTOS_UNICORE)
+#define OS_MEMPOOL_PCPU_CORES   2
+#else
+#define OS_MEMPOOL_PCPU_CORES   1
+#endif
+
+/**
+ * A per-core magazine of free blocks.  Only the owning core touches it, with
+ * local interrupts masked, so the fast path takes no shared lock.
+ */
+struct os_mempool_pcpu_mag {
+    /** Number of blocks in the magazine */
+    uint16_t pm_count;
+    /** Number of refills from the shared free list */
+    uint32_t pm_refills;
+    /** Number of drains to the shared free list */
+    uint32_t pm_drains;
+    struct os_memblock *pm_blocks[MYNEWT_VAL(OS_MEMPOOL_PCPU_CACHE_SIZE)];
+};
+
+/**
+ * Per-core block caches for a mempool.  The storage is provided by the
+ * caller and must outlive the attachment.
+ */
+struct os_mempool_pcpu {
+    struct os_mempool *pc_pool;
+    SLIST_ENTRY(os_mempool_pcpu) pc_next;
+    struct os_mempool_pcpu_mag pc_mag[OS_MEMPOOL_PCPU_CORES];
+};
+
+/**
+ * Attaches per-core caches to a mempool.  os_memblock_get() and
+ * os_memblock_put() then serve blocks from the calling core's magazine,
+ * refilling and draining it in batches of half its size through the shared
+ * free list.  mp_num_free only counts the shared free list while caches are
+ * attached; use os_mempool_num_free() for the total.
+ *
+ * Extended mempools with a put callback are not supported.
+ *
+ * @param mp                    The mempool to cache.
+ * @param pc                    The cache storage.
+ *
+ * @return                      0 on success;
+ *                              OS_INVALID_PARM on bad arguments.
+ */
+os_error_t os_mempool_pcpu_attach(struct os_mempool *mp,
+                                  struct os_mempool_pcpu *pc);
+
+/**
+ * Returns all cached blocks to the shared free list and detaches the caches.
+ * Must not run while other cores allocate from the mempool.
+ *
+ * @param mp                    The mempool to detach the caches from.
+ */
+void os_mempool_pcpu_detach(struct os_mempool *mp);
+
+/**
+ * Returns the number of free blocks in a mempool, including those held in
+ * per-core caches.
+ *
+ * @param mp                    The mempool to query.
+ *
+ * @return                      The number of free blocks.
+ */
+uint16_t os_mempool_num_free(const struct os_mempool *mp);
+#else
+#define os_mempool_num_free(mp) ((mp)->mp_num_free)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
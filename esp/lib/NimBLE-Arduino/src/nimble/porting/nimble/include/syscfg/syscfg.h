@@ -476,6 +476,84 @@
 #define MYNEWT_VAL_OS_MEMPOOL_POISON (0)
 #endif
 
+#ifndef CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE (0)
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE (CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE_SIZE
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE_SIZE (4)
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_PCPU_CACHE_SIZE (CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE_SIZE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_MEMPOOL_STATS
+#define MYNEWT_VAL_OS_MEMPOOL_STATS (1)
+#else
+#define MYNEWT_VAL_OS_MEMPOOL_STATS (CONFIG_BT_NIMBLE_MEMPOOL_STATS)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_MBUF_TRACE
+#define MYNEWT_VAL_OS_MBUF_TRACE (0)
+#else
+#define MYNEWT_VAL_OS_MBUF_TRACE (CONFIG_BT_NIMBLE_MBUF_TRACE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_MBUF_TRACE_MAX
+#define MYNEWT_VAL_OS_MBUF_TRACE_MAX (64)
+#else
+#define MYNEWT_VAL_OS_MBUF_TRACE_MAX (CONFIG_BT_NIMBLE_MBUF_TRACE_MAX)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_EVQ_BATCH_SIZE
+#define MYNEWT_VAL_BLE_NPL_EVQ_BATCH_SIZE (8)
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_BATCH_SIZE (CONFIG_BT_NIMBLE_EVQ_BATCH_SIZE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_EVQ_PRIORITY
+#define MYNEWT_VAL_BLE_NPL_EVQ_PRIORITY (1)
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_PRIORITY (CONFIG_BT_NIMBLE_EVQ_PRIORITY)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_RPA_CACHE_SIZE
+#define MYNEWT_VAL_BLE_HS_RESOLV_CACHE_SIZE (16)
+#else
+#define MYNEWT_VAL_BLE_HS_RESOLV_CACHE_SIZE (CONFIG_BT_NIMBLE_RPA_CACHE_SIZE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_AES_KEY_CACHE_SIZE
+#define MYNEWT_VAL_BLE_SM_ALG_KEY_CACHE_SIZE (4)
+#else
+#define MYNEWT_VAL_BLE_SM_ALG_KEY_CACHE_SIZE (CONFIG_BT_NIMBLE_AES_KEY_CACHE_SIZE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_CRYPTO_AES_TTABLE
+#define MYNEWT_VAL_BLE_CRYPTO_AES_TTABLE (1)
+#else
+#define MYNEWT_VAL_BLE_CRYPTO_AES_TTABLE (CONFIG_BT_NIMBLE_CRYPTO_AES_TTABLE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_CRYPTO_ECC_COMB
+#define MYNEWT_VAL_BLE_CRYPTO_ECC_COMB (1)
+#else
+#define MYNEWT_VAL_BLE_CRYPTO_ECC_COMB (CONFIG_BT_NIMBLE_CRYPTO_ECC_COMB)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_SM_PRECOMPUTE
+#define MYNEWT_VAL_BLE_SM_PRECOMPUTE (0)
+#else
+#define MYNEWT_VAL_BLE_SM_PRECOMPUTE (CONFIG_BT_NIMBLE_SM_PRECOMPUTE)
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_EVQ_STATS
+#define MYNEWT_VAL_BLE_NPL_EVQ_STATS (0)
+#else
+#define MYNEWT_VAL_BLE_NPL_EVQ_STATS (CONFIG_BT_NIMBLE_EVQ_STATS)
+#endif
+
 #ifndef MYNEWT_VAL_OS_SCHEDULING
 #define MYNEWT_VAL_OS_SCHEDULING (1)
 #endif
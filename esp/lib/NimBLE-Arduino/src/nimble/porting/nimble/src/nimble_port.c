@@ -315,14 +315,25 @@ void
 nimble_port_run(void)
 {
     struct ble_npl_event *ev;
+    int budget;
 
     while (1) {
         ev = ble_npl_eventq_get(&g_eventq_dflt, BLE_NPL_TIME_FOREVER);
-        if (ev) {
+        budget = MYNEWT_VAL(BLE_NPL_EVQ_BATCH_SIZE);
+
+        /* Drain what is already queued without blocking, then let other
+         * tasks of the same priority run before taking the next batch.
+         */
+        while (ev) {
             ble_npl_event_run(ev);
             if (ev == &ble_hs_ev_stop) {
+                return;
+            }
+            if (--budget == 0) {
+                taskYIELD();
                 break;
             }
+            ev = ble_npl_eventq_get(&g_eventq_dflt, 0);
         }
     }
 }
@@ -66,6 +66,211 @@ STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
 
 static uint8_t log_count;
 
+#if MYNEWT_VAL(OS_MBUF_TRACE)
+#define OS_MBUF_TRACE_MAX   MYNEWT_VAL(OS_MBUF_TRACE_MAX)
+#define OS_MBUF_TRACE_SITE() __builtin_return_address(0)
+
+struct os_mbuf_trace_ent {
+    const struct os_mbuf *ote_om;
+    const void *ote_site;
+    ble_npl_time_t ote_time;
+};
+
+static struct os_mbuf_trace_ent os_mbuf_trace_tbl[OS_MBUF_TRACE_MAX];
+static uint32_t os_mbuf_trace_num_dropped;
+
+/*
+ * Records an allocation, or re-tags one already recorded.  Allocators that
+ * call other allocators tag after them, so the outermost caller's address is
+ * the one kept.
+ */
+static void
+os_mbuf_trace_alloc(const struct os_mbuf *om, const void *site)
+{
+    struct os_mbuf_trace_ent *ent;
+    ble_npl_time_t now;
+    os_sr_t sr;
+    int i;
+
+    if (om == NULL) {
+        return;
+    }
+
+    now = ble_npl_time_get();
+    ent = NULL;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        if (os_mbuf_trace_tbl[i].ote_om == om) {
+            ent = &os_mbuf_trace_tbl[i];
+            break;
+        }
+        if (ent == NULL && os_mbuf_trace_tbl[i].ote_om == NULL) {
+            ent = &os_mbuf_trace_tbl[i];
+        }
+    }
+
+    if (ent == NULL) {
+        os_mbuf_trace_num_dropped++;
+    } else {
+        if (ent->ote_om != om) {
+            ent->ote_om = om;
+            ent->ote_time = now;
+        }
+        ent->ote_site = site;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+os_mbuf_trace_free(const struct os_mbuf *om)
+{
+    os_sr_t sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        if (os_mbuf_trace_tbl[i].ote_om == om) {
+            os_mbuf_trace_tbl[i].ote_om = NULL;
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+os_mbuf_trace_foreach(os_mbuf_trace_fn *cb, void *arg)
+{
+    struct os_mbuf_trace_ent ent;
+    ble_npl_time_t now;
+    os_sr_t sr;
+    int count;
+    int i;
+
+    now = ble_npl_time_get();
+    count = 0;
+
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        OS_ENTER_CRITICAL(sr);
+        ent = os_mbuf_trace_tbl[i];
+        OS_EXIT_CRITICAL(sr);
+
+        if (ent.ote_om == NULL) {
+            continue;
+        }
+
+        count++;
+        if (cb != NULL) {
+            cb(ent.ote_om, ent.ote_site,
+               ble_npl_time_ticks_to_ms32(now - ent.ote_time), arg);
+        }
+    }
+
+    return count;
+}
+
+/* What os_mbuf_trace_report() logs for one entry, copied while it is live. */
+struct os_mbuf_trace_rpt {
+    struct os_mbuf_trace_ent otr_ent;
+    uint16_t otr_len;
+    uint16_t otr_num_mbufs;
+    uint8_t otr_pkthdr;
+    uint8_t otr_chained;
+};
+
+void
+os_mbuf_trace_report(void)
+{
+    static struct os_mbuf_trace_rpt rpt[OS_MBUF_TRACE_MAX];
+    const struct os_mbuf *om;
+    ble_npl_time_t now;
+    uint32_t dropped;
+    os_sr_t sr;
+    int count;
+    int i;
+    int j;
+
+    now = ble_npl_time_get();
+    memset(rpt, 0, sizeof rpt);
+
+    /*
+     * os_mbuf_free() drops an mbuf from the table inside the critical section
+     * before returning it to its pool, so every mbuf reachable from the table
+     * stays allocated until we exit.  Copy out all the fields we log here.
+     */
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        rpt[i].otr_ent = os_mbuf_trace_tbl[i];
+    }
+
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        om = rpt[i].otr_ent.ote_om;
+        if (om == NULL) {
+            continue;
+        }
+
+        rpt[i].otr_len = om->om_len;
+        if (!OS_MBUF_IS_PKTHDR(om)) {
+            continue;
+        }
+
+        rpt[i].otr_pkthdr = 1;
+        rpt[i].otr_len = OS_MBUF_PKTHDR(om)->omp_len;
+        for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+            rpt[i].otr_num_mbufs++;
+            for (j = 0; j < OS_MBUF_TRACE_MAX; j++) {
+                if (rpt[j].otr_ent.ote_om == om) {
+                    rpt[j].otr_chained = 1;
+                }
+            }
+        }
+    }
+    dropped = os_mbuf_trace_num_dropped;
+    OS_EXIT_CRITICAL(sr);
+
+    count = 0;
+
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        if (!rpt[i].otr_pkthdr) {
+            continue;
+        }
+
+        MODLOG_DFLT(WARN, "mbuf chain %p: len=%u mbufs=%u site=%p "
+                    "age=%lu ms\n", rpt[i].otr_ent.ote_om,
+                    rpt[i].otr_len, rpt[i].otr_num_mbufs,
+                    rpt[i].otr_ent.ote_site,
+                    (unsigned long)ble_npl_time_ticks_to_ms32(
+                        now - rpt[i].otr_ent.ote_time));
+        count++;
+    }
+
+    for (i = 0; i < OS_MBUF_TRACE_MAX; i++) {
+        if (rpt[i].otr_ent.ote_om == NULL || rpt[i].otr_chained) {
+            continue;
+        }
+
+        MODLOG_DFLT(WARN, "mbuf %p: len=%u site=%p age=%lu ms (unchained)\n",
+                    rpt[i].otr_ent.ote_om, rpt[i].otr_len,
+                    rpt[i].otr_ent.ote_site,
+                    (unsigned long)ble_npl_time_ticks_to_ms32(
+                        now - rpt[i].otr_ent.ote_time));
+        count++;
+    }
+
+    MODLOG_DFLT(WARN, "mbuf trace: %d outstanding, %lu allocations untraced\n",
+                count, (unsigned long)dropped);
+}
+
+uint32_t
+os_mbuf_trace_dropped(void)
+{
+    return os_mbuf_trace_num_dropped;
+}
+#else
+#define os_mbuf_trace_alloc(om, site)
+#define os_mbuf_trace_free(om)
+#endif
+
 int
 os_mqueue_init(struct os_mqueue *mq, ble_npl_event_fn *ev_cb, void *arg)
 {
@@ -190,6 +395,7 @@ os_msys_get(uint16_t dsize, uint16_t leadingspace)
     }
 
     m = os_mbuf_get(pool, leadingspace);
+    os_mbuf_trace_alloc(m, OS_MBUF_TRACE_SITE());
     return (m);
 err:
     log_count ++;
@@ -214,6 +420,7 @@ os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
     }
 
     m = os_mbuf_get_pkthdr(pool, user_hdr_len);
+    os_mbuf_trace_alloc(m, OS_MBUF_TRACE_SITE());
     return (m);
 err:
     log_count ++;
@@ -245,7 +452,7 @@ os_msys_num_free(void)
 
     total = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
-        total += omp->omp_pool->mp_num_free;
+        total += os_mempool_num_free(omp->omp_pool);
     }
 
     return total;
@@ -286,6 +493,7 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
     om->om_len = 0;
     om->om_data = (&om->om_databuf[0] + leadingspace);
     om->om_omp = omp;
+    os_mbuf_trace_alloc(om, OS_MBUF_TRACE_SITE());
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MBUF_GET, (uint32_t)(uintptr_t)om);
@@ -318,6 +526,7 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
         pkthdr->omp_len = 0;
         pkthdr->omp_flags = 0;
         STAILQ_NEXT(pkthdr, omp_next) = NULL;
+        os_mbuf_trace_alloc(om, OS_MBUF_TRACE_SITE());
     }
 
 done:
@@ -333,6 +542,7 @@ os_mbuf_free(struct os_mbuf *om)
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)(uintptr_t)om);
 
     if (om->om_omp != NULL) {
+        os_mbuf_trace_free(om);
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
             goto done;
@@ -404,31 +614,25 @@ os_mbuf_len(const struct os_mbuf *om)
     return len;
 }
 
-int
-os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
+/*
+ * Appends data after the mbuf *last, which must be the tail of the chain
+ * headed by om, and leaves *last pointing at the new tail.
+ */
+static int
+os_mbuf_append_tail(struct os_mbuf *om, struct os_mbuf **last,
+                    const void *data, uint16_t len)
 {
     struct os_mbuf_pool *omp;
-    struct os_mbuf *last;
+    struct os_mbuf *tail;
     struct os_mbuf *new;
     int remainder;
     int space;
-    int rc;
-
-    if (om == NULL) {
-        rc = OS_EINVAL;
-        goto err;
-    }
 
     omp = om->om_omp;
-
-    /* Scroll to last mbuf in the chain */
-    last = om;
-    while (SLIST_NEXT(last, om_next) != NULL) {
-        last = SLIST_NEXT(last, om_next);
-    }
+    tail = *last;
 
     remainder = len;
-    space = OS_MBUF_TRAILINGSPACE(last);
+    space = OS_MBUF_TRAILINGSPACE(tail);
 
     /* If room in current mbuf, copy the first part of the data into the
      * remaining space in that mbuf.
@@ -438,9 +642,9 @@ os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
             space = remainder;
         }
 
-        memcpy(OS_MBUF_DATA(last, uint8_t *) + last->om_len , data, space);
+        memcpy(OS_MBUF_DATA(tail, uint8_t *) + tail->om_len , data, space);
 
-        last->om_len += space;
+        tail->om_len += space;
         data += space;
         remainder -= space;
     }
@@ -458,24 +662,40 @@ os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
         memcpy(OS_MBUF_DATA(new, void *), data, new->om_len);
         data += new->om_len;
         remainder -= new->om_len;
-        SLIST_NEXT(last, om_next) = new;
-        last = new;
+        SLIST_NEXT(tail, om_next) = new;
+        tail = new;
     }
 
+    *last = tail;
+
     /* Adjust the packet header length in the buffer */
     if (OS_MBUF_IS_PKTHDR(om)) {
         OS_MBUF_PKTHDR(om)->omp_len += len - remainder;
     }
 
     if (remainder != 0) {
-        rc = OS_ENOMEM;
-        goto err;
+        return OS_ENOMEM;
     }
 
+    return 0;
+}
 
-    return (0);
-err:
-    return (rc);
+int
+os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
+{
+    struct os_mbuf *last;
+
+    if (om == NULL) {
+        return OS_EINVAL;
+    }
+
+    /* Scroll to last mbuf in the chain */
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
+    return os_mbuf_append_tail(om, &last, data, len);
 }
 
 int
@@ -483,10 +703,21 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
                    uint16_t src_off, uint16_t len)
 {
     const struct os_mbuf *src_cur_om;
+    struct os_mbuf *last;
     uint16_t src_cur_off;
     uint16_t chunk_sz;
     int rc;
 
+    if (dst == NULL) {
+        return OS_EINVAL;
+    }
+
+    /* Find the tail once rather than for every source mbuf. */
+    last = dst;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
     src_cur_om = os_mbuf_off(src, src_off, &src_cur_off);
     while (len > 0) {
         if (src_cur_om == NULL) {
@@ -494,7 +725,8 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
         }
 
         chunk_sz = min(len, src_cur_om->om_len - src_cur_off);
-        rc = os_mbuf_append(dst, src_cur_om->om_data + src_cur_off, chunk_sz);
+        rc = os_mbuf_append_tail(dst, &last, src_cur_om->om_data + src_cur_off,
+                                 chunk_sz);
         if (rc != 0) {
             return rc;
         }
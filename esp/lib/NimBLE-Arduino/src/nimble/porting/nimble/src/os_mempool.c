@@ -44,6 +44,38 @@
 
 STAILQ_HEAD(, os_mempool) g_os_mempool_list = STAILQ_HEAD_INITIALIZER(g_os_mempool_list);
 
+#if OS_MEMPOOL_PCPU_ENABLED
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* Only masks interrupts on the calling core; no cross-core spinlock. */
+#define OS_MEMPOOL_PCPU_ENTER(_sr)  ((_sr) = portSET_INTERRUPT_MASK_FROM_ISR())
+#define OS_MEMPOOL_PCPU_EXIT(_sr)   portCLEAR_INTERRUPT_MASK_FROM_ISR(_sr)
+#if OS_MEMPOOL_PCPU_CORES > 1
+#define OS_MEMPOOL_PCPU_CORE_ID()   xPortGetCoreID()
+#else
+#define OS_MEMPOOL_PCPU_CORE_ID()   0
+#endif
+#else
+#define OS_MEMPOOL_PCPU_ENTER(_sr)  OS_ENTER_CRITICAL(_sr)
+#define OS_MEMPOOL_PCPU_EXIT(_sr)   OS_EXIT_CRITICAL(_sr)
+#define OS_MEMPOOL_PCPU_CORE_ID()   0
+#endif
+
+#define OS_MEMPOOL_PCPU_SIZE        MYNEWT_VAL(OS_MEMPOOL_PCPU_CACHE_SIZE)
+#define OS_MEMPOOL_PCPU_BATCH       ((OS_MEMPOOL_PCPU_SIZE + 1) / 2)
+
+/*
+ * Blocks held in the other cores' magazines cannot be allocated by this core,
+ * so caches are only attached to pools large enough to absorb that.
+ */
+#define OS_MEMPOOL_PCPU_MIN_BLOCKS  \
+    (4 * OS_MEMPOOL_PCPU_SIZE * OS_MEMPOOL_PCPU_CORES)
+
+static SLIST_HEAD(, os_mempool_pcpu) os_mempool_pcpu_list;
+#endif
+
 #if MYNEWT_VAL(OS_MEMPOOL_POISON)
 static uint32_t os_mem_poison = 0xde7ec7ed;
 
@@ -120,6 +152,201 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard_check(mp, start)
 #endif
 
+#if OS_MEMPOOL_PCPU_ENABLED
+static struct os_mempool_pcpu *
+os_mempool_pcpu_find(const struct os_mempool *mp)
+{
+    struct os_mempool_pcpu *pc;
+
+    SLIST_FOREACH(pc, &os_mempool_pcpu_list, pc_next) {
+        if (pc->pc_pool == mp) {
+            return pc;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Moves up to a batch of blocks from the shared free list to a magazine.
+ * Cached blocks are still free, so the low-water mark counts them too; the
+ * other cores' counts are read unlocked, which is close enough for a stat.
+ */
+static void
+os_mempool_pcpu_refill(struct os_mempool *mp, struct os_mempool_pcpu *pc,
+                       struct os_mempool_pcpu_mag *mag)
+{
+    struct os_memblock *block;
+    os_sr_t sr;
+    uint16_t num_free;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    while (mag->pm_count < OS_MEMPOOL_PCPU_BATCH && mp->mp_num_free) {
+        block = SLIST_FIRST(mp);
+        SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
+        mp->mp_num_free--;
+        mag->pm_blocks[mag->pm_count++] = block;
+    }
+    num_free = mp->mp_num_free;
+    for (i = 0; i < OS_MEMPOOL_PCPU_CORES; i++) {
+        num_free += pc->pc_mag[i].pm_count;
+    }
+    if (mp->mp_min_free > num_free) {
+        mp->mp_min_free = num_free;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    mag->pm_refills++;
+}
+
+/*
+ * Moves the coldest blocks (bottom of the magazine) to the shared free list,
+ * keeping the most recently freed ones cached.
+ */
+static void
+os_mempool_pcpu_drain(struct os_mempool *mp, struct os_mempool_pcpu_mag *mag,
+                      uint16_t count)
+{
+    struct os_memblock *block;
+    os_sr_t sr;
+    uint16_t i;
+
+    if (count > mag->pm_count) {
+        count = mag->pm_count;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < count; i++) {
+        block = mag->pm_blocks[i];
+        SLIST_NEXT(block, mb_next) = SLIST_FIRST(mp);
+        SLIST_FIRST(mp) = block;
+        mp->mp_num_free++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    mag->pm_count -= count;
+    memmove(mag->pm_blocks, mag->pm_blocks + count,
+            mag->pm_count * sizeof mag->pm_blocks[0]);
+    mag->pm_drains++;
+}
+
+static struct os_memblock *
+os_mempool_pcpu_get(struct os_mempool *mp, struct os_mempool_pcpu *pc)
+{
+    struct os_mempool_pcpu_mag *mag;
+    struct os_memblock *block;
+    os_sr_t sr;
+
+    block = NULL;
+
+    OS_MEMPOOL_PCPU_ENTER(sr);
+    mag = &pc->pc_mag[OS_MEMPOOL_PCPU_CORE_ID()];
+    if (mag->pm_count == 0) {
+        os_mempool_pcpu_refill(mp, pc, mag);
+    }
+    if (mag->pm_count > 0) {
+        block = mag->pm_blocks[--mag->pm_count];
+    }
+    OS_MEMPOOL_PCPU_EXIT(sr);
+
+    return block;
+}
+
+static void
+os_mempool_pcpu_put(struct os_mempool *mp, struct os_mempool_pcpu *pc,
+                    struct os_memblock *block)
+{
+    struct os_mempool_pcpu_mag *mag;
+    os_sr_t sr;
+
+    OS_MEMPOOL_PCPU_ENTER(sr);
+    mag = &pc->pc_mag[OS_MEMPOOL_PCPU_CORE_ID()];
+    if (mag->pm_count == OS_MEMPOOL_PCPU_SIZE) {
+        os_mempool_pcpu_drain(mp, mag, OS_MEMPOOL_PCPU_BATCH);
+    }
+    mag->pm_blocks[mag->pm_count++] = block;
+    OS_MEMPOOL_PCPU_EXIT(sr);
+}
+
+os_error_t
+os_mempool_pcpu_attach(struct os_mempool *mp, struct os_mempool_pcpu *pc)
+{
+    struct os_mempool_pcpu *old;
+    os_sr_t sr;
+
+    if (mp == NULL || pc == NULL || (mp->mp_flags & OS_MEMPOOL_F_EXT)) {
+        return OS_INVALID_PARM;
+    }
+
+    if (mp->mp_num_blocks < OS_MEMPOOL_PCPU_MIN_BLOCKS) {
+        return OS_ENOMEM;
+    }
+
+    os_mempool_pcpu_detach(mp);
+
+    /* A pool that was re-initialized may still have a stale entry. */
+    old = os_mempool_pcpu_find(mp);
+    if (old != NULL) {
+        SLIST_REMOVE(&os_mempool_pcpu_list, old, os_mempool_pcpu, pc_next);
+    }
+
+    memset(pc->pc_mag, 0, sizeof pc->pc_mag);
+    pc->pc_pool = mp;
+
+    OS_ENTER_CRITICAL(sr);
+    SLIST_INSERT_HEAD(&os_mempool_pcpu_list, pc, pc_next);
+    mp->mp_flags |= OS_MEMPOOL_F_PCPU;
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+
+void
+os_mempool_pcpu_detach(struct os_mempool *mp)
+{
+    struct os_mempool_pcpu *pc;
+    os_sr_t sr;
+    int i;
+
+    pc = os_mempool_pcpu_find(mp);
+    if (pc == NULL) {
+        return;
+    }
+
+    if (mp->mp_flags & OS_MEMPOOL_F_PCPU) {
+        for (i = 0; i < OS_MEMPOOL_PCPU_CORES; i++) {
+            os_mempool_pcpu_drain(mp, &pc->pc_mag[i], pc->pc_mag[i].pm_count);
+        }
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    mp->mp_flags &= ~OS_MEMPOOL_F_PCPU;
+    SLIST_REMOVE(&os_mempool_pcpu_list, pc, os_mempool_pcpu, pc_next);
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint16_t
+os_mempool_num_free(const struct os_mempool *mp)
+{
+    const struct os_mempool_pcpu *pc;
+    uint16_t num_free;
+    int i;
+
+    num_free = mp->mp_num_free;
+    if (mp->mp_flags & OS_MEMPOOL_F_PCPU) {
+        pc = os_mempool_pcpu_find(mp);
+        if (pc != NULL) {
+            for (i = 0; i < OS_MEMPOOL_PCPU_CORES; i++) {
+                num_free += pc->pc_mag[i].pm_count;
+            }
+        }
+    }
+
+    return num_free;
+}
+#endif
+
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
                          uint32_t block_size, void *membuf, const char *name,
@@ -156,6 +383,9 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
     mp->mp_num_blocks = blocks;
     mp->mp_membuf_addr = (uint32_t)(uintptr_t)membuf;
     mp->name = name;
+#if OS_MEMPOOL_HAS_STATS
+    mp->mp_num_fail = 0;
+#endif
     SLIST_FIRST(mp) = membuf;
 
     if (blocks > 0) {
@@ -260,9 +490,27 @@ os_mempool_clear(struct os_mempool *mp)
 
     true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
 
+#if OS_MEMPOOL_PCPU_ENABLED
+    /* Every block goes back on the shared free list. */
+    if (mp->mp_flags & OS_MEMPOOL_F_PCPU) {
+        struct os_mempool_pcpu *pc;
+        int i;
+
+        pc = os_mempool_pcpu_find(mp);
+        if (pc != NULL) {
+            for (i = 0; i < OS_MEMPOOL_PCPU_CORES; i++) {
+                pc->pc_mag[i].pm_count = 0;
+            }
+        }
+    }
+#endif
+
     /* cleanup the memory pool structure */
     mp->mp_num_free = mp->mp_num_blocks;
     mp->mp_min_free = mp->mp_num_blocks;
+#if OS_MEMPOOL_HAS_STATS
+    mp->mp_num_fail = 0;
+#endif
     os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
     os_mempool_guard(mp, (void *)mp->mp_membuf_addr);
     SLIST_FIRST(mp) = (void *)(uintptr_t)mp->mp_membuf_addr;
@@ -351,6 +599,28 @@ os_memblock_get(struct os_mempool *mp)
 
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
+#if OS_MEMPOOL_PCPU_ENABLED
+    if (mp && (mp->mp_flags & OS_MEMPOOL_F_PCPU)) {
+        struct os_mempool_pcpu *pc;
+
+        pc = os_mempool_pcpu_find(mp);
+        if (pc != NULL) {
+            block = os_mempool_pcpu_get(mp, pc);
+            if (block) {
+                os_mempool_poison_check(mp, block);
+                os_mempool_guard_check(mp, block);
+            }
+#if OS_MEMPOOL_HAS_STATS
+            else {
+                OS_ENTER_CRITICAL(sr);
+                mp->mp_num_fail++;
+                OS_EXIT_CRITICAL(sr);
+            }
+#endif
+            goto done;
+        }
+    }
+#endif
     if (mp) {
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
@@ -367,6 +637,11 @@ os_memblock_get(struct os_mempool *mp)
                 mp->mp_min_free = mp->mp_num_free;
             }
         }
+#if OS_MEMPOOL_HAS_STATS
+        else {
+            mp->mp_num_fail++;
+        }
+#endif
         OS_EXIT_CRITICAL(sr);
 
         if (block) {
@@ -375,6 +650,9 @@ os_memblock_get(struct os_mempool *mp)
         }
     }
 
+#if OS_MEMPOOL_PCPU_ENABLED
+done:
+#endif
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_GET, (uint32_t)(uintptr_t)block);
 
     return (void *)block;
@@ -438,6 +716,21 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     SLIST_FOREACH(block, mp, mb_next) {
         assert(block != (struct os_memblock *)block_addr);
     }
+#if OS_MEMPOOL_PCPU_ENABLED
+    if (mp->mp_flags & OS_MEMPOOL_F_PCPU) {
+        struct os_mempool_pcpu *pc;
+        int i;
+        int j;
+
+        pc = os_mempool_pcpu_find(mp);
+        for (i = 0; pc != NULL && i < OS_MEMPOOL_PCPU_CORES; i++) {
+            for (j = 0; j < pc->pc_mag[i].pm_count; j++) {
+                assert(pc->pc_mag[i].pm_blocks[j] !=
+                       (struct os_memblock *)block_addr);
+            }
+        }
+    }
+#endif
 #endif
     /* If this is an extended mempool with a put callback, call the callback
      * instead of freeing the block directly.
@@ -450,6 +743,21 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
         }
     }
 
+#if OS_MEMPOOL_PCPU_ENABLED
+    if (mp->mp_flags & OS_MEMPOOL_F_PCPU) {
+        struct os_mempool_pcpu *pc;
+
+        pc = os_mempool_pcpu_find(mp);
+        if (pc != NULL) {
+            os_mempool_guard_check(mp, block_addr);
+            os_mempool_poison(mp, block_addr);
+            os_mempool_pcpu_put(mp, pc, block_addr);
+            ret = OS_OK;
+            goto done;
+        }
+    }
+#endif
+
     /* No callback; free the block. */
     ret = os_memblock_put_from_cb(mp, block_addr);
 
@@ -458,6 +766,32 @@ done:
     return ret;
 }
 
+static void
+os_mempool_info_fill(const struct os_mempool *mp, struct os_mempool_info *omi)
+{
+    os_sr_t sr;
+
+    omi->omi_block_size = mp->mp_block_size;
+    omi->omi_num_blocks = mp->mp_num_blocks;
+
+    OS_ENTER_CRITICAL(sr);
+    omi->omi_num_free = os_mempool_num_free(mp);
+    omi->omi_min_free = mp->mp_min_free;
+#if OS_MEMPOOL_HAS_STATS
+    omi->omi_num_fail = mp->mp_num_fail;
+#else
+    omi->omi_num_fail = 0;
+#endif
+    OS_EXIT_CRITICAL(sr);
+
+    if (mp->name != NULL) {
+        strncpy(omi->omi_name, mp->name, sizeof(omi->omi_name) - 1);
+        omi->omi_name[sizeof(omi->omi_name) - 1] = '\0';
+    } else {
+        omi->omi_name[0] = '\0';
+    }
+}
+
 struct os_mempool *
 os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 {
@@ -473,16 +807,44 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
         return (NULL);
     }
 
-    omi->omi_block_size = cur->mp_block_size;
-    omi->omi_num_blocks = cur->mp_num_blocks;
-    omi->omi_num_free = cur->mp_num_free;
-    omi->omi_min_free = cur->mp_min_free;
-    strncpy(omi->omi_name, cur->name, sizeof(omi->omi_name) - 1);
-    omi->omi_name[sizeof(omi->omi_name) - 1] = '\0';
+    os_mempool_info_fill(cur, omi);
 
     return (cur);
 }
 
+int
+os_mempool_snapshot(struct os_mempool_info *omi, int max_omi)
+{
+    struct os_mempool *cur;
+    int count;
+
+    count = 0;
+    STAILQ_FOREACH(cur, &g_os_mempool_list, mp_list) {
+        if (count < max_omi) {
+            os_mempool_info_fill(cur, &omi[count]);
+        }
+        count++;
+    }
+
+    return count;
+}
+
+void
+os_mempool_reset_stats(void)
+{
+    struct os_mempool *cur;
+    os_sr_t sr;
+
+    STAILQ_FOREACH(cur, &g_os_mempool_list, mp_list) {
+        OS_ENTER_CRITICAL(sr);
+        cur->mp_min_free = os_mempool_num_free(cur);
+#if OS_MEMPOOL_HAS_STATS
+        cur->mp_num_fail = 0;
+#endif
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
 void
 os_mempool_module_init(void)
 {
@@ -61,6 +61,9 @@ static os_membuf_t os_msys_init_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
 #endif
 static struct os_mbuf_pool os_msys_init_1_mbuf_pool;
 static struct os_mempool os_msys_init_1_mempool;
+#if OS_MEMPOOL_PCPU_ENABLED
+static struct os_mempool_pcpu os_msys_init_1_pcpu;
+#endif
 #endif
 
 #if OS_MSYS_2_BLOCK_COUNT > 0
@@ -76,6 +79,9 @@ static os_membuf_t os_msys_init_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
 #endif
 static struct os_mbuf_pool os_msys_init_2_mbuf_pool;
 static struct os_mempool os_msys_init_2_mempool;
+#if OS_MEMPOOL_PCPU_ENABLED
+static struct os_mempool_pcpu os_msys_init_2_pcpu;
+#endif
 #endif
 
 #define OS_MSYS_SANITY_ENABLED                  \
@@ -123,7 +129,7 @@ os_msys_sanity(struct os_sanity_check *sc, void *arg)
     idx = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
         min_count = os_msys_sanity_min_count(idx);
-        if (omp->omp_pool->mp_num_free < min_count) {
+        if (os_mempool_num_free(omp->omp_pool) < min_count) {
             return OS_ENOMEM;
         }
 
@@ -149,6 +155,7 @@ os_msys_init_once(void *data, struct os_mempool *mempool,
     SYSINIT_PANIC_ASSERT(rc == 0);
 }
 
+
 #ifdef ESP_PLATFORM
 int
 os_msys_buf_alloc(void)
@@ -205,6 +212,11 @@ void os_msys_init(void)
                       OS_MSYS_1_BLOCK_COUNT,
                       SYSINIT_MSYS_1_MEMBLOCK_SIZE,
                       "msys_1");
+#if OS_MEMPOOL_PCPU_ENABLED
+    /* Pools too small to spare the cached blocks stay uncached. */
+    (void)os_mempool_pcpu_attach(&os_msys_init_1_mempool,
+                                 &os_msys_init_1_pcpu);
+#endif
 #endif
 
 #if OS_MSYS_2_BLOCK_COUNT > 0
@@ -214,6 +226,10 @@ void os_msys_init(void)
                       OS_MSYS_2_BLOCK_COUNT,
                       SYSINIT_MSYS_2_MEMBLOCK_SIZE,
                       "msys_2");
+#if OS_MEMPOOL_PCPU_ENABLED
+    (void)os_mempool_pcpu_attach(&os_msys_init_2_mempool,
+                                 &os_msys_init_2_pcpu);
+#endif
 #endif
 
 #if OS_MSYS_SANITY_ENABLED
@@ -26,14 +26,58 @@ extern "C" {
 
 typedef void ble_npl_event_fn(struct ble_npl_event *ev);
 
+#define BLE_NPL_EVENT_PRIO_HIGH     (0)
+#define BLE_NPL_EVENT_PRIO_LOW      (1)
+
+struct ble_npl_eventq_freertos;
+
 struct ble_npl_event_freertos {
     bool queued;
+    uint8_t prio;
     ble_npl_event_fn *fn;
     void *arg;
+    /* Queue linkage, valid while queued */
+    struct ble_npl_event *ev;
+    struct ble_npl_eventq_freertos *evq;
+    TAILQ_ENTRY(ble_npl_event_freertos) link;
+    uint32_t enq_time;
+};
+
+TAILQ_HEAD(ble_npl_event_freertos_list, ble_npl_event_freertos);
+
+/* Per event queue statistics, see npl_freertos_eventq_stats() */
+struct ble_npl_eventq_stats {
+    /* Events put on the queue */
+    uint32_t posted;
+    /* Events taken off the queue */
+    uint32_t taken;
+    /* Events waiting now, and the most ever waiting */
+    uint16_t depth;
+    uint16_t max_depth;
+    /* Time events waited on the queue, in microseconds */
+    uint32_t avg_latency_us;
+    uint32_t max_latency_us;
+    /* Times the consumer had to block for an event */
+    uint32_t waits;
 };
 
 struct ble_npl_eventq_freertos {
-    QueueHandle_t q;
+    /* Given when an event is put while a consumer is blocked */
+    SemaphoreHandle_t sem;
+#ifdef ESP_PLATFORM
+    portMUX_TYPE lock;
+#endif
+    struct ble_npl_event_freertos_list hi;
+    struct ble_npl_event_freertos_list lo;
+    uint16_t hi_burst;
+    bool waiting;
+    uint16_t depth;
+    uint16_t max_depth;
+    uint32_t posted;
+    uint32_t taken;
+    uint32_t waits;
+    uint32_t max_latency_us;
+    uint64_t total_latency_us;
 };
 
 struct ble_npl_callout_freertos {
@@ -67,6 +111,13 @@ void npl_freertos_eventq_put(struct ble_npl_eventq *evq,
 void npl_freertos_eventq_remove(struct ble_npl_eventq *evq,
                                 struct ble_npl_event *ev);
 
+void npl_freertos_event_set_prio(struct ble_npl_event *ev, uint8_t prio);
+
+ble_npl_error_t npl_freertos_eventq_stats(struct ble_npl_eventq *evq,
+                                          struct ble_npl_eventq_stats *stats);
+
+void npl_freertos_eventq_stats_reset(struct ble_npl_eventq *evq);
+
 ble_npl_error_t npl_freertos_mutex_init(struct ble_npl_mutex *mu);
 ble_npl_error_t npl_freertos_mutex_deinit(struct ble_npl_mutex *mu);
 
@@ -20,6 +20,7 @@
 #include <stddef.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "../../../nimble/include/nimble/nimble_port.h"
 
 static TaskHandle_t host_task_h = NULL;
@@ -33,6 +34,8 @@ UBaseType_t nimble_port_freertos_get_hs_hwm(void) {
 
 #ifdef ESP_PLATFORM
 #include "esp_bt.h"
+#include "../../../../nimble/include/nimble/nimble_opt.h"
+#include "../../../../nimble/host/include/host/ble_sm.h"
 
 #ifdef CONFIG_BT_NIMBLE_HOST_TASK_PRIORITY
 # define NIMBLE_HOST_TASK_PRIORITY (CONFIG_BT_NIMBLE_HOST_TASK_PRIORITY)
@@ -40,6 +43,53 @@ UBaseType_t nimble_port_freertos_get_hs_hwm(void) {
 # define NIMBLE_HOST_TASK_PRIORITY (configMAX_PRIORITIES - 4)
 #endif
 
+#if NIMBLE_BLE_CONNECT && NIMBLE_BLE_SM && MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+#ifdef CONFIG_BT_NIMBLE_SM_PRECOMPUTE_STACK_SIZE
+# define NIMBLE_SM_PRE_STACK_SIZE (CONFIG_BT_NIMBLE_SM_PRECOMPUTE_STACK_SIZE)
+#else
+# define NIMBLE_SM_PRE_STACK_SIZE (3072)
+#endif
+
+/* Run on the core the host is not pinned to, if there is one. */
+#if portNUM_PROCESSORS > 1
+# define NIMBLE_SM_PRE_CORE (NIMBLE_CORE == tskNO_AFFINITY ? tskNO_AFFINITY : 1 - NIMBLE_CORE)
+#else
+# define NIMBLE_SM_PRE_CORE tskNO_AFFINITY
+#endif
+
+static TaskHandle_t sm_pre_task_h = NULL;
+static SemaphoreHandle_t sm_pre_exit = NULL;
+static volatile int sm_pre_stop;
+
+static void sm_pre_kick(void) {
+    if (!sm_pre_stop) {
+        xTaskNotifyGive(sm_pre_task_h);
+    }
+}
+
+/**
+ * @brief sm_pre_task - Keeps the pairing key pair and random pool topped up.
+ * @details Sleeps until pairing has consumed some of it, then refills it at
+ * idle priority so that it never delays the host task. Exits between fills
+ * when asked to stop, so it never dies holding host resources.
+ */
+static void sm_pre_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (sm_pre_stop) {
+            break;
+        }
+        ble_sm_pre_fill();
+    }
+
+    xSemaphoreGive(sm_pre_exit);
+    vTaskDelete(NULL);
+}
+#endif
+
 /**
  * @brief esp_nimble_enable - Initialize the NimBLE host
  *
@@ -48,6 +98,26 @@ UBaseType_t nimble_port_freertos_get_hs_hwm(void) {
  */
 esp_err_t esp_nimble_enable(void *host_task)
 {
+#if NIMBLE_BLE_CONNECT && NIMBLE_BLE_SM && MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+    /*
+    * Start the precompute task first so the kick sent when the host syncs
+    * is not lost.
+    */
+    if (sm_pre_exit == NULL) {
+        sm_pre_exit = xSemaphoreCreateBinary();
+    }
+
+    sm_pre_stop = 0;
+    if (sm_pre_exit != NULL &&
+        xTaskCreatePinnedToCore(sm_pre_task, "nimble_sm_pre", NIMBLE_SM_PRE_STACK_SIZE,
+                                NULL, tskIDLE_PRIORITY + 1, &sm_pre_task_h,
+                                NIMBLE_SM_PRE_CORE) == pdPASS) {
+        ble_sm_pre_set_kick_cb(sm_pre_kick);
+    } else {
+        sm_pre_task_h = NULL;
+    }
+#endif
+
     /*
     * Create task where NimBLE host will run. It is not strictly necessary to
     * have separate task for NimBLE host, but since something needs to handle
@@ -66,6 +136,17 @@ esp_err_t esp_nimble_enable(void *host_task)
  */
 esp_err_t esp_nimble_disable(void)
 {
+#if NIMBLE_BLE_CONNECT && NIMBLE_BLE_SM && MYNEWT_VAL(BLE_SM_PRECOMPUTE)
+    if (sm_pre_task_h) {
+        /* Let a fill in progress complete and the task exit on its own. */
+        ble_sm_pre_set_kick_cb(NULL);
+        sm_pre_stop = 1;
+        xTaskNotifyGive(sm_pre_task_h);
+        xSemaphoreTake(sm_pre_exit, portMAX_DELAY);
+        sm_pre_task_h = NULL;
+    }
+#endif
+
     if (host_task_h) {
         vTaskDelete(host_task_h);
         host_task_h = NULL;
@@ -45,6 +45,7 @@
 
 #ifdef ESP_PLATFORM
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "soc/soc_caps.h"
 
@@ -190,6 +191,169 @@ static os_membuf_t ble_freertos_mutex_buf[
 
 #endif
 
+/*
+ * Event queues are intrusive lists guarded by a spinlock. The semaphore is
+ * only given when a consumer is blocked, so a busy consumer drains a burst
+ * of events without a kernel call per event. Callout (timer) events go on
+ * the low priority list and are taken after the other events, but never
+ * more than NPL_FREERTOS_EVQ_HI_BURST high priority events in a row.
+ */
+#if MYNEWT_VAL(BLE_NPL_EVQ_BATCH_SIZE) > 0
+#define NPL_FREERTOS_EVQ_HI_BURST   MYNEWT_VAL(BLE_NPL_EVQ_BATCH_SIZE)
+#else
+#define NPL_FREERTOS_EVQ_HI_BURST   (8)
+#endif
+
+static inline bool in_isr(void);
+
+static inline uint32_t
+npl_freertos_evq_lock(struct ble_npl_eventq_freertos *eventq)
+{
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL_SAFE(&eventq->lock);
+    return 0;
+#else
+    if (in_isr()) {
+        return portSET_INTERRUPT_MASK_FROM_ISR();
+    }
+    portENTER_CRITICAL();
+    return 0;
+#endif
+}
+
+static inline void
+npl_freertos_evq_unlock(struct ble_npl_eventq_freertos *eventq, uint32_t ctx)
+{
+#ifdef ESP_PLATFORM
+    (void)ctx;
+    portEXIT_CRITICAL_SAFE(&eventq->lock);
+#else
+    if (in_isr()) {
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(ctx);
+    } else {
+        portEXIT_CRITICAL();
+    }
+#endif
+}
+
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+static inline uint32_t
+npl_freertos_evq_now_us(void)
+{
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_timer_get_time();
+#else
+    return xTaskGetTickCountFromISR() * portTICK_PERIOD_MS * 1000;
+#endif
+}
+#endif
+
+static inline struct ble_npl_event_freertos_list *
+npl_freertos_evq_list(struct ble_npl_eventq_freertos *eventq,
+                      struct ble_npl_event_freertos *event)
+{
+#if MYNEWT_VAL(BLE_NPL_EVQ_PRIORITY)
+    if (event->prio == BLE_NPL_EVENT_PRIO_LOW) {
+        return &eventq->lo;
+    }
+#endif
+    return &eventq->hi;
+}
+
+/* Called with the queue locked */
+static void
+npl_freertos_evq_unlink(struct ble_npl_eventq_freertos *eventq,
+                        struct ble_npl_event_freertos *event)
+{
+    TAILQ_REMOVE(npl_freertos_evq_list(eventq, event), event, link);
+    event->queued = false;
+    event->evq = NULL;
+    eventq->depth--;
+}
+
+/* Called with the queue locked */
+static struct ble_npl_event_freertos *
+npl_freertos_evq_pop(struct ble_npl_eventq_freertos *eventq)
+{
+    struct ble_npl_event_freertos *event;
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+    uint32_t latency;
+#endif
+
+    event = TAILQ_FIRST(&eventq->hi);
+#if MYNEWT_VAL(BLE_NPL_EVQ_PRIORITY)
+    if (!TAILQ_EMPTY(&eventq->lo)) {
+        if (!event || eventq->hi_burst >= NPL_FREERTOS_EVQ_HI_BURST) {
+            event = TAILQ_FIRST(&eventq->lo);
+            eventq->hi_burst = 0;
+        } else {
+            eventq->hi_burst++;
+        }
+    }
+#endif
+
+    if (event) {
+        npl_freertos_evq_unlink(eventq, event);
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+        latency = npl_freertos_evq_now_us() - event->enq_time;
+        eventq->taken++;
+        eventq->total_latency_us += latency;
+        if (latency > eventq->max_latency_us) {
+            eventq->max_latency_us = latency;
+        }
+#endif
+    }
+
+    return event;
+}
+
+/* Drops an event from whichever queue it is on */
+static void
+npl_freertos_event_dequeue(struct ble_npl_event_freertos *event)
+{
+    struct ble_npl_eventq_freertos *eventq = event->evq;
+    uint32_t ctx;
+
+    if (!eventq) {
+        return;
+    }
+
+    ctx = npl_freertos_evq_lock(eventq);
+    if (event->evq == eventq) {
+        npl_freertos_evq_unlink(eventq, event);
+    }
+    npl_freertos_evq_unlock(eventq, ctx);
+}
+
+/* Drops every event queued on the queue */
+static void
+npl_freertos_evq_flush(struct ble_npl_eventq_freertos *eventq)
+{
+    struct ble_npl_event_freertos *event;
+    uint32_t ctx;
+
+    ctx = npl_freertos_evq_lock(eventq);
+    while ((event = TAILQ_FIRST(&eventq->hi)) != NULL ||
+           (event = TAILQ_FIRST(&eventq->lo)) != NULL) {
+        npl_freertos_evq_unlink(eventq, event);
+    }
+    eventq->hi_burst = 0;
+    npl_freertos_evq_unlock(eventq, ctx);
+}
+
+static void
+npl_freertos_evq_setup(struct ble_npl_eventq_freertos *eventq)
+{
+    memset(eventq, 0, sizeof(*eventq));
+#ifdef ESP_PLATFORM
+    portMUX_INITIALIZE(&eventq->lock);
+#endif
+    TAILQ_INIT(&eventq->hi);
+    TAILQ_INIT(&eventq->lo);
+    eventq->sem = xSemaphoreCreateBinary();
+    BLE_LL_ASSERT(eventq->sem);
+}
+
 bool
 npl_freertos_os_started(void)
 {
@@ -210,10 +374,14 @@ npl_freertos_event_init(struct ble_npl_event *ev, ble_npl_event_fn *fn,
 #if OS_MEM_ALLOC
     if (!os_memblock_from(&ble_freertos_ev_pool,ev->event)) {
         ev->event = os_memblock_get(&ble_freertos_ev_pool);
+    } else {
+        npl_freertos_event_dequeue(ev->event);
     }
 #else
     if(!ev->event) {
         ev->event = malloc(sizeof(struct ble_npl_event_freertos));
+    } else {
+        npl_freertos_event_dequeue(ev->event);
     }
 #endif
     event = (struct ble_npl_event_freertos *)ev->event;
@@ -228,6 +396,7 @@ void
 npl_freertos_event_deinit(struct ble_npl_event *ev)
 {
     BLE_LL_ASSERT(ev->event);
+    npl_freertos_event_dequeue(ev->event);
 #if OS_MEM_ALLOC
     os_memblock_put(&ble_freertos_ev_pool,ev->event);
 #else
@@ -241,7 +410,17 @@ npl_freertos_event_reset(struct ble_npl_event *ev)
 {
     struct ble_npl_event_freertos *event = (struct ble_npl_event_freertos *)ev->event;
     BLE_LL_ASSERT(event);
-    event->queued = 0;
+    npl_freertos_event_dequeue(event);
+}
+
+/* Must not be called while the event is queued */
+void
+npl_freertos_event_set_prio(struct ble_npl_event *ev, uint8_t prio)
+{
+    struct ble_npl_event_freertos *event = (struct ble_npl_event_freertos *)ev->event;
+    BLE_LL_ASSERT(event);
+    BLE_LL_ASSERT(!event->queued);
+    event->prio = prio;
 }
 
 void
@@ -254,9 +433,7 @@ npl_freertos_eventq_init(struct ble_npl_eventq *evq)
         eventq = (struct ble_npl_eventq_freertos*)evq->eventq;
         BLE_LL_ASSERT(eventq);
 
-        memset(eventq, 0, sizeof(*eventq));
-        eventq->q = xQueueCreate(BLE_TOTAL_EV_COUNT, sizeof(struct ble_npl_eventq *));
-        BLE_LL_ASSERT(eventq->q);
+        npl_freertos_evq_setup(eventq);
     }
 #else
     if(!evq->eventq) {
@@ -264,16 +441,7 @@ npl_freertos_eventq_init(struct ble_npl_eventq *evq)
         eventq = (struct ble_npl_eventq_freertos*)evq->eventq;
         BLE_LL_ASSERT(eventq);
 
-        memset(eventq, 0, sizeof(*eventq));
-#if NIMBLE_CFG_CONTROLLER
-        eventq->q = xQueueCreate(evq == &g_ble_ll_data.ll_evq ?
-                                 NIMBLE_LL_QUEUE_SIZE :
-                                 NIMBLE_DEFAULT_QUEUE_SIZE,
-                                 sizeof(struct ble_npl_eventq *));
-#else
-        eventq->q = xQueueCreate(NIMBLE_DEFAULT_QUEUE_SIZE , sizeof(struct ble_npl_eventq *));
-#endif
-        BLE_LL_ASSERT(eventq->q);
+        npl_freertos_evq_setup(eventq);
     }
 #endif
 }
@@ -284,7 +452,8 @@ npl_freertos_eventq_deinit(struct ble_npl_eventq *evq)
     struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
 
     BLE_LL_ASSERT(eventq);
-    vQueueDelete(eventq->q);
+    npl_freertos_evq_flush(eventq);
+    vSemaphoreDelete(eventq->sem);
 #if OS_MEM_ALLOC
     os_memblock_put(&ble_freertos_evq_pool,eventq);
 #else
@@ -359,53 +528,88 @@ npl_freertos_hw_set_isr(int irqn, void (*addr)(void))
 struct ble_npl_event *
 npl_freertos_eventq_get(struct ble_npl_eventq *evq, ble_npl_time_t tmo)
 {
-    struct ble_npl_event *ev = NULL;
     struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
-    BaseType_t woken;
-    BaseType_t ret;
+    struct ble_npl_event_freertos *event;
+    TickType_t start = 0;
+    TickType_t waited;
+    uint32_t ctx;
 
     if (in_isr()) {
         BLE_LL_ASSERT(tmo == 0);
-        ret = xQueueReceiveFromISR(eventq->q, &ev, &woken);
-#ifdef ESP_PLATFORM
+    } else if (tmo != 0 && tmo != portMAX_DELAY) {
+        start = xTaskGetTickCount();
+    }
 
-        if( woken == pdTRUE ) {
-            portYIELD_FROM_ISR();
-        }
-#else
-        portYIELD_FROM_ISR(woken);
+    for (;;) {
+        ctx = npl_freertos_evq_lock(eventq);
+        event = npl_freertos_evq_pop(eventq);
+        if (!event && tmo != 0) {
+            eventq->waiting = true;
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+            eventq->waits++;
 #endif
-    } else {
-        ret = xQueueReceive(eventq->q, &ev, tmo);
-    }
-    BLE_LL_ASSERT(ret == pdPASS || ret == errQUEUE_EMPTY);
+        }
+        npl_freertos_evq_unlock(eventq, ctx);
 
-    if (ev) {
-	struct ble_npl_event_freertos *event = (struct ble_npl_event_freertos *)ev->event;
-	if (event) {
-            event->queued = false;
-	}
+        if (event || tmo == 0) {
+            break;
+        }
+
+        /* The semaphore may have been given for an event another consumer
+         * already took, so check the queue again after every wakeup.
+         */
+        if (tmo == portMAX_DELAY) {
+            xSemaphoreTake(eventq->sem, portMAX_DELAY);
+        } else {
+            waited = xTaskGetTickCount() - start;
+            if (waited >= tmo) {
+                break;
+            }
+            xSemaphoreTake(eventq->sem, tmo - waited);
+        }
     }
 
-    return ev;
+    return event ? event->ev : NULL;
 }
 
 void
 npl_freertos_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
 {
-    BaseType_t woken;
-    BaseType_t ret;
+    BaseType_t woken = pdFALSE;
     struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
     struct ble_npl_event_freertos *event = (struct ble_npl_event_freertos *)ev->event;
+    bool wake;
+    uint32_t ctx;
 
+    ctx = npl_freertos_evq_lock(eventq);
     if (event->queued) {
+        npl_freertos_evq_unlock(eventq, ctx);
         return;
     }
 
     event->queued = true;
+    event->ev = ev;
+    event->evq = eventq;
+    TAILQ_INSERT_TAIL(npl_freertos_evq_list(eventq, event), event, link);
+    eventq->depth++;
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+    event->enq_time = npl_freertos_evq_now_us();
+    eventq->posted++;
+    if (eventq->depth > eventq->max_depth) {
+        eventq->max_depth = eventq->depth;
+    }
+#endif
+
+    wake = eventq->waiting;
+    eventq->waiting = false;
+    npl_freertos_evq_unlock(eventq, ctx);
+
+    if (!wake) {
+        return;
+    }
 
     if (in_isr()) {
-        ret = xQueueSendToBackFromISR(eventq->q, &ev, &woken);
+        xSemaphoreGiveFromISR(eventq->sem, &woken);
 #ifdef ESP_PLATFORM
         if( woken == pdTRUE ) {
             portYIELD_FROM_ISR();
@@ -414,89 +618,74 @@ npl_freertos_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
         portYIELD_FROM_ISR(woken);
 #endif
     } else {
-        ret = xQueueSendToBack(eventq->q, &ev, portMAX_DELAY);
+        xSemaphoreGive(eventq->sem);
     }
-
-    BLE_LL_ASSERT(ret == pdPASS);
 }
 
 void
 npl_freertos_eventq_remove(struct ble_npl_eventq *evq,
                        struct ble_npl_event *ev)
 {
-    struct ble_npl_event *tmp_ev;
-    BaseType_t ret;
-    int i;
-    int count;
-    BaseType_t woken, woken2;
     struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
     struct ble_npl_event_freertos *event = (struct ble_npl_event_freertos *)ev->event;
+    uint32_t ctx;
 
-    if (!event->queued) {
-        return;
+    ctx = npl_freertos_evq_lock(eventq);
+    if (event->queued && event->evq == eventq) {
+        npl_freertos_evq_unlink(eventq, event);
     }
+    npl_freertos_evq_unlock(eventq, ctx);
+}
 
-    /*
-     * XXX We cannot extract element from inside FreeRTOS queue so as a quick
-     * workaround we'll just remove all elements and add them back except the
-     * one we need to remove. This is silly, but works for now - we probably
-     * better use counting semaphore with os_queue to handle this in future.
-     */
-
-    if (in_isr()) {
-        woken = pdFALSE;
-
-        count = uxQueueMessagesWaitingFromISR(eventq->q);
-        for (i = 0; i < count; i++) {
-            ret = xQueueReceiveFromISR(eventq->q, &tmp_ev, &woken2);
-            BLE_LL_ASSERT(ret == pdPASS);
-            woken |= woken2;
+ble_npl_error_t
+npl_freertos_eventq_stats(struct ble_npl_eventq *evq,
+                          struct ble_npl_eventq_stats *stats)
+{
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+    struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
+    uint32_t ctx;
 
-            if (tmp_ev == ev) {
-                continue;
-            }
+    if (!eventq || !stats) {
+        return BLE_NPL_INVALID_PARAM;
+    }
 
-            ret = xQueueSendToBackFromISR(eventq->q, &tmp_ev, &woken2);
-            BLE_LL_ASSERT(ret == pdPASS);
-            woken |= woken2;
-        }
+    ctx = npl_freertos_evq_lock(eventq);
+    stats->posted = eventq->posted;
+    stats->taken = eventq->taken;
+    stats->depth = eventq->depth;
+    stats->max_depth = eventq->max_depth;
+    stats->avg_latency_us = eventq->taken ?
+                            (uint32_t)(eventq->total_latency_us / eventq->taken) : 0;
+    stats->max_latency_us = eventq->max_latency_us;
+    stats->waits = eventq->waits;
+    npl_freertos_evq_unlock(eventq, ctx);
 
-#ifdef ESP_PLATFORM
-        if( woken == pdTRUE ) {
-            portYIELD_FROM_ISR();
-        }
-#else
-        portYIELD_FROM_ISR(woken);
-#endif
-    } else {
-#ifdef ESP_PLATFORM
-        portMUX_TYPE ble_npl_mut = portMUX_INITIALIZER_UNLOCKED;
-        portENTER_CRITICAL(&ble_npl_mut);
-
-        count = uxQueueMessagesWaiting(eventq->q);
+    return BLE_NPL_OK;
 #else
-        vPortEnterCritical();
-        count = uxQueueMessagesWaiting(eventq->q);
+    return BLE_NPL_ENOENT;
 #endif
-        for (i = 0; i < count; i++) {
-            ret = xQueueReceive(eventq->q, &tmp_ev, 0);
-            BLE_LL_ASSERT(ret == pdPASS);
+}
 
-            if (tmp_ev == ev) {
-                continue;
-            }
+void
+npl_freertos_eventq_stats_reset(struct ble_npl_eventq *evq)
+{
+#if MYNEWT_VAL(BLE_NPL_EVQ_STATS)
+    struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
+    uint32_t ctx;
 
-            ret = xQueueSendToBack(eventq->q, &tmp_ev, 0);
-            BLE_LL_ASSERT(ret == pdPASS);
-        }
-#ifdef ESP_PLATFORM
-        portEXIT_CRITICAL(&ble_npl_mut);
-#else
-        vPortExitCritical();
-#endif
+    if (!eventq) {
+        return;
     }
 
-    event->queued = 0;
+    ctx = npl_freertos_evq_lock(eventq);
+    eventq->posted = 0;
+    eventq->taken = 0;
+    eventq->max_depth = eventq->depth;
+    eventq->max_latency_us = 0;
+    eventq->total_latency_us = 0;
+    eventq->waits = 0;
+    npl_freertos_evq_unlock(eventq, ctx);
+#endif
 }
 
 ble_npl_error_t
@@ -569,7 +758,7 @@ bool
 npl_freertos_eventq_is_empty(struct ble_npl_eventq *evq)
 {
     struct ble_npl_eventq_freertos *eventq = (struct ble_npl_eventq_freertos *)evq->eventq;
-    return xQueueIsQueueEmptyFromISR(eventq->q);
+    return eventq->depth == 0;
 }
 
 bool
@@ -908,6 +1097,9 @@ npl_freertos_callout_init(struct ble_npl_callout *co, struct ble_npl_eventq *evq
 	ble_npl_event_init(&callout->ev, ev_cb, ev_arg);
     }
 #endif
+
+    /* Timer expiries are served after other pending events */
+    npl_freertos_event_set_prio(&callout->ev, BLE_NPL_EVENT_PRIO_LOW);
     return 0;
 }
 
@@ -1590,12 +1782,10 @@ na_npl_freertos_eventq_init(struct ble_npl_eventq *evq)
         evq->eventq = os_memblock_get(&ble_freertos_evq_pool);
         eventq = (struct ble_npl_eventq_freertos*)evq->eventq;
         BLE_LL_ASSERT(eventq);
-        memset(eventq, 0, sizeof(*eventq));
-        eventq->q = xQueueCreate(ble_freertos_total_event_cnt, sizeof(struct ble_npl_eventq *));
-        BLE_LL_ASSERT(eventq->q);
+        npl_freertos_evq_setup(eventq);
     } else {
         eventq = (struct ble_npl_eventq_freertos*)evq->eventq;
-        xQueueReset(eventq->q);
+        npl_freertos_evq_flush(eventq);
     }
 }
 
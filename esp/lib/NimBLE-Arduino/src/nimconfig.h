@@ -36,6 +36,13 @@
  */
 // #define CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH 20
 
+/** @brief Uncomment to set the number of bytes each attribute value can store internally\n
+ *  before it needs a heap allocation. Values up to this size are read and written without\n
+ *  touching the heap, at the cost of this many bytes in every value object.\n
+ *  Default value is 20. Range: 0 : 512 (BLE_ATT_ATTR_MAX_LEN)
+ */
+// #define CONFIG_NIMBLE_CPP_ATT_VALUE_INLINE_LENGTH 20
+
 
 /****************************************************
  *         Extended advertising settings            *
@@ -65,6 +72,19 @@
 /** @brief Un-comment to change the default MTU size */
 // #define CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU 255
 
+/** @brief Un-comment to open this many Enhanced ATT bearers on each encrypted connection\n
+ *  so GATT operations can run in parallel. The peer must support EATT as well.
+ */
+// #define CONFIG_BT_NIMBLE_EATT_CHAN_NUM 2
+
+/** @brief Un-comment to change the MTU of each Enhanced ATT bearer */
+// #define CONFIG_BT_NIMBLE_EATT_MTU 247
+
+/** @brief Un-comment to enable Encrypted Advertising Data, lets the scanner decrypt\n
+ *  the advertisements of devices whose key material is known.
+ */
+// #define CONFIG_BT_NIMBLE_ENC_ADV_DATA 1
+
 /** @brief Un-comment to change default device name */
 // #define CONFIG_BT_NIMBLE_SVC_GAP_DEVICE_NAME "nimble"
 
@@ -127,9 +147,35 @@
 /** @brief Un-comment to change the maximum number of CCCD subscriptions to store */
 // #define CONFIG_BT_NIMBLE_MAX_CCCDS 8
 
+/** @brief Un-comment to hold CCCD, client supported feature and encrypted advertising data (EAD) key \n
+ *  changes in RAM for this many milliseconds before writing them to NVS. A reset within that time \n
+ *  loses the held changes. Default is 0, every change is written immediately.
+ */
+// #define CONFIG_BT_NIMBLE_NVS_WRITE_BACK_MS 2000
+
 /** @brief Un-comment to change the random address refresh time (in seconds) */
 // #define CONFIG_BT_NIMBLE_RPA_TIMEOUT 900
 
+/** @brief Un-comment to change the number of recently seen peer private addresses remembered \n
+ *  with the bond they resolved to, or that they resolved to none. 0 disables the cache.
+ */
+// #define CONFIG_BT_NIMBLE_RPA_CACHE_SIZE 16
+
+/** @brief Un-comment to keep discovered peer attribute databases in NVS so reconnecting \n
+ *  clients can skip service discovery when the peer's Database Hash is unchanged.
+ */
+// #define CONFIG_BT_NIMBLE_GATT_CACHING 1
+
+/** @brief Un-comment to change the number of peers whose attribute database is kept in the GATT cache */
+// #define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CONNS 1
+
+/** @brief Un-comment to change the maximum number of services, characteristics and descriptors \n
+ *  cached per connection.
+ */
+// #define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_SVCS 24
+// #define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CHRS 64
+// #define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_DSCS 64
+
 /**
  * @brief Un-comment to change the number of MSYS buffers available.
  * @details MSYS is a system level mbuf registry. For prepare write & prepare \n
@@ -138,9 +184,46 @@
  */
 #define CONFIG_BT_NIMBLE_MSYS1_BLOCK_COUNT 50
 
+/**
+ * @brief Un-comment to give each CPU core a small cache of MSYS buffers.
+ * @details Buffers are then allocated and freed without taking the cross-core lock in most cases. \n
+ * Only used for MSYS pools with at least 4 * cache size * number of cores buffers.
+ */
+// #define CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE 1
+
+/** @brief Un-comment to change the number of buffers each core may cache */
+// #define CONFIG_BT_NIMBLE_MEMPOOL_PCPU_CACHE_SIZE 4
+
+/** @brief Un-comment to stop counting failed allocations per memory pool, saves 4 bytes per pool */
+// #define CONFIG_BT_NIMBLE_MEMPOOL_STATS 0
+
+/**
+ * @brief Un-comment to tag each mbuf with the address of the code that allocated it.
+ * @details Outstanding mbufs can then be listed with os_mbuf_trace_report() to find leaks. For debugging only.
+ */
+// #define CONFIG_BT_NIMBLE_MBUF_TRACE 1
+
+/** @brief Un-comment to change the number of outstanding mbufs the allocation trace can record */
+// #define CONFIG_BT_NIMBLE_MBUF_TRACE_MAX 64
+
 /** @brief Un-comment to use external PSRAM for the NimBLE host */
 // #define CONFIG_BT_NIMBLE_MEM_ALLOC_MODE_EXTERNAL 1
 
+/**
+ * @brief Un-comment to change the number of events the host task runs per wakeup before yielding.
+ * @details 0 runs every queued event before yielding.
+ */
+// #define CONFIG_BT_NIMBLE_EVQ_BATCH_SIZE 8
+
+/** @brief Un-comment to run timer events strictly in the order queued instead of after other pending events */
+// #define CONFIG_BT_NIMBLE_EVQ_PRIORITY 0
+
+/**
+ * @brief Un-comment to count events and measure how long they wait on each event queue.
+ * @details The counts are read with npl_freertos_eventq_stats().
+ */
+// #define CONFIG_BT_NIMBLE_EVQ_STATS 1
+
 /** @brief Un-comment to change the core NimBLE host runs on */
 // #define CONFIG_BT_NIMBLE_PINNED_TO_CORE 0
 
@@ -176,6 +259,32 @@
  */
 // #define CONFIG_BT_NIMBLE_CRYPTO_STACK_MBEDTLS 1
 
+/**
+ * @brief Un-comment to change the number of expanded AES keys kept for pairing and private address resolution.
+ * @details Set this to at least the number of bonds so every bonded IRK stays cached, 0 disables the cache.
+ */
+// #define CONFIG_BT_NIMBLE_AES_KEY_CACHE_SIZE 4
+
+/**
+ * @brief Un-comment to use the compact tinycrypt AES rounds instead of the 1k lookup table.
+ * @details The table based rounds are several times faster, this saves 1k of flash. Not used with mbedtls.
+ */
+// #define CONFIG_BT_NIMBLE_CRYPTO_AES_TTABLE 0
+
+/**
+ * @brief Un-comment to use the tinycrypt Montgomery ladder for P-256 instead of the comb method.
+ * @details The comb makes pairing key generation and DH key computation faster, this saves about 3k of flash.
+ * Not used with mbedtls.
+ */
+// #define CONFIG_BT_NIMBLE_CRYPTO_ECC_COMB 0
+
+/**
+ * @brief Un-comment to generate pairing key pairs and random values ahead of time on a background task.
+ * @details The task runs at low priority on the core the host is not pinned to, so pairing does not wait on them.
+ * Uses a task with CONFIG_BT_NIMBLE_SM_PRECOMPUTE_STACK_SIZE bytes of stack (default 3072).
+ */
+// #define CONFIG_BT_NIMBLE_SM_PRECOMPUTE 1
+
 /**********************************
  End Arduino user-config
 **********************************/
@@ -255,6 +364,24 @@
 #define CONFIG_NIMBLE_STACK_USE_MEM_POOLS 0
 #endif
 
+#if CONFIG_BT_NIMBLE_GATT_CACHING
+#ifndef CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CONNS
+#define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CONNS 1
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_GATT_CACHING_MAX_SVCS
+#define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_SVCS 24
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CHRS
+#define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_CHRS 64
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_GATT_CACHING_MAX_DSCS
+#define CONFIG_BT_NIMBLE_GATT_CACHING_MAX_DSCS 64
+#endif
+#endif
+
 /** @brief Maximum number of connection oriented channels */
 #ifndef CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM
 #define CONFIG_BT_NIMBLE_L2CAP_COC_MAX_NUM 0
@@ -292,7 +419,9 @@
 #define CONFIG_BT_NIMBLE_TRANSPORT_EVT_DISCARD_COUNT 8
 
 #define CONFIG_BT_NIMBLE_L2CAP_COC_SDU_BUFF_COUNT 1
+#ifndef CONFIG_BT_NIMBLE_EATT_CHAN_NUM
 #define CONFIG_BT_NIMBLE_EATT_CHAN_NUM 0
+#endif
 #define CONFIG_BT_NIMBLE_SVC_GAP_CENT_ADDR_RESOLUTION -1
 #define CONFIG_BT_NIMBLE_GATT_MAX_PROCS 4
 #define CONFIG_BT_NIMBLE_HS_STOP_TIMEOUT_MS 2000
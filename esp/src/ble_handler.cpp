@@ -8,10 +8,6 @@ NimBLEL2CAPChannel *active_l2cap_channel = nullptr;
 
 void GATTCallbacks::onConnect(NimBLEServer *pServer, NimBLEConnInfo &info) {
   LOG_PRINTLN("[INFO]  GATT connected");
-
-  // these are optimal settings for iOS L2CAP for maximum throughput
-  pServer->setDataLen(info.getConnHandle(), 251);
-  NimBLEDevice::getServer()->updateConnParams(info.getConnHandle(), 12, 12, 0, 200);
 }
 
 void GATTCallbacks::onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &info) {
@@ -139,6 +135,18 @@ void ble_system_init() {
   NimBLEDevice::init("Glimpse Glass");
   NimBLEDevice::setMTU(BLE_ATT_MTU_MAX);
 
+  // 15 ms interval (optimal for iOS L2CAP) only while images/audio are moving, relaxed when idle.
+  // PHY and data length are left to the link optimizer below.
+  NimBLEConnGovernor::setParams(NimBLEConnGovernor::BULK, {12, 12, 0, 200, 0, 0});
+  NimBLEConnGovernor::start();
+
+  // request 2M PHY and maximum data length on every connection and report what the phone agreed to
+  NimBLELinkOptimizer::setCallback([](uint16_t conn_handle, const NimBLELinkOptimizer::LinkInfo &link) {
+    LOG_PRINTF("[INFO]  Link %u: PHY %u/%u, data length %u/%u, ~%u B/s\n", conn_handle, link.txPhy, link.rxPhy,
+               link.txOctets, link.rxOctets, (unsigned)link.estimatedBps);
+  });
+  NimBLELinkOptimizer::enable(true);
+
   auto cocServer = NimBLEDevice::createL2CAPServer();
   l2cap_callbacks = new L2CAPChannelCallbacks();
 